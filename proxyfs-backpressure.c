@@ -0,0 +1,101 @@
+// File		:proxyfs-backpressure.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 16:41:18 2026
+#include <linux/seq_file.h>
+#include "proxyfs.h"
+
+static const char *const proxyfs_backpressure_policy_names[PROXYFS_BACKPRESSURE_POLICY_COUNT] = {
+    [PROXYFS_BACKPRESSURE_DROP_NEWEST] = "drop_newest",
+    [PROXYFS_BACKPRESSURE_DROP_OLDEST] = "drop_oldest",
+    [PROXYFS_BACKPRESSURE_BLOCK] = "block",
+    [PROXYFS_BACKPRESSURE_SAMPLE] = "sample",
+};
+
+static const char *const proxyfs_drop_reason_names[PROXYFS_DROP_REASON_COUNT] = {
+    [PROXYFS_DROP_POOL] = "pool",
+    [PROXYFS_DROP_QUEUE] = "queue",
+    [PROXYFS_DROP_TIMEOUT] = "timeout",
+    [PROXYFS_DROP_SAMPLED] = "sampled",
+};
+
+void proxyfs_backpressure_init(struct proxyfs_backpressure *bp)
+{
+    int i;
+
+    bp->policy = PROXYFS_BACKPRESSURE_DROP_NEWEST;
+    bp->timeout_us = PROXYFS_BACKPRESSURE_TIMEOUT_US;
+    bp->sample_rate = PROXYFS_BACKPRESSURE_SAMPLE_RATE;
+    atomic_set(&bp->sample_counter, 0);
+    for (i = 0; i < PROXYFS_DROP_REASON_COUNT; i++) {
+        atomic_long_set(&bp->drops[i], 0);
+    }
+    atomic_long_set(&bp->lost, 0);
+}
+
+//
+// Policy of the name, -EINVAL is returned if the name is unknown
+int proxyfs_backpressure_parse_policy(const char *name)
+{
+    int i;
+
+    for (i = 0; i < PROXYFS_BACKPRESSURE_POLICY_COUNT; i++) {
+        if (strcmp(name, proxyfs_backpressure_policy_names[i]) == 0) {
+            return i;
+        }
+    }
+    return -EINVAL;
+}
+
+//
+// Check if the event should be formatted: with the sampling policy just
+// every `sample_rate`-th event passes while the pipeline is saturated
+bool proxyfs_backpressure_admit(struct proxyfs_backpressure *bp)
+{
+    if (bp->policy != PROXYFS_BACKPRESSURE_SAMPLE ||
+        proxyfs_queue_pressure() < PROXYFS_BACKPRESSURE_SAMPLE_WATERMARK) {
+        return true;
+    }
+    if (bp->sample_rate <= 1 ||
+        atomic_inc_return(&bp->sample_counter) % bp->sample_rate == 0) {
+        return true;
+    }
+    proxyfs_backpressure_drop(bp, PROXYFS_DROP_SAMPLED);
+    return false;
+}
+
+//
+// Account the event dropped, consumers are informed about it by a
+// "lost" marker sent ahead of the next event of the mount
+void proxyfs_backpressure_drop(struct proxyfs_backpressure *bp,
+                               enum proxyfs_drop_reason reason)
+{
+    atomic_long_inc(&bp->drops[reason]);
+    atomic_long_inc(&bp->lost);
+}
+
+void proxyfs_backpressure_show_options(struct seq_file *m,
+                                       const struct proxyfs_backpressure *bp)
+{
+    seq_printf(m, ",backpressure=%s",
+               proxyfs_backpressure_policy_names[bp->policy]);
+    if (bp->policy == PROXYFS_BACKPRESSURE_BLOCK) {
+        seq_printf(m, ",backpressure_timeout_us=%u", bp->timeout_us);
+    } else if (bp->policy == PROXYFS_BACKPRESSURE_SAMPLE) {
+        seq_printf(m, ",sample_rate=%u", bp->sample_rate);
+    }
+}
+
+void proxyfs_backpressure_show_stats(struct seq_file *m,
+                                     const struct proxyfs_backpressure *bp)
+{
+    int i;
+
+    seq_printf(m, "backpressure=%s drops:",
+               proxyfs_backpressure_policy_names[bp->policy]);
+    for (i = 0; i < PROXYFS_DROP_REASON_COUNT; i++) {
+        seq_printf(m, " %s=%ld",
+                   proxyfs_drop_reason_names[i],
+                   atomic_long_read(&bp->drops[i]));
+    }
+    seq_printf(m, " unreported=%ld\n", atomic_long_read(&bp->lost));
+}
@@ -0,0 +1,137 @@
+// File		:proxyfs-bpf.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 23:41:12 2026
+#include <linux/filter.h>
+#include <linux/skbuff.h>
+#include <linux/percpu.h>
+#include <linux/mutex.h>
+#include "proxyfs.h"
+
+//
+// Classic BPF program of the client runs over a socket buffer holding the
+// event header with its fields in network byte order (as if it was a
+// packet), thus the program is checked and run the way `sk_filter` ones
+// are and loads the fields as packet ones
+//
+// Note: every CPU has its own buffer (the program is run with preemption
+//       disabled), the buffers are allocated by the first attach
+static DEFINE_PER_CPU(struct sk_buff *, proxyfs_bpf_skbs);
+static DEFINE_MUTEX(proxyfs_bpf_lock);
+static bool proxyfs_bpf_ready;
+
+static int proxyfs_bpf_prepare(void)
+{
+    struct sk_buff *skb;
+    int res = 0;
+    int cpu;
+
+    mutex_lock(&proxyfs_bpf_lock);
+    for_each_possible_cpu(cpu) {
+        if (proxyfs_bpf_ready || per_cpu(proxyfs_bpf_skbs, cpu) != NULL) {
+            continue;
+        }
+        if ((skb = alloc_skb(sizeof(struct proxyfs_event_header), GFP_KERNEL)) == NULL) {
+            res = -ENOMEM;
+            break;
+        }
+        skb_put_zero(skb, sizeof(struct proxyfs_event_header));
+        per_cpu(proxyfs_bpf_skbs, cpu) = skb;
+    }
+    if (res == 0) {
+        proxyfs_bpf_ready = true;
+    }
+    mutex_unlock(&proxyfs_bpf_lock);
+    return res;
+}
+
+//
+// Check the program of `len` instructions and prepare it to be run over
+// the events, negative errno is returned if the program is invalid
+int proxyfs_bpf_create(struct bpf_prog **prog,
+                       const struct sock_filter *insns,
+                       unsigned int len)
+{
+    struct sock_fprog_kern fprog = {
+        .len = len,
+        .filter = (struct sock_filter *)insns,
+    };
+    int res;
+
+    if (len == 0 || len > BPF_MAXINSNS) {
+        return -EINVAL;
+    }
+    if ((res = proxyfs_bpf_prepare()) != 0) {
+        return res;
+    }
+    return bpf_prog_create(prog, &fprog);
+}
+
+void proxyfs_bpf_destroy(struct bpf_prog *prog)
+{
+    if (prog != NULL) {
+        bpf_prog_destroy(prog);
+    }
+}
+
+//
+// Run the program of the client over the header of the event message,
+// true is returned if the event is accepted (or there is no program);
+// control records (e.g. LOST markers, which are sent to the group of the
+// event they precede) and the permission requests are always accepted
+//
+// Note: must be called under `proxyfs_context_client_read_lock()`, the
+//       message is sent to the client only, thus the program has no
+//       effect on the other consumers
+//
+// Note: the program runs when the message is sent rather than before the
+//       event is queued, thus a rejected event still costs its rendering,
+//       a buffer of the pool and the worker hop; the other consumers get
+//       the event anyway and the program sees its real sequence number
+bool proxyfs_bpf_filter(struct proxyfs_client *client,
+                        const char *msg_body,
+                        size_t msg_len)
+{
+    const struct proxyfs_event_header *header = (const struct proxyfs_event_header *)msg_body;
+    struct proxyfs_event_header *data;
+    struct sk_buff *skb;
+    enum proxyfs_event_class class;
+    bool res;
+
+    if (client->prog == NULL || msg_len < sizeof(struct proxyfs_event_header)) {
+        return true;
+    }
+    class = proxyfs_event_op_class(header->op);
+    if (class == PROXYFS_EVENT_CLASS_CONTROL || class == PROXYFS_EVENT_CLASS_PERMISSION) {
+        return true;
+    }
+    skb = get_cpu_var(proxyfs_bpf_skbs);
+    data = (struct proxyfs_event_header *)skb->data;
+    data->version = header->version;
+    data->flags = header->flags;
+    data->op = (__force __u16)cpu_to_be16(header->op);
+    data->size = (__force __u32)cpu_to_be32(header->size);
+    data->seq = (__force __u64)cpu_to_be64(header->seq);
+    data->timestamp = (__force __u64)cpu_to_be64(header->timestamp);
+    data->ino = (__force __u64)cpu_to_be64(header->ino);
+    data->dev = (__force __u32)cpu_to_be32(header->dev);
+    data->pid = (__force __u32)cpu_to_be32(header->pid);
+    data->tgid = (__force __u32)cpu_to_be32(header->tgid);
+    data->uid = (__force __u32)cpu_to_be32(header->uid);
+    res = bpf_prog_run(client->prog, skb) != 0;
+    put_cpu_var(proxyfs_bpf_skbs);
+    atomic_long_inc(res ? &client->accepted : &client->rejected);
+    return res;
+}
+
+void proxyfs_bpf_release(void)
+{
+    int cpu;
+
+    mutex_lock(&proxyfs_bpf_lock);
+    for_each_possible_cpu(cpu) {
+        kfree_skb(per_cpu(proxyfs_bpf_skbs, cpu));
+        per_cpu(proxyfs_bpf_skbs, cpu) = NULL;
+    }
+    proxyfs_bpf_ready = false;
+    mutex_unlock(&proxyfs_bpf_lock);
+}
@@ -1,90 +1,740 @@
 // File		:proxyfs-buffer-pool.c
 // Author	:Victor Kovalevich
 // Created	:Fri Jul 11 01:27:18 2025
+#include <linux/vmalloc.h>
+#include <linux/overflow.h>
+#include <linux/cache.h>
+#include <linux/slab.h>
+#include <linux/smp.h>
+#include <linux/timekeeping.h>
 #include "proxyfs.h"
 
-bool proxyfs_buffer_pool_init(struct proxyfs_buffer_pool *buffer_pool,
-                              unsigned int count,
-                              unsigned int size)
+#define PROXYFS_BUFFER_POOL_HEAD(tag, index) \
+    ((s64)(((u64)(tag) << 32) | (u32)(index)))
+#define PROXYFS_BUFFER_POOL_HEAD_TAG(head)   ((u32)((u64)(head) >> 32))
+#define PROXYFS_BUFFER_POOL_HEAD_INDEX(head) ((u32)(head))
+
+inline static void *proxyfs_buffer_segment_buffer(struct proxyfs_buffer_segment *segment,
+                                                  u32 index)
+{
+    return (char *)segment->arena + (size_t)index * segment->stride;
+}
+
+//
+// Get index of the buffer by its address, `PROXYFS_BUFFER_POOL_NIL` is
+// returned if the buffer does not belong to the segment
+inline static u32 proxyfs_buffer_segment_index(struct proxyfs_buffer_segment *segment,
+                                               void *buffer)
+{
+    size_t offset;
+
+    if ((char *)buffer < (char *)segment->arena) {
+        return PROXYFS_BUFFER_POOL_NIL;
+    }
+    offset = (char *)buffer - (char *)segment->arena;
+    if (offset >= (size_t)segment->count * segment->stride ||
+        offset % segment->stride != 0) {
+        return PROXYFS_BUFFER_POOL_NIL;
+    }
+    return (u32)(offset / segment->stride);
+}
+
+inline static u32 *proxyfs_buffer_segment_link(struct proxyfs_buffer_segment *segment,
+                                               u32 index)
+{
+    return (u32 *)proxyfs_buffer_segment_buffer(segment, index);
+}
+
+//
+// Pop a free buffer from the segment stack, `PROXYFS_BUFFER_POOL_NIL` is
+// returned if the stack is empty
+static u32 proxyfs_buffer_segment_pop(struct proxyfs_buffer_segment *segment)
+{
+    s64 head = atomic64_read(&segment->free_head);
+    s64 next;
+    u32 index;
+
+    do {
+        if ((index = PROXYFS_BUFFER_POOL_HEAD_INDEX(head)) == PROXYFS_BUFFER_POOL_NIL) {
+            break;
+        }
+        //
+        // Note: the link can be overwritten by a concurrent owner of the
+        //       buffer, in such a case the tag has been changed as well
+        //       and the exchange below fails
+        next = PROXYFS_BUFFER_POOL_HEAD(PROXYFS_BUFFER_POOL_HEAD_TAG(head) + 1,
+                                        READ_ONCE(*proxyfs_buffer_segment_link(segment, index)));
+    } while (!atomic64_try_cmpxchg(&segment->free_head, &head, next));
+
+    return index;
+}
+
+//
+// Push a chain of free buffers linked from `first` to `last` to the
+// segment stack by a single update of its head
+static void proxyfs_buffer_segment_push(struct proxyfs_buffer_segment *segment,
+                                        u32 first,
+                                        u32 last)
+{
+    s64 head = atomic64_read(&segment->free_head);
+    s64 next;
+
+    do {
+        WRITE_ONCE(*proxyfs_buffer_segment_link(segment, last),
+                   PROXYFS_BUFFER_POOL_HEAD_INDEX(head));
+        next = PROXYFS_BUFFER_POOL_HEAD(PROXYFS_BUFFER_POOL_HEAD_TAG(head) + 1, first);
+    } while (!atomic64_try_cmpxchg(&segment->free_head, &head, next));
+}
+
+//
+// Count free buffers of the segment
+// Note: valid just for a segment nobody allocates from, its stack can
+//       only grow on top then, thus the walk below is safe
+static unsigned int proxyfs_buffer_segment_free_count(struct proxyfs_buffer_segment *segment)
+{
+    u32 index = PROXYFS_BUFFER_POOL_HEAD_INDEX(atomic64_read(&segment->free_head));
+    unsigned int free_count = 0;
+
+    while (index != PROXYFS_BUFFER_POOL_NIL && free_count < segment->count) {
+        index = READ_ONCE(*proxyfs_buffer_segment_link(segment, index));
+        free_count++;
+    }
+    return free_count;
+}
+
+static struct proxyfs_buffer_segment *proxyfs_buffer_segment_create(unsigned int count,
+                                                                    unsigned int stride)
+{
+    struct proxyfs_buffer_segment *segment;
+    u32 i;
+
+    if ((segment = kzalloc(sizeof(*segment), GFP_KERNEL)) == NULL) {
+        return NULL;
+    }
+    if ((segment->arena = vmalloc(array_size(count, stride))) == NULL) {
+        pr_err("%s: unable to allocate memory segement for memory buffer pool",
+               MODULE_NAME);
+        kfree(segment);
+        return NULL;
+    }
+    segment->count = count;
+    segment->stride = stride;
+    //
+    // Initially every buffer refers to the next one
+    for (i = 0; i < count; i++) {
+        *proxyfs_buffer_segment_link(segment, i) = (i + 1 < count) ? i + 1 : PROXYFS_BUFFER_POOL_NIL;
+    }
+    atomic64_set(&segment->free_head, PROXYFS_BUFFER_POOL_HEAD(0, 0));
+    return segment;
+}
+
+static void proxyfs_buffer_segment_destroy(struct proxyfs_buffer_segment *segment)
+{
+    if (segment == NULL) {
+        return;
+    }
+    vfree(segment->arena);
+    kfree(segment);
+}
+
+//
+// Find the segment holding the buffer, `*segment_index` and `*index` are
+// set to index of the segment and index of the buffer within the segment
+// Note: must be called under RCU read lock
+static struct proxyfs_buffer_segment *proxyfs_buffer_class_lookup(struct proxyfs_buffer_class *buffer_class,
+                                                                  void *buffer,
+                                                                  unsigned int *segment_index,
+                                                                  u32 *index)
+{
+    unsigned int segment_number = smp_load_acquire(&buffer_class->segment_number);
+    unsigned int s;
+
+    for (s = 0; s < segment_number; s++) {
+        struct proxyfs_buffer_segment *segment = rcu_dereference(buffer_class->segments[s]);
+        if (segment != NULL &&
+            (*index = proxyfs_buffer_segment_index(segment, buffer)) != PROXYFS_BUFFER_POOL_NIL) {
+            *segment_index = s;
+            return segment;
+        }
+    }
+    return NULL;
+}
+
+//
+// Move up to `magazine_batch` free buffers from the
+// active segments of the class to the magazine
+// Note: must be called with local interrupts disabled and under RCU read lock
+static void proxyfs_buffer_class_refill(struct proxyfs_buffer_class *buffer_class,
+                                        struct proxyfs_buffer_magazine *magazine)
+{
+    unsigned int active_number = smp_load_acquire(&buffer_class->active_number);
+    unsigned int s;
+    u32 index;
+
+    for (s = 0; s < active_number && magazine->count < buffer_class->magazine_batch; s++) {
+        struct proxyfs_buffer_segment *segment = rcu_dereference(buffer_class->segments[s]);
+        if (segment == NULL) {
+            continue;
+        }
+        while (magazine->count < buffer_class->magazine_batch) {
+            if ((index = proxyfs_buffer_segment_pop(segment)) == PROXYFS_BUFFER_POOL_NIL) {
+                break;
+            }
+            magazine->buffers[magazine->count++] = proxyfs_buffer_segment_buffer(segment, index);
+        }
+    }
+}
+
+//
+// Return `magazine_batch` buffers from the top of
+// the magazine to their segments
+// Note: must be called with local interrupts disabled and under RCU read lock
+static void proxyfs_buffer_class_spill(struct proxyfs_buffer_class *buffer_class,
+                                       struct proxyfs_buffer_magazine *magazine)
+{
+    struct proxyfs_buffer_segment *segments[PROXYFS_BUFFER_CLASS_SEGMENTS] = {};
+    u32 first[PROXYFS_BUFFER_CLASS_SEGMENTS];
+    u32 last[PROXYFS_BUFFER_CLASS_SEGMENTS];
+    unsigned int n;
+    unsigned int s;
+    u32 index;
+
+    //
+    // Link the buffers of every segment to a chain first, thus each chain
+    // is published to the segment stack at once
+    for (n = 0; n < buffer_class->magazine_batch && magazine->count > 0; n++) {
+        void *buffer = magazine->buffers[--magazine->count];
+        struct proxyfs_buffer_segment *segment = proxyfs_buffer_class_lookup(buffer_class,
+                                                                             buffer,
+                                                                             &s,
+                                                                             &index);
+        if (segment == NULL) {
+            continue;
+        }
+        if (segments[s] == NULL) {
+            segments[s] = segment;
+            last[s] = index;
+        } else {
+            *proxyfs_buffer_segment_link(segment, index) = first[s];
+        }
+        first[s] = index;
+    }
+    for (s = 0; s < PROXYFS_BUFFER_CLASS_SEGMENTS; s++) {
+        if (segments[s] != NULL) {
+            proxyfs_buffer_segment_push(segments[s], first[s], last[s]);
+        }
+    }
+}
+
+//
+// Allocate a buffer from the class, `*refilled` is set if the local
+// magazine has been refilled from the segments on the way
+static void *proxyfs_buffer_class_alloc(struct proxyfs_buffer_class *buffer_class,
+                                        bool *refilled)
 {
-    if (buffer_pool == NULL || count == 0 || size == 0) {
+    unsigned long flags;
+    struct proxyfs_buffer_magazine *magazine;
+    void *buffer = NULL;
+
+    local_irq_save(flags);
+    rcu_read_lock();
+    magazine = this_cpu_ptr(buffer_class->magazines);
+    if (magazine->count == 0) {
+        proxyfs_buffer_class_refill(buffer_class, magazine);
+        *refilled = true;
+    }
+    if (magazine->count > 0) {
+        buffer = magazine->buffers[--magazine->count];
+        this_cpu_inc(*buffer_class->in_use);
+    }
+    rcu_read_unlock();
+    local_irq_restore(flags);
+
+    return buffer;
+}
+
+//
+// Release the buffer to the class, false is returned if the buffer
+// does not belong to the class
+static bool proxyfs_buffer_class_free(struct proxyfs_buffer_class *buffer_class,
+                                      void *buffer)
+{
+    unsigned long flags;
+    struct proxyfs_buffer_magazine *magazine;
+    struct proxyfs_buffer_segment *segment;
+    unsigned int s;
+    u32 index;
+
+    local_irq_save(flags);
+    rcu_read_lock();
+    if ((segment = proxyfs_buffer_class_lookup(buffer_class, buffer, &s, &index)) != NULL) {
+        if (s >= smp_load_acquire(&buffer_class->active_number) ||
+            buffer_class->magazine_size == 0) {
+            //
+            // The segment is retiring (or the class bypasses magazines),
+            // keep its buffers away from magazines
+            proxyfs_buffer_segment_push(segment, index, index);
+        } else {
+            magazine = this_cpu_ptr(buffer_class->magazines);
+            if (magazine->count >= buffer_class->magazine_size) {
+                proxyfs_buffer_class_spill(buffer_class, magazine);
+            }
+            magazine->buffers[magazine->count++] = buffer;
+        }
+        this_cpu_dec(*buffer_class->in_use);
+    }
+    rcu_read_unlock();
+    local_irq_restore(flags);
+
+    return segment != NULL;
+}
+
+int proxyfs_buffer_class_in_use(struct proxyfs_buffer_class *buffer_class)
+{
+    int in_use = 0;
+    int cpu;
+
+    if (buffer_class == NULL || buffer_class->in_use == NULL) {
+        return 0;
+    }
+    for_each_possible_cpu(cpu) {
+        in_use += *per_cpu_ptr(buffer_class->in_use, cpu);
+    }
+    return in_use;
+}
+
+unsigned int proxyfs_buffer_class_capacity(struct proxyfs_buffer_class *buffer_class)
+{
+    if (buffer_class == NULL) {
+        return 0;
+    }
+    return smp_load_acquire(&buffer_class->segment_number) * buffer_class->segment_size;
+}
+
+static bool proxyfs_buffer_class_init(struct proxyfs_buffer_class *buffer_class,
+                                      unsigned int count,
+                                      unsigned int size)
+{
+    if (buffer_class == NULL || count == 0 || size == 0 ||
+        count >= PROXYFS_BUFFER_POOL_NIL) {
         return false;
     }
 
-    unsigned int i;
-    void** bufs = NULL;
-    unsigned long* bitmap = NULL;
+    unsigned int stride = ALIGN(max_t(unsigned int, size, sizeof(u32)), SMP_CACHE_BYTES);
+    //
+    // Note: magazines of all CPUs hold at most half of the initial
+    //       segment, otherwise buffers cached by idle CPUs could exhaust
+    //       the class for the busy ones
+    unsigned int magazine_size = min_t(unsigned int,
+                                       PROXYFS_BUFFER_POOL_MAGAZINE_SIZE,
+                                       count / 2 / nr_cpu_ids);
+    struct proxyfs_buffer_segment *segment = NULL;
+    struct proxyfs_buffer_magazine __percpu *magazines = NULL;
+    int __percpu *in_use = NULL;
     bool init_res = false;
 
     do {
-        if ((bufs = kcalloc(count, sizeof(void *), GFP_KERNEL)) == NULL) {
-            pr_err("%s: unable to allocate memory segement for memory buffer pool",
-                   MODULE_NAME);
+        if ((segment = proxyfs_buffer_segment_create(count, stride)) == NULL) {
             break;
         }
-        if ((bitmap = kcalloc(BITS_TO_LONGS(count), sizeof(unsigned long), GFP_KERNEL)) == NULL) {
-            pr_err("%s: unable to allocate bitmap structure for memory buffer pool",
+        if ((magazines = alloc_percpu(struct proxyfs_buffer_magazine)) == NULL) {
+            pr_err("%s: unable to allocate per-CPU magazines for memory buffer pool",
                    MODULE_NAME);
             break;
         }
-        for (i = 0; i < count; i++) {
-            if ((bufs[i] = kmalloc(size, GFP_KERNEL)) == NULL) {
-                pr_err("%s: unable to allocate %d buffer for memory buffer pool",
-                       MODULE_NAME,
-                       i);
-                break;
-            }
-        }
-        if (i < count) {
+        if ((in_use = alloc_percpu(int)) == NULL) {
+            pr_err("%s: unable to allocate per-CPU counters for memory buffer pool",
+                   MODULE_NAME);
             break;
         }
         init_res = true;
     } while (false);
 
     if (init_res == true) {
-        buffer_pool->buffers = bufs;
-        buffer_pool->bitmap = bitmap;
-        buffer_pool->size = size;
-        buffer_pool->count = count;
-        bitmap_zero(buffer_pool->bitmap, count);
-        spin_lock_init(&buffer_pool->lock);
-        atomic_set(&buffer_pool->in_use, 0);
-        pr_info("%s: memory buffer pool with %u buffers %u bytes length is ready for use",
+        memset(buffer_class->segments, 0, sizeof(buffer_class->segments));
+        RCU_INIT_POINTER(buffer_class->segments[0], segment);
+        buffer_class->segment_number = 1;
+        buffer_class->active_number = 1;
+        buffer_class->size = size;
+        buffer_class->stride = stride;
+        buffer_class->segment_size = count;
+        buffer_class->magazine_size = magazine_size;
+        //
+        // Note: a class bypassing magazines still moves a single buffer
+        //       through the magazine on allocation
+        buffer_class->magazine_batch = max(magazine_size / 2, 1U);
+        buffer_class->magazines = magazines;
+        buffer_class->in_use = in_use;
+        buffer_class->peak = 0;
+        atomic_long_set(&buffer_class->fallbacks, 0);
+        atomic_long_set(&buffer_class->failures, 0);
+        pr_info("%s: memory buffer pool class with %u buffers %u bytes length is ready for use (%u buffers per CPU)",
                 MODULE_NAME,
-                buffer_pool->count,
-                buffer_pool->size);
+                count,
+                size,
+                magazine_size);
         return true;
     }
-    while (i--) {
-        kfree(bufs[i]);
+    if (in_use) {
+        free_percpu(in_use);
     }
-    if (bitmap) {
-        kfree(bitmap);
-    }
-    if (bufs) {
-        kfree(bufs);
+    if (magazines) {
+        free_percpu(magazines);
     }
+    proxyfs_buffer_segment_destroy(segment);
     return false;
 }
 
-void proxyfs_buffer_pool_destroy(struct proxyfs_buffer_pool *buffer_pool)
+static void proxyfs_buffer_class_destroy(struct proxyfs_buffer_class *buffer_class)
 {
+    unsigned int s;
+
+    if (!buffer_class || !buffer_class->magazines) {
+        return;
+    }
+    for (s = 0; s < buffer_class->segment_number; s++) {
+        proxyfs_buffer_segment_destroy(rcu_dereference_protected(buffer_class->segments[s], true));
+        RCU_INIT_POINTER(buffer_class->segments[s], NULL);
+    }
+    free_percpu(buffer_class->in_use);
+    free_percpu(buffer_class->magazines);
+    buffer_class->in_use = NULL;
+    buffer_class->magazines = NULL;
+    buffer_class->segment_number = 0;
+    buffer_class->active_number = 0;
+    buffer_class->size = 0;
+    buffer_class->stride = 0;
+}
+
+static void proxyfs_buffer_pool_record(struct proxyfs_buffer_pool *buffer_pool,
+                                       struct proxyfs_buffer_class *buffer_class,
+                                       unsigned int from,
+                                       unsigned int to,
+                                       int in_use)
+{
+    struct proxyfs_buffer_resize_record *record =
+        &buffer_pool->history[buffer_pool->history_count++ % PROXYFS_BUFFER_POOL_HISTORY];
+
+    record->time = ktime_get_real_seconds();
+    record->class_size = buffer_class->size;
+    record->from = from;
+    record->to = to;
+    record->in_use = in_use;
+}
+
+//
+// Make one more segment available for allocation: either cancel
+// retirement of the last segment or publish a new one
+// Note: must be called under `resize_lock`
+static void proxyfs_buffer_class_grow(struct proxyfs_buffer_pool *buffer_pool,
+                                      struct proxyfs_buffer_class *buffer_class,
+                                      int in_use)
+{
+    unsigned int segment_number = buffer_class->segment_number;
+    unsigned int capacity = segment_number * buffer_class->segment_size;
+    struct proxyfs_buffer_segment *segment;
+
+    if (buffer_class->active_number < segment_number) {
+        smp_store_release(&buffer_class->active_number, segment_number);
+        proxyfs_buffer_pool_record(buffer_pool, buffer_class, capacity, capacity, in_use);
+        return;
+    }
+    if (segment_number == PROXYFS_BUFFER_CLASS_SEGMENTS) {
+        return;
+    }
+    if ((segment = proxyfs_buffer_segment_create(buffer_class->segment_size,
+                                                 buffer_class->stride)) == NULL) {
+        return;
+    }
+    rcu_assign_pointer(buffer_class->segments[segment_number], segment);
+    smp_store_release(&buffer_class->segment_number, segment_number + 1);
+    smp_store_release(&buffer_class->active_number, segment_number + 1);
+    proxyfs_buffer_pool_record(buffer_pool,
+                               buffer_class,
+                               capacity,
+                               capacity + buffer_class->segment_size,
+                               in_use);
+}
+
+//
+// Move buffers of the retiring segment from the local magazine back
+// to the segment (runs on every CPU with interrupts disabled)
+static void proxyfs_buffer_class_drain_cpu(void *info)
+{
+    struct proxyfs_buffer_class *buffer_class = info;
+    struct proxyfs_buffer_magazine *magazine = this_cpu_ptr(buffer_class->magazines);
+    struct proxyfs_buffer_segment *segment;
     unsigned int i;
-    if (!buffer_pool || !buffer_pool->buffers || !buffer_pool->bitmap) {
+    unsigned int n = 0;
+    u32 index;
+
+    rcu_read_lock();
+    segment = rcu_dereference(buffer_class->segments[buffer_class->segment_number - 1]);
+    for (i = 0; i < magazine->count; i++) {
+        void *buffer = magazine->buffers[i];
+        if (segment != NULL &&
+            (index = proxyfs_buffer_segment_index(segment, buffer)) != PROXYFS_BUFFER_POOL_NIL) {
+            proxyfs_buffer_segment_push(segment, index, index);
+        } else {
+            magazine->buffers[n++] = buffer;
+        }
+    }
+    magazine->count = n;
+    rcu_read_unlock();
+}
+
+//
+// Stop allocation from the last segment and collect its cached buffers,
+// the segment is released by `proxyfs_buffer_class_retire()` later
+// Note: must be called under `resize_lock`
+static void proxyfs_buffer_class_shrink(struct proxyfs_buffer_class *buffer_class)
+{
+    smp_store_release(&buffer_class->active_number, buffer_class->segment_number - 1);
+    //
+    // Wait for producers which might not see the change above yet
+    synchronize_rcu();
+    on_each_cpu(proxyfs_buffer_class_drain_cpu, buffer_class, 1);
+}
+
+//
+// Release the retiring segment if all its buffers are back
+// Note: must be called under `resize_lock`
+static void proxyfs_buffer_class_retire(struct proxyfs_buffer_pool *buffer_pool,
+                                        struct proxyfs_buffer_class *buffer_class,
+                                        int in_use)
+{
+    unsigned int segment_number = buffer_class->segment_number;
+    unsigned int capacity = segment_number * buffer_class->segment_size;
+    struct proxyfs_buffer_segment *segment =
+        rcu_dereference_protected(buffer_class->segments[segment_number - 1],
+                                  lockdep_is_held(&buffer_pool->resize_lock));
+
+    if (proxyfs_buffer_segment_free_count(segment) < segment->count) {
         return;
     }
-    for (i = 0; i < buffer_pool->count; i++) {
-        kfree(buffer_pool->buffers[i]);
+    RCU_INIT_POINTER(buffer_class->segments[segment_number - 1], NULL);
+    smp_store_release(&buffer_class->segment_number, segment_number - 1);
+    synchronize_rcu();
+    proxyfs_buffer_segment_destroy(segment);
+    proxyfs_buffer_pool_record(buffer_pool,
+                               buffer_class,
+                               capacity,
+                               capacity - buffer_class->segment_size,
+                               in_use);
+}
+
+//
+// Worker growing/shrinking classes according to the watermarks, producers
+// are never blocked by it: new segments are published by RCU and retiring
+// segments are released once all their buffers are back
+// Note: the worker is armed by producers crossing the high watermark and
+//       keeps running periodically only while some class is above its
+//       initial size, an idle pool at the base size costs nothing
+static void proxyfs_buffer_pool_resize(struct work_struct *work)
+{
+    struct proxyfs_buffer_pool *buffer_pool = container_of(to_delayed_work(work),
+                                                           struct proxyfs_buffer_pool,
+                                                           resize_work);
+    bool rearm = false;
+    int c;
+
+    mutex_lock(&buffer_pool->resize_lock);
+    for (c = 0; c < PROXYFS_BUFFER_CLASS_COUNT; c++) {
+        struct proxyfs_buffer_class *buffer_class = &buffer_pool->classes[c];
+        int in_use = proxyfs_buffer_class_in_use(buffer_class);
+        u64 usage = (u64)max(in_use, 0) * 100;
+        u64 capacity = (u64)buffer_class->segment_number * buffer_class->segment_size;
+        u64 active_capacity = (u64)buffer_class->active_number * buffer_class->segment_size;
+
+        if (in_use > READ_ONCE(buffer_class->peak)) {
+            WRITE_ONCE(buffer_class->peak, in_use);
+        }
+        if (usage >= active_capacity * buffer_pool->high_watermark) {
+            proxyfs_buffer_class_grow(buffer_pool, buffer_class, in_use);
+        } else if (buffer_class->active_number < buffer_class->segment_number) {
+            proxyfs_buffer_class_retire(buffer_pool, buffer_class, in_use);
+        } else if (buffer_class->segment_number > 1 &&
+                   usage <= (capacity - buffer_class->segment_size) * buffer_pool->low_watermark) {
+            //
+            // Note: the class is shrunk only if it stays below the low
+            //       watermark without the last segment
+            proxyfs_buffer_class_shrink(buffer_class);
+        }
+        if (buffer_class->segment_number > 1) {
+            rearm = true;
+        }
+    }
+    mutex_unlock(&buffer_pool->resize_lock);
+
+    if (rearm) {
+        queue_delayed_work(system_wq,
+                           &buffer_pool->resize_work,
+                           msecs_to_jiffies(PROXYFS_BUFFER_POOL_RESIZE_PERIOD_MS));
+    }
+}
+
+//
+// Sample usage of the class and wake the resize worker up once it crosses
+// the high watermark, called on magazine refill only, thus the per-CPU sum
+// is paid once per `magazine_batch` allocations
+static void proxyfs_buffer_pool_watch(struct proxyfs_buffer_pool *buffer_pool,
+                                      struct proxyfs_buffer_class *buffer_class)
+{
+    int in_use = proxyfs_buffer_class_in_use(buffer_class);
+    u64 active_capacity = (u64)smp_load_acquire(&buffer_class->active_number) *
+                          buffer_class->segment_size;
+
+    //
+    // Note: racing updates can lose a sample, the peak is approximate
+    if (in_use > READ_ONCE(buffer_class->peak)) {
+        WRITE_ONCE(buffer_class->peak, in_use);
+    }
+    if ((u64)max(in_use, 0) * 100 >= active_capacity * buffer_pool->high_watermark) {
+        queue_delayed_work(system_wq, &buffer_pool->resize_work, 0);
     }
-    kfree(buffer_pool->bitmap);
-    kfree(buffer_pool->buffers);
-    buffer_pool->buffers = NULL;
-    buffer_pool->bitmap = NULL;
-    buffer_pool->count = 0;
-    buffer_pool->size = 0;
+}
+
+bool proxyfs_buffer_pool_init(struct proxyfs_buffer_pool *buffer_pool,
+                              const struct proxyfs_buffer_pool_config *config)
+{
+    if (buffer_pool == NULL || config == NULL) {
+        return false;
+    }
+
+    int c;
+
+    if (config->low_watermark >= config->high_watermark ||
+        config->high_watermark > 100) {
+        pr_err("%s: invalid memory buffer pool watermarks (low %u, high %u)",
+               MODULE_NAME,
+               config->low_watermark,
+               config->high_watermark);
+        return false;
+    }
+    for (c = 0; c < PROXYFS_BUFFER_CLASS_COUNT; c++) {
+        if (c > 0 && config->sizes[c] <= config->sizes[c - 1]) {
+            pr_err("%s: sizes of memory buffer pool classes must ascend (%u <= %u)",
+                   MODULE_NAME,
+                   config->sizes[c],
+                   config->sizes[c - 1]);
+            break;
+        }
+        if (!proxyfs_buffer_class_init(&buffer_pool->classes[c],
+                                       config->counts[c],
+                                       config->sizes[c])) {
+            break;
+        }
+    }
+    if (c < PROXYFS_BUFFER_CLASS_COUNT) {
+        while (c--) {
+            proxyfs_buffer_class_destroy(&buffer_pool->classes[c]);
+        }
+        return false;
+    }
+    buffer_pool->low_watermark = config->low_watermark;
+    buffer_pool->high_watermark = config->high_watermark;
+    buffer_pool->history_count = 0;
+    mutex_init(&buffer_pool->resize_lock);
+    INIT_DELAYED_WORK(&buffer_pool->resize_work, proxyfs_buffer_pool_resize);
+    return true;
+}
+
+void proxyfs_buffer_pool_destroy(struct proxyfs_buffer_pool *buffer_pool)
+{
+    int c;
+
+    if (buffer_pool == NULL || buffer_pool->classes[0].magazines == NULL) {
+        return;
+    }
+    cancel_delayed_work_sync(&buffer_pool->resize_work);
+    for (c = 0; c < PROXYFS_BUFFER_CLASS_COUNT; c++) {
+        proxyfs_buffer_class_destroy(&buffer_pool->classes[c]);
+    }
+}
+
+//
+// Allocate a buffer from the smallest class fitting `size`, larger classes
+// are used if the class is exhausted
+void* proxyfs_buffer_pool_alloc(struct proxyfs_buffer_pool *buffer_pool,
+                                size_t size)
+{
+    if (buffer_pool == NULL) {
+        return NULL;
+    }
+    struct proxyfs_buffer_class *fit = NULL;
+    void *buffer = NULL;
+    bool refilled;
+    int c;
+
+    for (c = 0; c < PROXYFS_BUFFER_CLASS_COUNT; c++) {
+        struct proxyfs_buffer_class *buffer_class = &buffer_pool->classes[c];
+        if (buffer_class->magazines == NULL || buffer_class->size < size) {
+            continue;
+        }
+        if (fit == NULL) {
+            fit = buffer_class;
+        }
+        refilled = false;
+        buffer = proxyfs_buffer_class_alloc(buffer_class, &refilled);
+        if (refilled) {
+            proxyfs_buffer_pool_watch(buffer_pool, buffer_class);
+        }
+        if (buffer != NULL) {
+            break;
+        }
+    }
+    if (fit != NULL && fit != &buffer_pool->classes[c]) {
+        if (buffer != NULL) {
+            atomic_long_inc(&fit->fallbacks);
+        } else {
+            atomic_long_inc(&fit->failures);
+            //
+            // Do not wait for the next period to grow the pool
+            mod_delayed_work(system_wq, &buffer_pool->resize_work, 0);
+        }
+    }
+    return buffer;
+}
+
+bool proxyfs_buffer_pool_free(struct proxyfs_buffer_pool *buffer_pool,
+                              void *buffer)
+{
+    if (buffer_pool == NULL || buffer == NULL) {
+        return false;
+    }
+    int c;
+
+    for (c = 0; c < PROXYFS_BUFFER_CLASS_COUNT; c++) {
+        struct proxyfs_buffer_class *buffer_class = &buffer_pool->classes[c];
+        if (buffer_class->magazines != NULL &&
+            proxyfs_buffer_class_free(buffer_class, buffer)) {
+            return true;
+        }
+    }
+    pr_err("%s: buffer %p does not belong to memory buffer pool",
+           MODULE_NAME,
+           buffer);
+    return false;
+}
+
+unsigned int proxyfs_buffer_pool_max_size(struct proxyfs_buffer_pool *buffer_pool)
+{
+    if (buffer_pool == NULL) {
+        return 0;
+    }
+    return buffer_pool->classes[PROXYFS_BUFFER_CLASS_COUNT - 1].size;
 }
 
 int proxyfs_buffer_pool_in_use(struct proxyfs_buffer_pool* pool)
 {
-    return atomic_read(&pool->in_use);
+    int in_use = 0;
+    int c;
+
+    if (pool == NULL) {
+        return 0;
+    }
+    for (c = 0; c < PROXYFS_BUFFER_CLASS_COUNT; c++) {
+        in_use += proxyfs_buffer_class_in_use(&pool->classes[c]);
+    }
+    return in_use;
 }
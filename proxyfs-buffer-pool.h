@@ -5,22 +5,143 @@
 #define __PROXYFS_BUFFER_POOL_H__
 #include <linux/spinlock.h>
 #include <linux/atomic.h>
-    
-struct proxyfs_buffer_pool {
-    void **buffers;
-    unsigned long *bitmap;
-    unsigned int size;
+#include <linux/percpu.h>
+#include <linux/types.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/rcupdate.h>
+
+//
+// Highest number of buffers cached by every CPU, a class scales it down
+// thus magazines of all CPUs never hold more than half of the class
+#define PROXYFS_BUFFER_POOL_MAGAZINE_SIZE  32
+
+//
+// End of the free list marker
+#define PROXYFS_BUFFER_POOL_NIL U32_MAX
+
+//
+// Size classes of the pool, the classes are ordered by buffer size
+#define PROXYFS_BUFFER_CLASS_COUNT 3
+#define PROXYFS_BUFFER_CLASS_SIZES { 128, 512, 4096 }
+#define PROXYFS_BUFFER_CLASS_COUNTS { 4096, 1024, 256 }
+
+//
+// Every class grows by segments of its initial size, thus a class can hold
+// up to `PROXYFS_BUFFER_CLASS_SEGMENTS` times more buffers than initially
+#define PROXYFS_BUFFER_CLASS_SEGMENTS 16
+
+//
+// Usage of a class (in percents of its capacity) which triggers growth
+// or shrink of the class and period of the usage sampling while any
+// class is above its initial size
+#define PROXYFS_BUFFER_POOL_HIGH_WATERMARK 75
+#define PROXYFS_BUFFER_POOL_LOW_WATERMARK  25
+#define PROXYFS_BUFFER_POOL_RESIZE_PERIOD_MS 100
+
+//
+// Number of the latest resize operations kept by the pool
+#define PROXYFS_BUFFER_POOL_HISTORY 16
+
+//
+// Per-CPU stack of free buffers ("magazine"), it is accessed with local
+// interrupts disabled only, thus no any lock is required
+struct proxyfs_buffer_magazine {
+    unsigned int count;
+    void *buffers[PROXYFS_BUFFER_POOL_MAGAZINE_SIZE];
+};
+
+//
+// Contiguous memory segment holding `count` buffers placed every `stride`
+// bytes of the class, thus index of a buffer is computed from its address
+struct proxyfs_buffer_segment {
+    void *arena;
     unsigned int count;
-    spinlock_t lock;
-    atomic_t in_use;
+    unsigned int stride;
+    //
+    // Lock-free stack of free buffers of the segment: low 32 bits keep
+    // index of the top buffer, high 32 bits keep a tag incremented on
+    // every update to protect against ABA; every free buffer keeps index
+    // of the next free one in its first 4 bytes
+    atomic64_t free_head;
+};
+
+//
+// Set of equally sized buffers
+struct proxyfs_buffer_class {
+    //
+    // Segments are published (and unpublished) by the resize worker only,
+    // producers access them under RCU
+    struct proxyfs_buffer_segment __rcu *segments[PROXYFS_BUFFER_CLASS_SEGMENTS];
+    unsigned int segment_number;
+    //
+    // Number of segments buffers are allocated from, it is less than
+    // `segment_number` while the last segment is going to be released:
+    // buffers of such a segment bypass magazines on release
+    unsigned int active_number;
+    unsigned int size;
+    unsigned int stride;
+    unsigned int segment_size;
+    //
+    // Number of buffers cached by every CPU and number of buffers moved
+    // between a magazine and the segments at once, magazines are bypassed
+    // if the class is too small to give every CPU even a single buffer
+    unsigned int magazine_size;
+    unsigned int magazine_batch;
+    struct proxyfs_buffer_magazine __percpu *magazines;
+    //
+    // Per-CPU balance of allocated/released buffers, a single CPU value
+    // can be negative, the sum over all CPUs is the number of buffers in use
+    int __percpu *in_use;
+    //
+    // Highest number of buffers in use observed on magazine refills and
+    // by the resize worker
+    int peak;
+    //
+    // Requests fitting this class but served by a larger one (`fallbacks`)
+    // or not served at all (`failures`) as the class was exhausted
+    atomic_long_t fallbacks;
+    atomic_long_t failures;
+};
+
+struct proxyfs_buffer_pool_config {
+    unsigned int counts[PROXYFS_BUFFER_CLASS_COUNT];
+    unsigned int sizes[PROXYFS_BUFFER_CLASS_COUNT];
+    unsigned int low_watermark;
+    unsigned int high_watermark;
+};
+
+struct proxyfs_buffer_resize_record {
+    time64_t time;
+    unsigned int class_size;
+    unsigned int from;
+    unsigned int to;
+    int in_use;
+};
+
+struct proxyfs_buffer_pool {
+    struct proxyfs_buffer_class classes[PROXYFS_BUFFER_CLASS_COUNT];
+    unsigned int low_watermark;
+    unsigned int high_watermark;
+    //
+    // Serializes resize operations and access to the history
+    struct mutex resize_lock;
+    struct delayed_work resize_work;
+    struct proxyfs_buffer_resize_record history[PROXYFS_BUFFER_POOL_HISTORY];
+    unsigned int history_count;
 };
 
 bool proxyfs_buffer_pool_init(struct proxyfs_buffer_pool *buffer_pool,
-                              unsigned int count,
-                              unsigned int size);
+                              const struct proxyfs_buffer_pool_config *config);
 void proxyfs_buffer_pool_destroy(struct proxyfs_buffer_pool* pool);
+void* proxyfs_buffer_pool_alloc(struct proxyfs_buffer_pool *buffer_pool,
+                                size_t size);
+bool proxyfs_buffer_pool_free(struct proxyfs_buffer_pool *buffer_pool,
+                              void *buffer);
+unsigned int proxyfs_buffer_pool_max_size(struct proxyfs_buffer_pool *buffer_pool);
 int proxyfs_buffer_pool_in_use(struct proxyfs_buffer_pool* pool);
+int proxyfs_buffer_class_in_use(struct proxyfs_buffer_class *buffer_class);
+unsigned int proxyfs_buffer_class_capacity(struct proxyfs_buffer_class *buffer_class);
 
 
 #endif //  !__PROXYFS_BUFFER_POOL_H__
-
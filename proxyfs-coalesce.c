@@ -0,0 +1,366 @@
+// File		:proxyfs-coalesce.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 18:07:52 2026
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/workqueue.h>
+#include <linux/timekeeping.h>
+#include <linux/jiffies.h>
+#include <linux/cred.h>
+#include <linux/seq_file.h>
+#include <linux/wait_bit.h>
+#include "proxyfs.h"
+
+//
+// Pending record of the repeated operations: calls of the same operation
+// by the same task on the same inode which touch adjacent ranges
+//
+// Note: the record holds references of the inode and the dentry, thus
+//       the path is rendered when the record is delivered
+struct proxyfs_coalesce_entry {
+    struct inode *inode;
+    struct dentry *path;
+    enum proxyfs_event_op op;
+    pid_t pid;
+    pid_t tgid;
+    uid_t uid;
+    //
+    // Range of the file touched by the calls: [start, end)
+    u64 start;
+    u64 end;
+    u64 bytes;
+    u32 calls;
+    //
+    // Time of the first call (real time is reported, monotonic one is
+    // used to expire the record)
+    u64 timestamp;
+    u64 first;
+};
+
+struct proxyfs_coalesce_cpu {
+    //
+    // Taken by the event handlers of the CPU and by the flushes
+    spinlock_t lock;
+    struct proxyfs_coalesce_entry entries[PROXYFS_COALESCE_SLOTS];
+};
+
+static DEFINE_PER_CPU(struct proxyfs_coalesce_cpu, proxyfs_coalesce_cpus);
+
+static struct {
+    u64 window_ns;
+    unsigned int window_us;
+    //
+    // Number of pending records of all CPUs (flushes are skipped if
+    // there are none)
+    atomic_t pending;
+    //
+    // Number of records detached from their slots and being delivered
+    // (they still hold their references)
+    atomic_t delivering;
+    atomic_long_t merged;
+    atomic_long_t records;
+    struct delayed_work work;
+} proxyfs_coalesce;
+
+typedef bool (*proxyfs_coalesce_match_t)(const struct proxyfs_coalesce_entry *entry,
+                                         const void *data);
+
+static bool proxyfs_coalesce_is_coalesced(enum proxyfs_event_op op)
+{
+    return op == PROXYFS_EVENT_OP_READ || op == PROXYFS_EVENT_OP_WRITE;
+}
+
+//
+// Check if the operation can't be reordered with the pending records of
+// its inode (thus they have to be delivered ahead of it)
+static bool proxyfs_coalesce_is_barrier(enum proxyfs_event_op op)
+{
+    switch (op) {
+    case PROXYFS_EVENT_OP_RELEASE:
+    case PROXYFS_EVENT_OP_FSYNC:
+    case PROXYFS_EVENT_OP_UNLINK:
+    case PROXYFS_EVENT_OP_RENAME:
+    case PROXYFS_EVENT_OP_SETATTR:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//
+// Deliver the record detached from its slot and release its references
+static void proxyfs_coalesce_deliver(struct proxyfs_coalesce_entry *entry)
+{
+    proxyfs_event_deliver(entry->op,
+                          &(struct proxyfs_event_args) {
+                              .inode = entry->inode,
+                              .path = entry->path,
+                              .offset = entry->start,
+                              .length = entry->end - entry->start,
+                              .bytes = entry->bytes,
+                              .calls = entry->calls,
+                              .pid = entry->pid,
+                              .tgid = entry->tgid,
+                              .uid = entry->uid,
+                              .timestamp = entry->timestamp,
+                          });
+    atomic_long_inc(&proxyfs_coalesce.records);
+    dput(entry->path);
+    iput(entry->inode);
+    if (atomic_dec_and_test(&proxyfs_coalesce.delivering)) {
+        wake_up_var(&proxyfs_coalesce.delivering);
+    }
+}
+
+//
+// Deliver the pending records of all CPUs matching `match`
+static void proxyfs_coalesce_flush(proxyfs_coalesce_match_t match,
+                                   const void *data)
+{
+    struct proxyfs_coalesce_entry detached[PROXYFS_COALESCE_SLOTS];
+    struct proxyfs_coalesce_cpu *coalesce_cpu;
+    unsigned int count;
+    unsigned int i;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        if (atomic_read(&proxyfs_coalesce.pending) == 0) {
+            break;
+        }
+        coalesce_cpu = per_cpu_ptr(&proxyfs_coalesce_cpus, cpu);
+        count = 0;
+        spin_lock(&coalesce_cpu->lock);
+        for (i = 0; i < PROXYFS_COALESCE_SLOTS; i++) {
+            struct proxyfs_coalesce_entry *entry = &coalesce_cpu->entries[i];
+
+            if (entry->inode != NULL && match(entry, data)) {
+                detached[count++] = *entry;
+                entry->inode = NULL;
+                atomic_dec(&proxyfs_coalesce.pending);
+                atomic_inc(&proxyfs_coalesce.delivering);
+            }
+        }
+        spin_unlock(&coalesce_cpu->lock);
+        //
+        // Note: delivery may sleep (e.g. `block` backpressure policy)
+        for (i = 0; i < count; i++) {
+            proxyfs_coalesce_deliver(&detached[i]);
+        }
+    }
+}
+
+static bool proxyfs_coalesce_match_inode(const struct proxyfs_coalesce_entry *entry,
+                                         const void *data)
+{
+    return entry->inode == data;
+}
+
+static bool proxyfs_coalesce_match_sb(const struct proxyfs_coalesce_entry *entry,
+                                      const void *data)
+{
+    return entry->inode->i_sb == data;
+}
+
+static bool proxyfs_coalesce_match_expired(const struct proxyfs_coalesce_entry *entry,
+                                           const void *data)
+{
+    return *(const u64 *)data - entry->first >= proxyfs_coalesce.window_ns;
+}
+
+static bool proxyfs_coalesce_match_any(const struct proxyfs_coalesce_entry *entry,
+                                       const void *data)
+{
+    return true;
+}
+
+//
+// Deliver the records which have outlived the time window
+static void proxyfs_coalesce_work(struct work_struct *work)
+{
+    u64 now = ktime_get_ns();
+
+    proxyfs_coalesce_flush(proxyfs_coalesce_match_expired, &now);
+    if (atomic_read(&proxyfs_coalesce.pending) != 0) {
+        schedule_delayed_work(&proxyfs_coalesce.work,
+                              usecs_to_jiffies(proxyfs_coalesce.window_us));
+    }
+}
+
+//
+// Merge the call to the pending record of the current CPU, true is
+// returned if the event is absorbed by the record (thus it must not be
+// delivered by the caller)
+static bool proxyfs_coalesce_add(enum proxyfs_event_op op,
+                                 const struct proxyfs_event_args *args)
+{
+    struct proxyfs_coalesce_entry evicted = {};
+    struct proxyfs_coalesce_entry *entry = NULL;
+    struct proxyfs_coalesce_entry *oldest = NULL;
+    struct proxyfs_coalesce_cpu *coalesce_cpu;
+    pid_t pid = task_pid_nr(current);
+    u64 now = ktime_get_ns();
+    u64 end = args->offset + args->length;
+    bool arm = false;
+    unsigned int i;
+
+    if (args->inode == NULL || args->path == NULL) {
+        return false;
+    }
+    coalesce_cpu = get_cpu_ptr(&proxyfs_coalesce_cpus);
+    spin_lock(&coalesce_cpu->lock);
+    for (i = 0; i < PROXYFS_COALESCE_SLOTS; i++) {
+        struct proxyfs_coalesce_entry *slot = &coalesce_cpu->entries[i];
+
+        if (slot->inode == NULL) {
+            entry = entry ? entry : slot;
+            continue;
+        }
+        if (slot->inode == args->inode && slot->pid == pid && slot->op == op) {
+            entry = slot;
+            break;
+        }
+        if (oldest == NULL || slot->first < oldest->first) {
+            oldest = slot;
+        }
+    }
+    do {
+        if (entry != NULL && entry->inode != NULL) {
+            //
+            // Note: the ranges have to overlap or touch, otherwise the
+            //       record could not be described by a single range
+            if (now - entry->first < proxyfs_coalesce.window_ns &&
+                args->offset <= entry->end &&
+                end >= entry->start) {
+                entry->start = min(entry->start, args->offset);
+                entry->end = max(entry->end, end);
+                entry->bytes += args->length;
+                entry->calls++;
+                atomic_long_inc(&proxyfs_coalesce.merged);
+                break;
+            }
+            evicted = *entry;
+            atomic_inc(&proxyfs_coalesce.delivering);
+        } else if (entry == NULL) {
+            entry = oldest;
+            evicted = *entry;
+            atomic_inc(&proxyfs_coalesce.delivering);
+        } else {
+            arm = atomic_inc_return(&proxyfs_coalesce.pending) == 1;
+        }
+        entry->inode = args->inode;
+        entry->path = args->path;
+        ihold(entry->inode);
+        dget(entry->path);
+        entry->op = op;
+        entry->pid = pid;
+        entry->tgid = task_tgid_nr(current);
+        entry->uid = from_kuid(&init_user_ns, current_fsuid());
+        entry->start = args->offset;
+        entry->end = end;
+        entry->bytes = args->length;
+        entry->calls = 1;
+        entry->timestamp = ktime_get_real_ns();
+        entry->first = now;
+    } while (false);
+    spin_unlock(&coalesce_cpu->lock);
+    put_cpu_ptr(&proxyfs_coalesce_cpus);
+
+    if (evicted.inode != NULL) {
+        proxyfs_coalesce_deliver(&evicted);
+    }
+    //
+    // The work is armed by the first pending record, then it rearms
+    // itself while there are pending records
+    if (arm) {
+        schedule_delayed_work(&proxyfs_coalesce.work,
+                              usecs_to_jiffies(proxyfs_coalesce.window_us));
+    }
+    return true;
+}
+
+//
+// Pass the event through the coalescing stage, true is returned if the
+// event is absorbed by a pending record
+bool proxyfs_coalesce_event(enum proxyfs_event_op op,
+                            const struct proxyfs_event_args *args)
+{
+    if (proxyfs_coalesce.window_us == 0) {
+        return false;
+    }
+    if (proxyfs_coalesce_is_coalesced(op)) {
+        return proxyfs_coalesce_add(op, args);
+    }
+    if (proxyfs_coalesce_is_barrier(op) && atomic_read(&proxyfs_coalesce.pending) != 0) {
+        if (args->inode != NULL) {
+            proxyfs_coalesce_flush(proxyfs_coalesce_match_inode, args->inode);
+        }
+        //
+        // Target of the rename is replaced by it
+        if (op == PROXYFS_EVENT_OP_RENAME && args->new_path != NULL &&
+            d_really_is_positive(args->new_path)) {
+            proxyfs_coalesce_flush(proxyfs_coalesce_match_inode, d_inode(args->new_path));
+        }
+    }
+    return false;
+}
+
+//
+// Deliver the pending records of the mount, must be called before the
+// dentries of the mount are shrunk (the records hold references)
+//
+// Note: records already detached by the work or by the handlers (evicted
+//       or flushed by a barrier) are being delivered, thus they are
+//       waited for
+void proxyfs_coalesce_flush_sb(struct super_block *sb)
+{
+    proxyfs_coalesce_flush(proxyfs_coalesce_match_sb, sb);
+    flush_delayed_work(&proxyfs_coalesce.work);
+    wait_var_event(&proxyfs_coalesce.delivering,
+                   atomic_read(&proxyfs_coalesce.delivering) == 0);
+}
+
+void proxyfs_coalesce_show_stats(struct seq_file *m)
+{
+    seq_printf(m, "window_us=%u pending=%d merged=%ld records=%ld\n",
+               proxyfs_coalesce.window_us,
+               atomic_read(&proxyfs_coalesce.pending),
+               atomic_long_read(&proxyfs_coalesce.merged),
+               atomic_long_read(&proxyfs_coalesce.records));
+}
+
+void proxyfs_coalesce_init(const struct proxyfs_coalesce_config *config)
+{
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        struct proxyfs_coalesce_cpu *coalesce_cpu = per_cpu_ptr(&proxyfs_coalesce_cpus, cpu);
+
+        spin_lock_init(&coalesce_cpu->lock);
+        memset(coalesce_cpu->entries, 0, sizeof(coalesce_cpu->entries));
+    }
+    proxyfs_coalesce.window_us = config->window_us;
+    proxyfs_coalesce.window_ns = (u64)config->window_us * NSEC_PER_USEC;
+    atomic_set(&proxyfs_coalesce.pending, 0);
+    atomic_set(&proxyfs_coalesce.delivering, 0);
+    atomic_long_set(&proxyfs_coalesce.merged, 0);
+    atomic_long_set(&proxyfs_coalesce.records, 0);
+    INIT_DELAYED_WORK(&proxyfs_coalesce.work, proxyfs_coalesce_work);
+    if (config->window_us == 0) {
+        pr_info("%s: event coalescing is disabled\n",
+                MODULE_NAME);
+    } else {
+        pr_info("%s: events are coalesced within %u us window\n",
+                MODULE_NAME,
+                config->window_us);
+    }
+}
+
+void proxyfs_coalesce_release(void)
+{
+    //
+    // Note: the mounts have flushed their records already, thus just the
+    //       work has to be stopped
+    cancel_delayed_work_sync(&proxyfs_coalesce.work);
+    proxyfs_coalesce_flush(proxyfs_coalesce_match_any, NULL);
+    proxyfs_coalesce.window_us = 0;
+}
@@ -1,19 +1,21 @@
 // File		:proxyfs-context.c
 // Author	:Victor Kovalevich
 // Created	:Wed Jul 16 13:47:36 2025
+#include <linux/srcu.h>
+#include <linux/slab.h>
 #include "proxyfs.h"
 
+//
+// Protects the client descriptor, readers may sleep while sending
+DEFINE_STATIC_SRCU(proxyfs_client_srcu);
+
 static struct proxyfs_context_data proxyfs_context = {
     .nl_socket = NULL,
-    .client_pid = {
-        .counter = 0
-    },
+    .client = NULL,
+    .client_lock = __SPIN_LOCK_UNLOCKED(proxyfs_context.client_lock),
     .proc_dir = NULL,
     .buffer_pool = {
-        .buffers = NULL,
-        .bitmap = NULL,
-        .size = 0,
-        .count = 0
+        .classes = {}
     },
     .running_state = {
         .counter = 0
@@ -23,16 +25,199 @@ static struct proxyfs_context_data proxyfs_context = {
     }
 };
 
-int proxyfs_context_set_client_pid(const int new_client_pid)
+int proxyfs_context_init(const struct proxyfs_context_config *config)
+{
+    int res = -ENOMEM;
+
+    if (!proxyfs_buffer_pool_init(&proxyfs_context.buffer_pool, &config->pool)) {
+        return -ENOMEM;
+    }
+    if ((res = proxyfs_event_init()) != 0) {
+        goto out_pool;
+    }
+    //
+    // Note: permission state is set up before the socket, a client may
+    //       register as soon as the socket exists and its withdrawal on
+    //       the unwind path below cancels requests and flushes verdicts
+    proxyfs_perm_init(&config->perm);
+    res = -ENOMEM;
+    if ((proxyfs_context.proc_dir = proxyfs_procfs_setup()) == NULL) {
+        goto out_perm;
+    }
+    if ((proxyfs_context.nl_socket = proxyfs_socket_init(PROXYFS_NETLINK_USER,
+                                                         &config->socket)) == NULL) {
+        goto out_procfs;
+    }
+    if ((res = proxyfs_ring_init(&config->ring)) != 0) {
+        goto out_socket;
+    }
+    if ((res = proxyfs_queue_init(&config->queue)) != 0) {
+        goto out_ring;
+    }
+    if ((res = proxyfs_flight_init(&config->flight)) != 0) {
+        goto out_queue;
+    }
+    if ((res = proxyfs_top_init(&config->top)) != 0) {
+        goto out_flight;
+    }
+    proxyfs_coalesce_init(&config->coalesce);
+    proxyfs_slow_init(&config->slow);
+    atomic_set(&proxyfs_context.running_state, 1);
+    return 0;
+
+    //
+    // Note: the stages are released in the reverse order of their setup,
+    //       the way `proxyfs_context_release()` does
+out_flight:
+    proxyfs_flight_release();
+out_queue:
+    proxyfs_queue_release();
+out_ring:
+    proxyfs_ring_release();
+out_socket:
+    proxyfs_socket_release(proxyfs_context.nl_socket);
+    proxyfs_context.nl_socket = NULL;
+    //
+    // A client may have registered while the setup was in progress
+    proxyfs_context_unregister_client(0);
+    srcu_barrier(&proxyfs_client_srcu);
+    proxyfs_bpf_release();
+out_procfs:
+    //
+    // The filter and the PID/TGID/cgroup set may have been configured
+    // through the procfs entries already, they are released once no
+    // writer of the entries is left
+    proxyfs_procfs_release();
+    proxyfs_context.proc_dir = NULL;
+    proxyfs_filter_release();
+    proxyfs_pids_release();
+out_perm:
+    proxyfs_perm_release();
+    proxyfs_event_release();
+out_pool:
+    proxyfs_buffer_pool_destroy(&proxyfs_context.buffer_pool);
+    return res;
+}
+
+void proxyfs_context_release(void)
+{
+    atomic_set(&proxyfs_context.running_state, 0);
+    proxyfs_slow_release();
+    proxyfs_perm_release();
+    proxyfs_coalesce_release();
+    proxyfs_top_release();
+    proxyfs_flight_release();
+    proxyfs_queue_release();
+    proxyfs_ring_release();
+    proxyfs_socket_release(proxyfs_context.nl_socket);
+    proxyfs_context.nl_socket = NULL;
+    proxyfs_context_unregister_client(0);
+    srcu_barrier(&proxyfs_client_srcu);
+    proxyfs_bpf_release();
+    proxyfs_procfs_release();
+    proxyfs_context.proc_dir = NULL;
+    proxyfs_filter_release();
+    proxyfs_pids_release();
+    proxyfs_event_release();
+    proxyfs_buffer_pool_destroy(&proxyfs_context.buffer_pool);
+}
+
+static void proxyfs_context_free_client(struct rcu_head *rcu)
 {
-    int res = atomic_read(&proxyfs_context.client_pid);
-    atomic_set(&proxyfs_context.client_pid, new_client_pid);
+    struct proxyfs_client *client = container_of(rcu, struct proxyfs_client, rcu);
+
+    proxyfs_bpf_destroy(client->prog);
+    put_pid(client->pid);
+    kfree(client);
+}
+
+//
+// Publish the descriptor of the client registered by the current process
+// from NETLINK port `portid`, port of the replaced client (0 if there was
+// no client) or negative errno is returned
+//
+// Note: the descriptor owns the program `prog` (it is destroyed on failure)
+int proxyfs_context_register_client(u32 portid, u32 classes, struct bpf_prog *prog)
+{
+    struct proxyfs_client *client;
+    struct proxyfs_client *old_client;
+    int res;
+
+    if ((client = kzalloc(sizeof(struct proxyfs_client), GFP_KERNEL)) == NULL) {
+        proxyfs_bpf_destroy(prog);
+        return -ENOMEM;
+    }
+    client->portid = portid;
+    client->pid = get_pid(task_tgid(current));
+    client->classes = classes;
+    client->prog = prog;
+    atomic_long_set(&client->sent, 0);
+    atomic_long_set(&client->dropped, 0);
+    atomic_long_set(&client->accepted, 0);
+    atomic_long_set(&client->rejected, 0);
+
+    spin_lock_bh(&proxyfs_context.client_lock);
+    old_client = rcu_replace_pointer(proxyfs_context.client,
+                                     client,
+                                     lockdep_is_held(&proxyfs_context.client_lock));
+    spin_unlock_bh(&proxyfs_context.client_lock);
+
+    res = old_client ? old_client->portid : 0;
+    if (old_client != NULL) {
+        //
+        // Verdicts of the replaced client don't hold for the new one
+        proxyfs_perm_cache_flush();
+        call_srcu(&proxyfs_client_srcu, &old_client->rcu, proxyfs_context_free_client);
+    }
     return res;
 }
 
-int proxyfs_context_get_client_pid(void)
+//
+// Withdraw the client registered from NETLINK port `portid` (any client
+// if `portid` is 0), true is returned if the client has been withdrawn
+bool proxyfs_context_unregister_client(u32 portid)
+{
+    struct proxyfs_client *client;
+
+    spin_lock_bh(&proxyfs_context.client_lock);
+    client = rcu_dereference_protected(proxyfs_context.client,
+                                       lockdep_is_held(&proxyfs_context.client_lock));
+    if (client != NULL && (portid == 0 || client->portid == portid)) {
+        rcu_assign_pointer(proxyfs_context.client, NULL);
+    } else {
+        client = NULL;
+    }
+    spin_unlock_bh(&proxyfs_context.client_lock);
+
+    if (client == NULL) {
+        return false;
+    }
+    //
+    // Nobody is going to answer the pending permission requests and its
+    // verdicts don't hold anymore
+    proxyfs_perm_cancel();
+    proxyfs_perm_cache_flush();
+    call_srcu(&proxyfs_client_srcu, &client->rcu, proxyfs_context_free_client);
+    return true;
+}
+
+int proxyfs_context_client_read_lock(void)
 {
-    return atomic_read(&proxyfs_context.client_pid);
+    return srcu_read_lock(&proxyfs_client_srcu);
+}
+
+void proxyfs_context_client_read_unlock(int idx)
+{
+    srcu_read_unlock(&proxyfs_client_srcu, idx);
+}
+
+//
+// Registered client, NULL if there is no client
+// Note: must be called between `proxyfs_context_client_read_lock()` and
+//       `proxyfs_context_client_read_unlock()`
+struct proxyfs_client *proxyfs_context_get_client(void)
+{
+    return srcu_dereference(proxyfs_context.client, &proxyfs_client_srcu);
 }
 
 bool proxyfs_context_check_uid(const int uid)
@@ -63,25 +248,58 @@ struct sock* proxyfs_context_get_nl_socket(void)
     return proxyfs_context.nl_socket;
 }
 
-void* proxyfs_context_buffer_pool_alloc(struct proxyfs_context_data *context_data)
+struct proxyfs_buffer_pool* proxyfs_context_get_buffer_pool(void)
 {
-    if (context_data == NULL) {
-        return NULL;
+    return &proxyfs_context.buffer_pool;
+}
+
+//
+// Deliver the message to the clients: the consumer of the shared memory
+// ring (if it is attached) and NETLINK channel (the registered client and
+// subscribers of the multicast `group`)
+//
+// Note: while the consumer of the ring is attached the message is not
+//       copied to NETLINK channel (unless the ring is configured as an
+//       extra channel); the permission requests are answered over NETLINK
+//       only, thus they are sent there anyway
+void proxyfs_context_send_msg(const char* msg_body,
+                              size_t msg_len,
+                              unsigned int group)
+{
+    if (proxyfs_ring_write(msg_body, msg_len) &&
+        proxyfs_ring_is_exclusive() &&
+        group != PROXYFS_EVENT_CLASS_GROUP(PROXYFS_EVENT_CLASS_PERMISSION)) {
+        return;
     }
-    unsigned long flags;
-    unsigned int i;
-    void *buffer = NULL;
+    proxyfs_socket_send_msg(msg_body, msg_len, group);
+}
+
+//
+// Check if there is anybody to receive events of the multicast `group`,
+// the client counts only if it has subscribed to the class of the group
+bool proxyfs_context_has_consumer(unsigned int group)
+{
+    struct proxyfs_client *client;
+    bool res;
+    int idx;
 
-    spin_lock_irqsave(&context_data->buffer_pool.lock, flags);
-    if ((i = find_first_zero_bit(context_data->buffer_pool.bitmap,
-                                 context_data->buffer_pool.count)) < context_data->buffer_pool.count) {
-        set_bit(i, context_data->buffer_pool.bitmap);
-        buffer = context_data->buffer_pool.buffers[i];
-        atomic_inc(&context_data->buffer_pool.in_use);
+    if (proxyfs_ring_is_attached() || proxyfs_socket_has_listeners(group)) {
+        return true;
     }
-    spin_unlock_irqrestore(&context_data->buffer_pool.lock, flags);
+    idx = proxyfs_context_client_read_lock();
+    client = proxyfs_context_get_client();
+    res = client != NULL && (client->classes & BIT(group - 1));
+    proxyfs_context_client_read_unlock(idx);
+    return res;
+}
 
-    return buffer;
+void* proxyfs_context_buffer_pool_alloc(struct proxyfs_context_data *context_data,
+                                        size_t size)
+{
+    if (context_data == NULL) {
+        return NULL;
+    }
+    return proxyfs_buffer_pool_alloc(&context_data->buffer_pool, size);
 }
 
 bool proxyfs_context_buffer_pool_free(struct proxyfs_context_data *context_data,
@@ -90,22 +308,7 @@ bool proxyfs_context_buffer_pool_free(struct proxyfs_context_data *context_data,
     if (context_data == NULL || buffer == NULL) {
         return false;
     }
-    unsigned long flags;
-    unsigned int i;
-    bool found = false;
-
-    spin_lock_irqsave(&context_data->buffer_pool.lock, flags);
-    for (i = 0; i < context_data->buffer_pool.count; i++) {
-        if (context_data->buffer_pool.buffers[i] == buffer) {
-            if (test_and_clear_bit(i, context_data->buffer_pool.bitmap)) {
-                atomic_dec(&context_data->buffer_pool.in_use);
-                found = true;
-            }
-            break;
-        }
-    }
-    spin_unlock_irqrestore(&context_data->buffer_pool.lock, flags);
-    return found;
+    return proxyfs_buffer_pool_free(&context_data->buffer_pool, buffer);
 }
 
 unsigned int proxyfs_context_buffer_pool_get_buffer_size(struct proxyfs_context_data *context_data)
@@ -113,5 +316,5 @@ unsigned int proxyfs_context_buffer_pool_get_buffer_size(struct proxyfs_context_
     if (context_data == NULL) {
         return 0;
     }
-    return context_data->buffer_pool.size;
+    return proxyfs_buffer_pool_max_size(&context_data->buffer_pool);
 }
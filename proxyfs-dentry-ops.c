@@ -5,6 +5,7 @@
 #include <linux/namei.h>
 #include <linux/pagemap.h>
 #include "proxyfs.h"
+#include "proxyfs-trace.h"
 
 // d_revalidate()
 static int proxyfs_revalidate(struct inode *inode,
@@ -14,11 +15,7 @@ static int proxyfs_revalidate(struct inode *inode,
 {
     // 1 = valid, 0 = invalid dentry, <0 - error
     int ret = -ENOSYS;
-    PROXYFS_DEBUG("inode=" INODE_FMT ", name=" QSTR_FMT ", dentry=%pd, flags=0x%x\n",
-                  INODE_ARG(inode),
-                  QSTR_ARG(name),
-                  dentry,
-                  flags);
+    trace_proxyfs_dentry_op(__func__, dentry, inode, flags);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
@@ -34,9 +31,7 @@ static int proxyfs_weak_revalidate(struct dentry *dentry,
 {
     // 1 = valid, 0 = invalid dentry, <0 - error
     int ret = -ENOSYS;
-    PROXYFS_DEBUG("dentry=%pd, flags=0x%x\n",
-                  dentry,
-                  flags);
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode(dentry), flags);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
     if (lower_ops && lower_ops->d_weak_revalidate) {
@@ -50,9 +45,7 @@ static int proxyfs_hash(const struct dentry *dentry,
                         struct qstr *name)
 {
     int ret = -ENOSYS;
-    PROXYFS_DEBUG("dentry=%pd, name=" QSTR_FMT "\n",
-                  dentry,
-                  QSTR_ARG(name));
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode_rcu(dentry), 0);
     const struct dentry *lower_dentry = proxyfs_lower_dentry((struct dentry *)dentry);
     const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
     if (lower_ops && lower_ops->d_hash) {
@@ -68,11 +61,7 @@ static int proxyfs_compare(const struct dentry *dentry,
                            const struct qstr *qstr)
 {
     int ret = -ENOSYS;
-    PROXYFS_DEBUG("dentry=%pd, flags=0x%x, str=%s, qstr=" QSTR_FMT "\n",
-                  dentry,
-                  flags,
-                  str,
-                  QSTR_ARG(qstr));
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode_rcu(dentry), flags);
     const struct dentry *lower_dentry = proxyfs_lower_dentry((struct dentry *)dentry);
     const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
     if (lower_ops && lower_ops->d_compare) {
@@ -84,7 +73,7 @@ static int proxyfs_compare(const struct dentry *dentry,
 // d_delete()
 static int proxyfs_delete(const struct dentry *dentry)
 {
-    PROXYFS_DEBUG("dentry=%pd\n", dentry);
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode(dentry), 0);
     struct dentry *lower_dentry = proxyfs_lower_dentry((struct dentry *)dentry);
     const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
     if (lower_ops && lower_ops->d_delete) {
@@ -101,7 +90,7 @@ static int proxyfs_init(struct dentry *dentry)
     struct dentry *lower_parent = NULL;
     struct dentry *lower_dentry = NULL;
     struct vfsmount *lower_mnt = NULL;
-    PROXYFS_DEBUG("dentry=%pd\n", dentry);
+    trace_proxyfs_dentry_op(__func__, dentry, NULL, 0);
     if (dentry->d_parent && dentry->d_parent->d_fsdata) {
         parent_info = (struct proxyfs_dentry_info *)dentry->d_parent->d_fsdata;
         lower_parent = parent_info->lower_dentry;
@@ -125,7 +114,7 @@ static int proxyfs_init(struct dentry *dentry)
 // d_release()
 static void proxyfs_release(struct dentry *dentry)
 {
-    PROXYFS_DEBUG("dentry=%pd\n", dentry);
+    trace_proxyfs_dentry_op(__func__, dentry, NULL, 0);
     struct proxyfs_dentry_info *info = (struct proxyfs_dentry_info *)dentry->d_fsdata;
     if (info) {
         if (info->lower_dentry != NULL) {
@@ -146,7 +135,7 @@ static void proxyfs_release(struct dentry *dentry)
 // d_prune()
 static void proxyfs_prune(struct dentry *dentry)
 {
-    PROXYFS_DEBUG("dentry=%pd\n", dentry);
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode(dentry), 0);
     struct proxyfs_dentry_info *info = (struct proxyfs_dentry_info *)dentry->d_fsdata;
     if (info != NULL) {
         if (info->lower_dentry != NULL) {
@@ -164,9 +153,7 @@ static void proxyfs_iput(struct dentry *dentry, struct inode *inode)
     //
     // Note: this routine is intended to decrease reference counter just
     //       of inode instance involved
-    PROXYFS_DEBUG("dentry=%pd, inode=" INODE_FMT "\n",
-                  dentry,
-                  INODE_ARG(inode));
+    trace_proxyfs_dentry_op(__func__, dentry, inode, 0);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     if (lower_inode) {
         iput(lower_inode);
@@ -178,7 +165,7 @@ static char *proxyfs_dname(struct dentry *dentry,
                            char *buffer,
                            int buffer_len)
 {
-    PROXYFS_DEBUG("dentry=%pd\n", dentry);
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode(dentry), 0);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
     if (lower_ops && lower_ops->d_dname) {
@@ -192,7 +179,7 @@ static char *proxyfs_dname(struct dentry *dentry,
 static struct vfsmount *proxyfs_automount(struct path *path)
 {
     struct vfsmount *lower_mnt = NULL;
-    PROXYFS_DEBUG("path=%pd\n", (path ? path->dentry : NULL));
+    trace_proxyfs_dentry_op(__func__, path ? path->dentry : NULL, NULL, 0);
     if (path == NULL) {
         return lower_mnt;
     }
@@ -214,9 +201,7 @@ static struct vfsmount *proxyfs_automount(struct path *path)
 // d_manage()
 static int proxyfs_manage(const struct path *path, bool do_invalidate)
 {
-    PROXYFS_DEBUG("path=%pd, do_invalidate=%s\n",
-                  (path ? path->dentry : NULL),
-                  (do_invalidate ? "true" : "false"));
+    trace_proxyfs_dentry_op(__func__, path ? path->dentry : NULL, NULL, do_invalidate);
     if (path == NULL || path->dentry == NULL) {
         return -EINVAL;
     }
@@ -240,7 +225,7 @@ static int proxyfs_manage(const struct path *path, bool do_invalidate)
 static struct dentry *proxyfs_real(struct dentry *dentry,
                                    enum d_real_type type)
 {
-    PROXYFS_DEBUG("dentry=%pd, type=%d\n", dentry, type);
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode(dentry), type);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     if (lower_dentry != NULL) {
         const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
@@ -254,7 +239,7 @@ static struct dentry *proxyfs_real(struct dentry *dentry,
 // d_unalias_trylock()
 static bool proxyfs_unalias_trylock(const struct dentry *dentry)
 {
-    PROXYFS_DEBUG("dentry=%pd\n", dentry);
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode(dentry), 0);
     struct dentry *lower_dentry = proxyfs_lower_dentry((struct dentry *)dentry);
     if (lower_dentry != NULL) {
         const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
@@ -268,7 +253,7 @@ static bool proxyfs_unalias_trylock(const struct dentry *dentry)
 // d_unalias_unlock()
 static void proxyfs_unalias_unlock(const struct dentry *dentry)
 {
-    PROXYFS_DEBUG("dentry=%pd\n", dentry);
+    trace_proxyfs_dentry_op(__func__, dentry, d_inode(dentry), 0);
     struct dentry *lower_dentry = proxyfs_lower_dentry((struct dentry *)dentry);
     if (lower_dentry != NULL) {
         const struct dentry_operations *lower_ops = lower_dentry ? lower_dentry->d_op : NULL;
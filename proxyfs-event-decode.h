@@ -0,0 +1,181 @@
+// File		:proxyfs-event-decode.h
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 13:25:09 2026
+//
+// Userspace decoder of the events described by `proxyfs-event.h`, it is
+// generated from the same tables as the kernel side encoders
+#ifndef __PROXYFS_EVENT_DECODE_H__
+#define __PROXYFS_EVENT_DECODE_H__
+#include <string.h>
+#include <errno.h>
+#include "proxyfs-event.h"
+
+#define PROXYFS_EVENT_DECODE_FIELD_string(field) \
+    const char *field;                           \
+    __u16 field##_len;
+#define PROXYFS_EVENT_DECODE_FIELD_text(field) \
+    const char *field;                         \
+    __u16 field##_len;
+#define PROXYFS_EVENT_DECODE_FIELD_u32(field) \
+    __u32 field;
+#define PROXYFS_EVENT_DECODE_FIELD_u64(field) \
+    __u64 field;
+
+struct proxyfs_event_decoded {
+    struct proxyfs_event_header header;
+    //
+    // Bit mask of attributes present (see `PROXYFS_EVENT_ATTR_BIT()`)
+    __u32 attrs;
+#define PROXYFS_EVENT_DECODE_FIELD(NAME, field, kind) PROXYFS_EVENT_DECODE_FIELD_##kind(field)
+    PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_DECODE_FIELD)
+#undef PROXYFS_EVENT_DECODE_FIELD
+};
+
+static inline const char *proxyfs_event_op_name(unsigned int op)
+{
+    static const char *const names[PROXYFS_EVENT_OP_COUNT] = {
+#define PROXYFS_EVENT_OP_NAME(NAME, name, CLASS, attrs) [PROXYFS_EVENT_OP_##NAME] = #name,
+        PROXYFS_EVENT_OPS(PROXYFS_EVENT_OP_NAME)
+#undef PROXYFS_EVENT_OP_NAME
+    };
+    return op < PROXYFS_EVENT_OP_COUNT ? names[op] : "unknown";
+}
+
+static inline const char *proxyfs_event_class_name(unsigned int class_id)
+{
+    static const char *const names[PROXYFS_EVENT_CLASS_COUNT] = {
+#define PROXYFS_EVENT_CLASS_NAME(NAME, name) [PROXYFS_EVENT_CLASS_##NAME] = #name,
+        PROXYFS_EVENT_CLASSES(PROXYFS_EVENT_CLASS_NAME)
+#undef PROXYFS_EVENT_CLASS_NAME
+    };
+    return class_id < PROXYFS_EVENT_CLASS_COUNT ? names[class_id] : "unknown";
+}
+
+//
+// Class of the operation, its events are multicast to
+// `PROXYFS_EVENT_CLASS_GROUP()` group
+static inline int proxyfs_event_op_class(unsigned int op)
+{
+    static const int classes[PROXYFS_EVENT_OP_COUNT] = {
+#define PROXYFS_EVENT_OP_CLASS(NAME, name, CLASS, attrs) [PROXYFS_EVENT_OP_##NAME] = PROXYFS_EVENT_CLASS_##CLASS,
+        PROXYFS_EVENT_OPS(PROXYFS_EVENT_OP_CLASS)
+#undef PROXYFS_EVENT_OP_CLASS
+    };
+    return op < PROXYFS_EVENT_OP_COUNT ? classes[op] : -1;
+}
+
+static inline const char *proxyfs_event_attr_name(unsigned int type)
+{
+    static const char *const names[PROXYFS_EVENT_ATTR_COUNT] = {
+        [PROXYFS_EVENT_ATTR_NONE] = "none",
+#define PROXYFS_EVENT_ATTR_NAME(NAME, field, kind) [PROXYFS_EVENT_ATTR_##NAME] = #field,
+        PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_ATTR_NAME)
+#undef PROXYFS_EVENT_ATTR_NAME
+    };
+    return type < PROXYFS_EVENT_ATTR_COUNT ? names[type] : "unknown";
+}
+
+//
+// Attributes the kernel emits for the operation
+static inline __u32 proxyfs_event_op_attrs(unsigned int op)
+{
+    static const __u32 attrs[PROXYFS_EVENT_OP_COUNT] = {
+#define PROXYFS_EVENT_OP_ATTRS(NAME, name, CLASS, op_attrs) [PROXYFS_EVENT_OP_##NAME] = (op_attrs),
+        PROXYFS_EVENT_OPS(PROXYFS_EVENT_OP_ATTRS)
+#undef PROXYFS_EVENT_OP_ATTRS
+    };
+    return op < PROXYFS_EVENT_OP_COUNT ? attrs[op] : 0;
+}
+
+static inline int proxyfs_event_decode_string(const char *value, __u16 len,
+                                              const char **field, __u16 *field_len)
+{
+    *field = value;
+    *field_len = len;
+    return 0;
+}
+
+static inline int proxyfs_event_decode_text(const char *value, __u16 len,
+                                            const char **field, __u16 *field_len)
+{
+    return proxyfs_event_decode_string(value, len, field, field_len);
+}
+
+static inline int proxyfs_event_decode_u32(const char *value, __u16 len,
+                                           __u32 *field, void *unused)
+{
+    (void)unused;
+    if (len != sizeof(*field)) {
+        return -EINVAL;
+    }
+    memcpy(field, value, sizeof(*field));
+    return 0;
+}
+
+static inline int proxyfs_event_decode_u64(const char *value, __u16 len,
+                                           __u64 *field, void *unused)
+{
+    (void)unused;
+    if (len != sizeof(*field)) {
+        return -EINVAL;
+    }
+    memcpy(field, value, sizeof(*field));
+    return 0;
+}
+
+#define PROXYFS_EVENT_DECODE_ARGS_string(event, field) &(event)->field, &(event)->field##_len
+#define PROXYFS_EVENT_DECODE_ARGS_text(event, field)   &(event)->field, &(event)->field##_len
+#define PROXYFS_EVENT_DECODE_ARGS_u32(event, field)    &(event)->field, NULL
+#define PROXYFS_EVENT_DECODE_ARGS_u64(event, field)    &(event)->field, NULL
+
+//
+// Decode the event of `len` bytes, the number of bytes the event occupies
+// is returned (the next event follows it), negative errno otherwise;
+// unknown attributes are skipped, strings refer to `data`
+static inline int proxyfs_event_decode(const void *data,
+                                       size_t len,
+                                       struct proxyfs_event_decoded *event)
+{
+    const char *pos = (const char *)data;
+    const char *end;
+    struct proxyfs_event_attr attr;
+
+    memset(event, 0, sizeof(*event));
+    if (len < sizeof(event->header)) {
+        return -EINVAL;
+    }
+    memcpy(&event->header, data, sizeof(event->header));
+    if (event->header.version != PROXYFS_EVENT_VERSION) {
+        return -EPROTO;
+    }
+    if (event->header.size < sizeof(event->header) || event->header.size > len) {
+        return -EINVAL;
+    }
+    end = pos + event->header.size;
+    pos += sizeof(event->header);
+    while (pos + sizeof(attr) <= end) {
+        memcpy(&attr, pos, sizeof(attr));
+        pos += sizeof(attr);
+        if (pos + attr.len > end) {
+            return -EINVAL;
+        }
+        switch (attr.type) {
+#define PROXYFS_EVENT_DECODE_ATTR(NAME, field, kind)                                      \
+        case PROXYFS_EVENT_ATTR_##NAME:                                                   \
+            if (proxyfs_event_decode_##kind(pos, attr.len,                                \
+                                            PROXYFS_EVENT_DECODE_ARGS_##kind(event, field)) != 0) { \
+                return -EINVAL;                                                           \
+            }                                                                             \
+            event->attrs |= PROXYFS_EVENT_ATTR_BIT(NAME);                                 \
+            break;
+        PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_DECODE_ATTR)
+#undef PROXYFS_EVENT_DECODE_ATTR
+        default:
+            break;
+        }
+        pos += attr.len;
+    }
+    return (int)event->header.size;
+}
+
+#endif //  !__PROXYFS_EVENT_DECODE_H__
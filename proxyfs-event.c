@@ -0,0 +1,520 @@
+// File		:proxyfs-event.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 13:25:09 2026
+#include <linux/cred.h>
+#include <linux/sched.h>
+#include <linux/timekeeping.h>
+#include <linux/kdev_t.h>
+#include <linux/dcache.h>
+#include <linux/jiffies.h>
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include "proxyfs.h"
+
+//
+// Attributes every operation carries, see `PROXYFS_EVENT_OPS()`
+static const u32 proxyfs_event_op_attrs[PROXYFS_EVENT_OP_COUNT] = {
+#define PROXYFS_EVENT_OP_ATTRS(NAME, name, CLASS, attrs) [PROXYFS_EVENT_OP_##NAME] = (attrs),
+    PROXYFS_EVENT_OPS(PROXYFS_EVENT_OP_ATTRS)
+#undef PROXYFS_EVENT_OP_ATTRS
+};
+
+//
+// Class of every operation, see `PROXYFS_EVENT_OPS()`
+static const u8 proxyfs_event_op_classes[PROXYFS_EVENT_OP_COUNT] = {
+#define PROXYFS_EVENT_OP_CLASS(NAME, name, CLASS, attrs) [PROXYFS_EVENT_OP_##NAME] = PROXYFS_EVENT_CLASS_##CLASS,
+    PROXYFS_EVENT_OPS(PROXYFS_EVENT_OP_CLASS)
+#undef PROXYFS_EVENT_OP_CLASS
+};
+
+static atomic64_t proxyfs_event_seq = ATOMIC64_INIT(0);
+
+//
+// Class of the operation of a record, unknown operations are taken as
+// control records
+enum proxyfs_event_class proxyfs_event_op_class(unsigned int op)
+{
+    return op < PROXYFS_EVENT_OP_COUNT ? proxyfs_event_op_classes[op] : PROXYFS_EVENT_CLASS_CONTROL;
+}
+
+static size_t proxyfs_event_put_attr(char *buffer,
+                                     size_t pos,
+                                     u16 type,
+                                     const void *value,
+                                     size_t len)
+{
+    struct proxyfs_event_attr attr = {
+        .type = type,
+        .len = len,
+    };
+
+    memcpy(buffer + pos, &attr, sizeof(attr));
+    memcpy(buffer + pos + sizeof(attr), value, len);
+    return pos + sizeof(attr) + len;
+}
+
+static size_t proxyfs_event_put_string(char *buffer,
+                                       size_t pos,
+                                       u16 type,
+                                       const char *value,
+                                       size_t len)
+{
+    if (value == NULL) {
+        return pos;
+    }
+    return proxyfs_event_put_attr(buffer, pos, type, value, len);
+}
+
+static size_t proxyfs_event_put_u32(char *buffer,
+                                    size_t pos,
+                                    u16 type,
+                                    u32 value)
+{
+    return proxyfs_event_put_attr(buffer, pos, type, &value, sizeof(value));
+}
+
+static size_t proxyfs_event_put_u64(char *buffer,
+                                    size_t pos,
+                                    u16 type,
+                                    u64 value)
+{
+    return proxyfs_event_put_attr(buffer, pos, type, &value, sizeof(value));
+}
+
+//
+// Number of the path attributes (`string` ones), every one of them has
+// its own part of the scratch buffer
+#define PROXYFS_EVENT_COUNT_string 1
+#define PROXYFS_EVENT_COUNT_text   0
+#define PROXYFS_EVENT_COUNT_u32    0
+#define PROXYFS_EVENT_COUNT_u64    0
+#define PROXYFS_EVENT_COUNT(NAME, field, kind) + PROXYFS_EVENT_COUNT_##kind
+#define PROXYFS_EVENT_PATHS (0 PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_COUNT))
+
+//
+// Scratch buffer of a CPU the paths are rendered to (a part of the size
+// of the largest buffer of the pool per path attribute)
+//
+// Note: the buffer is used with preemption disabled, thus the paths are
+//       rendered without taking buffers of the pool from the records
+static DEFINE_PER_CPU(char *, proxyfs_event_scratch);
+static unsigned int proxyfs_event_scratch_size;
+
+//
+// Render path of the dentry (relative to proxyfs root) to the part of the
+// scratch buffer, NULL is returned if the path can't be rendered
+static const char *proxyfs_event_render_path(struct dentry *dentry,
+                                             char *scratch,
+                                             unsigned int path)
+{
+    char *res;
+
+    if (dentry == NULL || scratch == NULL) {
+        return NULL;
+    }
+    res = dentry_path_raw(dentry,
+                          scratch + path * proxyfs_event_scratch_size,
+                          proxyfs_event_scratch_size);
+    return IS_ERR(res) ? NULL : res;
+}
+
+#define PROXYFS_EVENT_RENDER_string(NAME, field)                                              \
+    if ((attrs & PROXYFS_EVENT_ATTR_BIT(NAME)) && args->field != NULL) {                      \
+        strings[PROXYFS_EVENT_ATTR_##NAME] = proxyfs_event_render_path(args->field,           \
+                                                                       scratch,               \
+                                                                       path++);               \
+        if (strings[PROXYFS_EVENT_ATTR_##NAME] == NULL) {                                     \
+            flags |= PROXYFS_EVENT_FLAG_TRUNCATED;                                            \
+        } else {                                                                              \
+            lens[PROXYFS_EVENT_ATTR_##NAME] = strlen(strings[PROXYFS_EVENT_ATTR_##NAME]);     \
+        }                                                                                     \
+    }
+#define PROXYFS_EVENT_RENDER_text(NAME, field)                                                \
+    if ((attrs & PROXYFS_EVENT_ATTR_BIT(NAME)) && args->field != NULL) {                      \
+        strings[PROXYFS_EVENT_ATTR_##NAME] = args->field;                                     \
+        lens[PROXYFS_EVENT_ATTR_##NAME] = strlen(args->field);                                \
+    }
+#define PROXYFS_EVENT_RENDER_u32(NAME, field)
+#define PROXYFS_EVENT_RENDER_u64(NAME, field)
+
+#define PROXYFS_EVENT_SIZE_string(NAME, field)                                                \
+    if (strings[PROXYFS_EVENT_ATTR_##NAME] != NULL) {                                         \
+        size += sizeof(struct proxyfs_event_attr) + lens[PROXYFS_EVENT_ATTR_##NAME];          \
+    }
+#define PROXYFS_EVENT_SIZE_text(NAME, field) PROXYFS_EVENT_SIZE_string(NAME, field)
+#define PROXYFS_EVENT_SIZE_u32(NAME, field)                                                   \
+    if (attrs & PROXYFS_EVENT_ATTR_BIT(NAME)) {                                               \
+        size += sizeof(struct proxyfs_event_attr) + sizeof(u32);                              \
+    }
+#define PROXYFS_EVENT_SIZE_u64(NAME, field)                                                   \
+    if (attrs & PROXYFS_EVENT_ATTR_BIT(NAME)) {                                               \
+        size += sizeof(struct proxyfs_event_attr) + sizeof(u64);                              \
+    }
+
+#define PROXYFS_EVENT_PUT_string(NAME, field)                                                 \
+    pos = proxyfs_event_put_string(buffer, pos, PROXYFS_EVENT_ATTR_##NAME,                    \
+                                   strings[PROXYFS_EVENT_ATTR_##NAME],                        \
+                                   lens[PROXYFS_EVENT_ATTR_##NAME]);
+#define PROXYFS_EVENT_PUT_text(NAME, field) PROXYFS_EVENT_PUT_string(NAME, field)
+#define PROXYFS_EVENT_PUT_u32(NAME, field)                                                    \
+    if (attrs & PROXYFS_EVENT_ATTR_BIT(NAME)) {                                               \
+        pos = proxyfs_event_put_u32(buffer, pos, PROXYFS_EVENT_ATTR_##NAME, args->field);     \
+    }
+#define PROXYFS_EVENT_PUT_u64(NAME, field)                                                    \
+    if (attrs & PROXYFS_EVENT_ATTR_BIT(NAME)) {                                               \
+        pos = proxyfs_event_put_u64(buffer, pos, PROXYFS_EVENT_ATTR_##NAME, args->field);     \
+    }
+
+#define PROXYFS_EVENT_RENDER(NAME, field, kind) PROXYFS_EVENT_RENDER_##kind(NAME, field)
+#define PROXYFS_EVENT_SIZE(NAME, field, kind)   PROXYFS_EVENT_SIZE_##kind(NAME, field)
+#define PROXYFS_EVENT_PUT(NAME, field, kind)    PROXYFS_EVENT_PUT_##kind(NAME, field)
+
+//
+// Cut the string attributes till the record of `size` bytes fits the
+// largest buffer of the pool, the longest string is cut first and its
+// leading part is dropped (the end of a path names the file); the new
+// size is returned
+static size_t proxyfs_event_clamp(const char **strings,
+                                  size_t *lens,
+                                  size_t size,
+                                  size_t max_size)
+{
+    size_t cut;
+    int longest;
+    int i;
+
+    while (size > max_size) {
+        longest = 0;
+        for (i = 1; i < PROXYFS_EVENT_ATTR_COUNT; i++) {
+            if (lens[i] > lens[longest]) {
+                longest = i;
+            }
+        }
+        if (lens[longest] == 0) {
+            //
+            // Note: the record can't be cut any more, it is dropped
+            break;
+        }
+        cut = min(size - max_size, lens[longest]);
+        strings[longest] += cut;
+        lens[longest] -= cut;
+        size -= cut;
+    }
+    return size;
+}
+
+//
+// Backpressure policy of the events not bound to a mount
+static struct proxyfs_backpressure proxyfs_event_backpressure;
+
+//
+// Allocate a buffer for the event, the exhausted pool is handled
+// according to the backpressure policy
+static void *proxyfs_event_alloc(size_t size,
+                                 struct proxyfs_backpressure *bp,
+                                 enum proxyfs_drop_reason *reason)
+{
+    struct proxyfs_buffer_pool *buffer_pool = proxyfs_context_get_buffer_pool();
+    unsigned long generation;
+    long timeout;
+    void *buffer;
+
+    if ((buffer = proxyfs_buffer_pool_alloc(buffer_pool, size)) != NULL) {
+        return buffer;
+    }
+    *reason = PROXYFS_DROP_POOL;
+    switch (bp->policy) {
+    case PROXYFS_BACKPRESSURE_DROP_OLDEST:
+        //
+        // Note: the buffer of the oldest queued event is released to the
+        //       magazine of the current CPU, thus it is reused right away
+        if (proxyfs_queue_drop_oldest()) {
+            proxyfs_backpressure_drop(bp, PROXYFS_DROP_POOL);
+            buffer = proxyfs_buffer_pool_alloc(buffer_pool, size);
+        }
+        break;
+    case PROXYFS_BACKPRESSURE_BLOCK:
+        //
+        // Buffers come back to the pool as the workers drain the queues,
+        // without the queues nobody would wake the handler up
+        if (!proxyfs_queue_is_enabled()) {
+            break;
+        }
+        timeout = usecs_to_jiffies(bp->timeout_us);
+        while (buffer == NULL && timeout > 0) {
+            generation = proxyfs_queue_generation();
+            if ((buffer = proxyfs_buffer_pool_alloc(buffer_pool, size)) == NULL) {
+                timeout = proxyfs_queue_wait(generation, timeout);
+            }
+        }
+        *reason = PROXYFS_DROP_TIMEOUT;
+        break;
+    default:
+        break;
+    }
+    return buffer;
+}
+
+//
+// Encode the event to a buffer of the pool and pass it to the delivery,
+// false is returned if the event is dropped (`reason` is set then)
+static bool proxyfs_event_submit(enum proxyfs_event_op op,
+                                 const struct proxyfs_event_args *args,
+                                 unsigned int group,
+                                 struct proxyfs_backpressure *bp,
+                                 enum proxyfs_drop_reason *reason)
+{
+    struct proxyfs_buffer_pool *buffer_pool = proxyfs_context_get_buffer_pool();
+    const char *strings[PROXYFS_EVENT_ATTR_COUNT];
+    size_t lens[PROXYFS_EVENT_ATTR_COUNT];
+    struct proxyfs_event_header *header;
+    char *scratch;
+    char *buffer = NULL;
+    u32 attrs = proxyfs_event_op_attrs[op];
+    size_t limit = proxyfs_buffer_pool_max_size(buffer_pool);
+    size_t size;
+    size_t pos;
+    unsigned int path;
+    u8 coalesced = 0;
+    u8 flags;
+    bool res = false;
+
+    //
+    // Coalesced record: offset and length describe the range touched by
+    // all the calls (an operation carrying CALLS itself is not merged)
+    if (args->calls != 0 && !(attrs & PROXYFS_EVENT_ATTR_BIT(CALLS))) {
+        attrs |= PROXYFS_EVENT_ATTR_BIT(BYTES) | PROXYFS_EVENT_ATTR_BIT(CALLS);
+        coalesced = PROXYFS_EVENT_FLAG_COALESCED;
+    }
+
+    //
+    // The paths are rendered to the scratch buffer of the CPU and the
+    // record is encoded before the CPU is released; if the pool is
+    // exhausted the buffer is taken according to the backpressure policy
+    // (it may sleep) and the paths are rendered once again to fit it
+    while (true) {
+        memset(strings, 0, sizeof(strings));
+        memset(lens, 0, sizeof(lens));
+        size = sizeof(struct proxyfs_event_header);
+        flags = coalesced;
+        path = 0;
+        scratch = get_cpu_var(proxyfs_event_scratch);
+
+        PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_RENDER)
+        PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_SIZE)
+        //
+        // Note: the paths are rendered to the largest buffers, thus a record
+        //       carrying two of them may not fit the pool (or the buffer
+        //       taken for the record rendered before)
+        if (size > limit) {
+            size = proxyfs_event_clamp(strings, lens, size, limit);
+            flags |= PROXYFS_EVENT_FLAG_TRUNCATED;
+        }
+        if (buffer != NULL || (buffer = proxyfs_buffer_pool_alloc(buffer_pool, size)) != NULL) {
+            break;
+        }
+        put_cpu_var(proxyfs_event_scratch);
+        if ((buffer = proxyfs_event_alloc(size, bp, reason)) == NULL) {
+            return false;
+        }
+        limit = size;
+    }
+
+    header = (struct proxyfs_event_header *)buffer;
+    header->version = PROXYFS_EVENT_VERSION;
+    header->flags = flags;
+    header->op = op;
+    header->size = size;
+    header->seq = atomic64_inc_return(&proxyfs_event_seq);
+    header->timestamp = args->timestamp ? args->timestamp : ktime_get_real_ns();
+    header->ino = args->inode ? args->inode->i_ino : 0;
+    header->dev = args->inode ? new_encode_dev(args->inode->i_sb->s_dev) : 0;
+    if (args->pid != 0) {
+        header->pid = args->pid;
+        header->tgid = args->tgid;
+        header->uid = args->uid;
+    } else {
+        header->pid = task_pid_nr(current);
+        header->tgid = task_tgid_nr(current);
+        header->uid = from_kuid(&init_user_ns, current_fsuid());
+    }
+    pos = sizeof(struct proxyfs_event_header);
+
+    PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_PUT)
+
+    put_cpu_var(proxyfs_event_scratch);
+
+    switch (proxyfs_queue_push(buffer, pos, group, bp)) {
+    case 0:
+        //
+        // The buffer is released by the worker
+        res = true;
+        break;
+    case -ENODEV:
+        proxyfs_context_send_msg(buffer, pos, group);
+        proxyfs_buffer_pool_free(buffer_pool, buffer);
+        res = true;
+        break;
+    case -ETIMEDOUT:
+        *reason = PROXYFS_DROP_TIMEOUT;
+        proxyfs_buffer_pool_free(buffer_pool, buffer);
+        break;
+    default:
+        *reason = PROXYFS_DROP_QUEUE;
+        proxyfs_buffer_pool_free(buffer_pool, buffer);
+        break;
+    }
+    return res;
+}
+
+//
+// Encode the event and deliver it to the clients bypassing the coalescing
+void proxyfs_event_deliver(enum proxyfs_event_op op,
+                           const struct proxyfs_event_args *args)
+{
+    struct proxyfs_backpressure *bp;
+    enum proxyfs_drop_reason reason;
+    unsigned int group = PROXYFS_EVENT_CLASS_GROUP(proxyfs_event_op_classes[op]);
+    long lost;
+
+    //
+    // Note: events over the budget are suppressed deliberately, thus they
+    //       are not reported by "lost" markers
+    if (!proxyfs_ratelimit_admit(args)) {
+        return;
+    }
+    if ((bp = proxyfs_sb_backpressure(args->inode ? args->inode->i_sb : NULL)) == NULL) {
+        bp = &proxyfs_event_backpressure;
+    }
+    if (!proxyfs_backpressure_admit(bp)) {
+        return;
+    }
+    //
+    // Consumers are informed about the events dropped before this one
+    if ((lost = atomic_long_xchg(&bp->lost, 0)) != 0) {
+        if (!proxyfs_event_submit(PROXYFS_EVENT_OP_LOST,
+                                  &(struct proxyfs_event_args) {
+                                      .inode = args->inode,
+                                      .lost = lost,
+                                  },
+                                  group,
+                                  bp,
+                                  &reason)) {
+            atomic_long_add(lost, &bp->lost);
+        }
+    }
+    if (!proxyfs_event_submit(op, args, group, bp, &reason)) {
+        proxyfs_backpressure_drop(bp, reason);
+    }
+}
+
+//
+// Encode the permission request and deliver it to the clients bypassing
+// the coalescing and the rate limiting, false is returned if it has not
+// been sent (thus nobody is going to answer it)
+bool proxyfs_event_request(enum proxyfs_event_op op,
+                           const struct proxyfs_event_args *args)
+{
+    struct proxyfs_backpressure *bp;
+    enum proxyfs_drop_reason reason;
+    unsigned int group = PROXYFS_EVENT_CLASS_GROUP(proxyfs_event_op_classes[op]);
+
+    if ((bp = proxyfs_sb_backpressure(args->inode ? args->inode->i_sb : NULL)) == NULL) {
+        bp = &proxyfs_event_backpressure;
+    }
+    if (!proxyfs_event_submit(op, args, group, bp, &reason)) {
+        proxyfs_backpressure_drop(bp, reason);
+        return false;
+    }
+    return true;
+}
+
+//
+// Encode the control record and deliver it to the clients bypassing the
+// coalescing, the filters and the rate limiting, false is returned if it
+// has not been sent
+bool proxyfs_event_notify(enum proxyfs_event_op op,
+                          const struct proxyfs_event_args *args)
+{
+    struct proxyfs_backpressure *bp;
+    enum proxyfs_drop_reason reason;
+    unsigned int group = PROXYFS_EVENT_CLASS_GROUP(proxyfs_event_op_classes[op]);
+
+    if (!proxyfs_context_check_is_running() ||
+        !proxyfs_context_has_consumer(group)) {
+        return false;
+    }
+    if ((bp = proxyfs_sb_backpressure(args->inode ? args->inode->i_sb : NULL)) == NULL) {
+        bp = &proxyfs_event_backpressure;
+    }
+    if (!proxyfs_event_submit(op, args, group, bp, &reason)) {
+        proxyfs_backpressure_drop(bp, reason);
+        return false;
+    }
+    return true;
+}
+
+//
+// Encode the event and deliver it to the clients, repeated operations
+// are merged by the coalescing stage
+void proxyfs_event_emit(enum proxyfs_event_op op,
+                        const struct proxyfs_event_args *args)
+{
+    if (op >= PROXYFS_EVENT_OP_COUNT || args == NULL) {
+        return;
+    }
+    //
+    // Note: the event is not even formatted if nobody is going to
+    //       receive its class
+    if (!proxyfs_context_check_is_running() ||
+        !proxyfs_context_has_consumer(PROXYFS_EVENT_CLASS_GROUP(proxyfs_event_op_classes[op]))) {
+        return;
+    }
+    if (!proxyfs_filter_check(op, args)) {
+        return;
+    }
+    if (proxyfs_coalesce_event(op, args)) {
+        return;
+    }
+    proxyfs_event_deliver(op, args);
+}
+
+//
+// Allocate the scratch buffers the paths are rendered to, must be called
+// once the pool is set up (the paths are as long as its largest buffer)
+int proxyfs_event_init(void)
+{
+    char *scratch;
+    int cpu;
+
+    proxyfs_event_scratch_size = proxyfs_buffer_pool_max_size(proxyfs_context_get_buffer_pool());
+    for_each_possible_cpu(cpu) {
+        if ((scratch = kvmalloc_node(array_size(PROXYFS_EVENT_PATHS, proxyfs_event_scratch_size),
+                                     GFP_KERNEL,
+                                     cpu_to_node(cpu))) == NULL) {
+            pr_err("%s: unable to allocate event scratch buffer of CPU %d\n",
+                   MODULE_NAME,
+                   cpu);
+            proxyfs_event_release();
+            return -ENOMEM;
+        }
+        per_cpu(proxyfs_event_scratch, cpu) = scratch;
+    }
+    return 0;
+}
+
+//
+// Note: must be called when no event is going to be emitted
+void proxyfs_event_release(void)
+{
+    int cpu;
+
+    //
+    // Scratch buffers are used with preemption disabled, thus nobody
+    // touches them after the grace period
+    synchronize_rcu();
+    for_each_possible_cpu(cpu) {
+        kvfree(per_cpu(proxyfs_event_scratch, cpu));
+        per_cpu(proxyfs_event_scratch, cpu) = NULL;
+    }
+}
@@ -0,0 +1,213 @@
+// File		:proxyfs-event.h
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 13:25:09 2026
+//
+// Binary format of the events sent to userspace, the header is shared
+// with userspace consumers (see `proxyfs-event-decode.h`)
+#ifndef __PROXYFS_EVENT_H__
+#define __PROXYFS_EVENT_H__
+#include <linux/types.h>
+#include <linux/filter.h>
+
+#define PROXYFS_EVENT_VERSION 1
+
+//
+// Attributes which can follow the fixed header of an event:
+//   X(NAME, field, kind)
+// where `kind` is one of `string` (path of a dentry), `text` (a string
+// given as is), `u32` or `u64`
+//
+// Note: new attributes must be appended, their values are part of the ABI
+#define PROXYFS_EVENT_ATTRS(X)          \
+    X(PATH,     path,     string)       \
+    X(NEW_PATH, new_path, string)       \
+    X(OFFSET,   offset,   u64)          \
+    X(LENGTH,   length,   u64)          \
+    X(FLAGS,    flags,    u32)          \
+    X(LOST,     lost,     u64)          \
+    X(BYTES,    bytes,    u64)          \
+    X(CALLS,    calls,    u32)          \
+    X(REQUEST,  request,  u64)          \
+    X(OPERATION, operation, text)       \
+    X(FSTYPE,   fstype,   text)         \
+    X(LATENCY,  latency,  u64)
+
+enum proxyfs_event_attr_type {
+    PROXYFS_EVENT_ATTR_NONE = 0,
+#define PROXYFS_EVENT_ATTR_ENUM(NAME, field, kind) PROXYFS_EVENT_ATTR_##NAME,
+    PROXYFS_EVENT_ATTRS(PROXYFS_EVENT_ATTR_ENUM)
+#undef PROXYFS_EVENT_ATTR_ENUM
+    PROXYFS_EVENT_ATTR_COUNT
+};
+
+#define PROXYFS_EVENT_ATTR_BIT(NAME) (1U << PROXYFS_EVENT_ATTR_##NAME)
+
+//
+// Classes of the operations, every class is delivered to its own NETLINK
+// multicast group, thus a subscriber receives only classes it joined:
+//   X(NAME, name)
+//
+// Note: new classes must be appended, their values are part of the ABI
+#define PROXYFS_EVENT_CLASSES(X)        \
+    X(FILE,      file)                  \
+    X(DATA,      data)                  \
+    X(NAMESPACE, namespace)             \
+    X(ATTR,      attr)                  \
+    X(CONTROL,   control)               \
+    X(PERMISSION, permission)
+
+enum proxyfs_event_class {
+#define PROXYFS_EVENT_CLASS_ENUM(NAME, name) PROXYFS_EVENT_CLASS_##NAME,
+    PROXYFS_EVENT_CLASSES(PROXYFS_EVENT_CLASS_ENUM)
+#undef PROXYFS_EVENT_CLASS_ENUM
+    PROXYFS_EVENT_CLASS_COUNT
+};
+
+//
+// Note: control records (e.g. `PROXYFS_EVENT_OP_LOST`) are sent to the
+//       group of the event they precede, not to the group of their class
+//
+// NETLINK multicast group of the class (groups are numbered from 1)
+#define PROXYFS_EVENT_CLASS_GROUP(class) ((class) + 1)
+
+//
+// Operations reported by events, their classes and attributes every
+// operation carries:
+//   X(NAME, name, CLASS, attributes)
+//
+// Note: new operations must be appended, their values are part of the ABI
+#define PROXYFS_EVENT_OPS(X)                                                                              \
+    X(OPEN,    open,    FILE,      PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(FLAGS))          \
+    X(RELEASE, release, FILE,      PROXYFS_EVENT_ATTR_BIT(PATH))                                          \
+    X(READ,    read,    DATA,      PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(OFFSET) |        \
+                                   PROXYFS_EVENT_ATTR_BIT(LENGTH))                                        \
+    X(WRITE,   write,   DATA,      PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(OFFSET) |        \
+                                   PROXYFS_EVENT_ATTR_BIT(LENGTH))                                        \
+    X(FSYNC,   fsync,   DATA,      PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(FLAGS))          \
+    X(CREATE,  create,  NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(FLAGS))          \
+    X(UNLINK,  unlink,  NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH))                                          \
+    X(MKDIR,   mkdir,   NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(FLAGS))          \
+    X(RMDIR,   rmdir,   NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH))                                          \
+    X(RENAME,  rename,  NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(NEW_PATH) |      \
+                                   PROXYFS_EVENT_ATTR_BIT(FLAGS))                                         \
+    X(SETATTR, setattr, ATTR,      PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(LENGTH) |        \
+                                   PROXYFS_EVENT_ATTR_BIT(FLAGS))                                         \
+    X(LINK,    link,    NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(NEW_PATH))       \
+    X(SYMLINK, symlink, NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH))                                          \
+    X(MKNOD,   mknod,   NAMESPACE, PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(FLAGS))          \
+    X(LOST,    lost,    CONTROL,   PROXYFS_EVENT_ATTR_BIT(LOST))                                          \
+    X(OPEN_PERM, open_perm, PERMISSION, PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(FLAGS) |     \
+                                        PROXYFS_EVENT_ATTR_BIT(REQUEST))                                  \
+    X(EXEC_PERM, exec_perm, PERMISSION, PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(FLAGS) |     \
+                                        PROXYFS_EVENT_ATTR_BIT(REQUEST))                                  \
+    X(TRUNCATE_PERM, truncate_perm, PERMISSION, PROXYFS_EVENT_ATTR_BIT(PATH) |                            \
+                                                PROXYFS_EVENT_ATTR_BIT(LENGTH) |                          \
+                                                PROXYFS_EVENT_ATTR_BIT(REQUEST))                          \
+    X(SLOW,    slow,    CONTROL,   PROXYFS_EVENT_ATTR_BIT(PATH) | PROXYFS_EVENT_ATTR_BIT(OPERATION) |     \
+                                   PROXYFS_EVENT_ATTR_BIT(FSTYPE) | PROXYFS_EVENT_ATTR_BIT(LATENCY))      \
+    X(SLOW_SUMMARY, slow_summary, CONTROL, PROXYFS_EVENT_ATTR_BIT(OPERATION) |                            \
+                                           PROXYFS_EVENT_ATTR_BIT(CALLS) |                                \
+                                           PROXYFS_EVENT_ATTR_BIT(LATENCY))
+
+enum proxyfs_event_op {
+#define PROXYFS_EVENT_OP_ENUM(NAME, name, CLASS, attrs) PROXYFS_EVENT_OP_##NAME,
+    PROXYFS_EVENT_OPS(PROXYFS_EVENT_OP_ENUM)
+#undef PROXYFS_EVENT_OP_ENUM
+    PROXYFS_EVENT_OP_COUNT
+};
+
+//
+// Registration message of a unicast client (payload of a NETLINK message
+// sent to the module), legacy clients send a text and receive all classes
+//
+// Note: messages of processes lacking CAP_NET_ADMIN are ignored
+#define PROXYFS_CLIENT_HELLO_MAGIC 0x50524659 // "PRFY"
+
+struct proxyfs_client_hello {
+    __u32 magic;
+    __u32 version;
+    //
+    // Bit mask of the event classes to be received (bit of a class is
+    // `1 << PROXYFS_EVENT_CLASS_*`), 0 means all classes but PERMISSION
+    // (a client receiving it has to answer the requests, see below)
+    __u32 classes;
+    //
+    // Classic BPF program of `filter_len` instructions (0 if there is no
+    // program) run over the header of every event before it is sent to
+    // the client, events the program returns 0 for are not sent to the
+    // client (multicast subscribers and the ring consumer receive them)
+    //
+    // Note: the program sees the header as a packet, its fields are in
+    //       network byte order; control records and permission requests
+    //       are not passed to the program
+    __u16 filter_len;
+    __u16 reserved;
+    struct sock_filter filter[];
+};
+
+//
+// Verdicts of the permission requests (events of PERMISSION class), the
+// payload of a NETLINK message sent by the registered client carries any
+// number of them; the task issued a request waits for its verdict until
+// the timeout, then the default verdict is applied
+#define PROXYFS_CLIENT_VERDICT_MAGIC 0x50524656 // "PRFV"
+
+#define PROXYFS_PERM_ALLOW 1
+#define PROXYFS_PERM_DENY  2
+
+struct proxyfs_client_verdict {
+    //
+    // REQUEST attribute of the permission request
+    __u64 request;
+    //
+    // `PROXYFS_PERM_ALLOW` or `PROXYFS_PERM_DENY`
+    __u32 response;
+    __u32 reserved;
+};
+
+struct proxyfs_client_verdicts {
+    __u32 magic;
+    __u32 count;
+    struct proxyfs_client_verdict verdicts[];
+};
+
+//
+// Flags of the event header
+#define PROXYFS_EVENT_FLAG_TRUNCATED 0x01 // an attribute did not fit the record
+//
+// Note: a coalesced record merges repeated calls of the operation, it
+//       carries BYTES and CALLS attributes and its OFFSET and LENGTH
+//       describe the range touched by all the calls
+#define PROXYFS_EVENT_FLAG_COALESCED 0x02 // the record merges several calls
+
+//
+// Note: a SLOW record reports a call which has taken longer than the
+//       threshold of its operation (LATENCY is its duration in ns); the
+//       slow calls over the reporting budget are summarized by
+//       SLOW_SUMMARY records, CALLS counts them and LATENCY is the
+//       longest one
+//
+// Fixed part of every event, `size` covers the header and all attributes
+struct proxyfs_event_header {
+    __u8 version;
+    __u8 flags;
+    __u16 op;
+    __u32 size;
+    __u64 seq;
+    __u64 timestamp;
+    __u64 ino;
+    __u32 dev;
+    __u32 pid;
+    __u32 tgid;
+    __u32 uid;
+} __attribute__((packed));
+
+//
+// Attribute (TLV), `len` bytes of the value follow it without padding;
+// strings are not NUL terminated
+struct proxyfs_event_attr {
+    __u16 type;
+    __u16 len;
+} __attribute__((packed));
+
+#endif //  !__PROXYFS_EVENT_H__
@@ -19,10 +19,12 @@ static loff_t proxyfs_llseek(struct file *file,
                              loff_t offset,
                              int whence)
 {
-    PROXYFS_DEBUG("name=%s, offset=%lld, whence=%d\n", file->f_path.dentry->d_name.name, offset, whence);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_LLSEEK);
+    PROXYFS_STATS_ARGS(file_inode(file), offset, 0, whence);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->llseek) {
-        return lower_file->f_op->llseek(lower_file, offset, whence);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->llseek(lower_file, offset, whence));
     }
     return -ENOSYS;
 }
@@ -33,8 +35,21 @@ static ssize_t proxyfs_read(struct file *file,
                             size_t count,
                             loff_t *ppos)
 {
-    PROXYFS_DEBUG("name=%s, count=%zu\n", file->f_path.dentry->d_name.name, count);
-    return kernel_read(proxyfs_lower_file(file), buf, count, ppos);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_READ);
+    PROXYFS_STATS_ARGS(file_inode(file), ppos ? *ppos : 0, count, 0);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
+    loff_t pos = ppos ? *ppos : 0;
+    ssize_t ret = PROXYFS_STATS_LOWER(kernel_read(proxyfs_lower_file(file), buf, count, ppos));
+    if (ret >= 0) {
+        proxyfs_top_account(file->f_path.dentry, file_inode(file), ret);
+        proxyfs_event_read(&(struct proxyfs_event_args) {
+                .inode = file_inode(file),
+                .path = file->f_path.dentry,
+                .offset = pos,
+                .length = ret,
+            });
+    }
+    return ret;
 }
 
 // write()
@@ -43,21 +58,49 @@ static ssize_t proxyfs_write(struct file *file,
                              size_t count,
                              loff_t *ppos)
 {
-    PROXYFS_DEBUG("name=%s, count=%zu\n", file->f_path.dentry->d_name.name, count);
-    return kernel_write(proxyfs_lower_file(file), buf, count, ppos);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_WRITE);
+    PROXYFS_STATS_ARGS(file_inode(file), ppos ? *ppos : 0, count, 0);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
+    loff_t pos = ppos ? *ppos : 0;
+    ssize_t ret = PROXYFS_STATS_LOWER(kernel_write(proxyfs_lower_file(file), buf, count, ppos));
+    if (ret > 0) {
+        proxyfs_perm_cache_invalidate(file_inode(file));
+    }
+    if (ret >= 0) {
+        proxyfs_top_account(file->f_path.dentry, file_inode(file), ret);
+        proxyfs_event_write(&(struct proxyfs_event_args) {
+                .inode = file_inode(file),
+                .path = file->f_path.dentry,
+                .offset = pos,
+                .length = ret,
+            });
+    }
+    return ret;
 }
 
 // read_iter
 static ssize_t proxyfs_read_iter(struct kiocb *iocb,
                                  struct iov_iter *to)
 {
+    PROXYFS_STATS(file_inode(iocb->ki_filp)->i_sb, FILE_READ_ITER);
     struct file *file = iocb->ki_filp;
-    PROXYFS_DEBUG("name=%s\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS_ARGS(file_inode(file), iocb->ki_pos, iov_iter_count(to), iocb->ki_flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->read_iter) {
         struct kiocb lower_iocb = *iocb;
         lower_iocb.ki_filp = lower_file;
-        return lower_file->f_op->read_iter(&lower_iocb, to);
+        ssize_t ret = PROXYFS_STATS_LOWER(lower_file->f_op->read_iter(&lower_iocb, to));
+        if (ret >= 0) {
+            proxyfs_top_account(file->f_path.dentry, file_inode(file), ret);
+            proxyfs_event_read(&(struct proxyfs_event_args) {
+                    .inode = file_inode(file),
+                    .path = file->f_path.dentry,
+                    .offset = iocb->ki_pos,
+                    .length = ret,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -66,13 +109,28 @@ static ssize_t proxyfs_read_iter(struct kiocb *iocb,
 static ssize_t proxyfs_write_iter(struct kiocb *iocb,
                                   struct iov_iter *from)
 {
+    PROXYFS_STATS(file_inode(iocb->ki_filp)->i_sb, FILE_WRITE_ITER);
     struct file *file = iocb->ki_filp;
-    PROXYFS_DEBUG("name=%s\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS_ARGS(file_inode(file), iocb->ki_pos, iov_iter_count(from), iocb->ki_flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->write_iter) {
         struct kiocb lower_iocb = *iocb;
         lower_iocb.ki_filp = lower_file;
-        return lower_file->f_op->write_iter(&lower_iocb, from);
+        ssize_t ret = PROXYFS_STATS_LOWER(lower_file->f_op->write_iter(&lower_iocb, from));
+        if (ret > 0) {
+            proxyfs_perm_cache_invalidate(file_inode(file));
+        }
+        if (ret >= 0) {
+            proxyfs_top_account(file->f_path.dentry, file_inode(file), ret);
+            proxyfs_event_write(&(struct proxyfs_event_args) {
+                    .inode = file_inode(file),
+                    .path = file->f_path.dentry,
+                    .offset = iocb->ki_pos,
+                    .length = ret,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -82,13 +140,15 @@ static int proxyfs_iopoll(struct kiocb *kiocb,
                           struct io_comp_batch *batch,
                           unsigned int flags)
 {
+    PROXYFS_STATS(file_inode(kiocb->ki_filp)->i_sb, FILE_IOPOLL);
     struct file *file = kiocb->ki_filp;
-    PROXYFS_DEBUG("name=%s, flags=0x%x\n", file->f_path.dentry->d_name.name, flags);
+    PROXYFS_STATS_ARGS(file_inode(file), kiocb->ki_pos, 0, flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->iopoll) {
         struct kiocb lower_iocb = *kiocb;
         lower_iocb.ki_filp = lower_file;
-        return lower_file->f_op->iopoll(&lower_iocb, batch, flags);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->iopoll(&lower_iocb, batch, flags));
     }
     return -ENOSYS;
 }
@@ -97,10 +157,12 @@ static int proxyfs_iopoll(struct kiocb *kiocb,
 static int proxyfs_iterate_shared(struct file *file,
                                   struct dir_context *ctx)
 {
-    PROXYFS_DEBUG("name=%s\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_ITERATE_SHARED);
+    PROXYFS_STATS_ARGS(file_inode(file), ctx->pos, 0, 0);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->iterate_shared) {
-        return lower_file->f_op->iterate_shared(lower_file, ctx);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->iterate_shared(lower_file, ctx));
     }
     return -ENOSYS;
 }
@@ -109,10 +171,12 @@ static int proxyfs_iterate_shared(struct file *file,
 static __poll_t proxyfs_poll(struct file *file,
                              struct poll_table_struct *pts)
 {
-    PROXYFS_DEBUG("name=%s\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_POLL);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, 0);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->poll) {
-        return lower_file->f_op->poll(lower_file, pts);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->poll(lower_file, pts));
     }
     return 0;
 }
@@ -122,10 +186,12 @@ static long proxyfs_unlocked_ioctl(struct file *file,
                                    unsigned int cmd,
                                    unsigned long arg)
 {
-    PROXYFS_DEBUG("name=%s, cmd=0x%x\n", file->f_path.dentry->d_name.name, cmd);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_UNLOCKED_IOCTL);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, cmd);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->unlocked_ioctl) {
-        return lower_file->f_op->unlocked_ioctl(lower_file, cmd, arg);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->unlocked_ioctl(lower_file, cmd, arg));
     }
     return -ENOTTY;
 }
@@ -135,10 +201,12 @@ static long proxyfs_compat_ioctl(struct file *file,
                                  unsigned int cmd,
                                  unsigned long arg)
 {
-    PROXYFS_DEBUG("name=%s, cmd=0x%x\n", file->f_path.dentry->d_name.name, cmd);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_COMPAT_IOCTL);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, cmd);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->compat_ioctl) {
-        return lower_file->f_op->compat_ioctl(lower_file, cmd, arg);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->compat_ioctl(lower_file, cmd, arg));
     }
     return -ENOTTY;
 }
@@ -147,10 +215,12 @@ static long proxyfs_compat_ioctl(struct file *file,
 static int proxyfs_mmap(struct file *file,
                         struct vm_area_struct *vma)
 {
-    PROXYFS_DEBUG("name=%s\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_MMAP);
+    PROXYFS_STATS_ARGS(file_inode(file), (u64)vma->vm_pgoff << PAGE_SHIFT, vma->vm_end - vma->vm_start, vma->vm_flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->mmap) {
-        return lower_file->f_op->mmap(lower_file, vma);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->mmap(lower_file, vma));
     }
     return -ENOSYS;
 }
@@ -159,18 +229,32 @@ static int proxyfs_mmap(struct file *file,
 static int proxyfs_open(struct inode *inode,
                         struct file *file)
 {
+    PROXYFS_STATS(inode->i_sb, FILE_OPEN);
     struct file *lower_file;
+    int res;
 
-    PROXYFS_DEBUG("inode=%lu, name=%s\n", inode->i_ino, file->f_path.dentry->d_name.name);
+    PROXYFS_STATS_ARGS(inode, 0, 0, file->f_flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
 
     //
-    // TBD: inform user space running monitor application `open`
-    //      routine has been called
+    // Ask the monitor if the file may be opened (executed) before the
+    // underlying FS is touched
+    res = proxyfs_perm_request((file->f_mode & FMODE_EXEC) ?
+                               PROXYFS_EVENT_OP_EXEC_PERM :
+                               PROXYFS_EVENT_OP_OPEN_PERM,
+                               &(struct proxyfs_event_args) {
+                                   .inode = inode,
+                                   .path = file->f_path.dentry,
+                                   .flags = file->f_flags,
+                               });
+    if (res != 0) {
+        return res;
+    }
 
     //
     // Invoke underlying FS to open a file and create underlying FS specific
     // `struct file` instance
-    lower_file = dentry_open(&file->f_path, file->f_flags, current_cred());
+    lower_file = PROXYFS_STATS_LOWER_PTR(dentry_open(&file->f_path, file->f_flags, current_cred()));
     if (IS_ERR(lower_file)) {
         return PTR_ERR(lower_file);
     }
@@ -188,6 +272,12 @@ static int proxyfs_open(struct inode *inode,
         return -ENOMEM;
     }
     ((struct proxyfs_file_info *)file->private_data)->lower_file = lower_file;
+    proxyfs_top_account(file->f_path.dentry, inode, 0);
+    proxyfs_event_open(&(struct proxyfs_event_args) {
+            .inode = inode,
+            .path = file->f_path.dentry,
+            .flags = file->f_flags,
+        });
     return 0;
 }
 
@@ -195,10 +285,12 @@ static int proxyfs_open(struct inode *inode,
 static int proxyfs_flush(struct file *file,
                          fl_owner_t id)
 {
-    PROXYFS_DEBUG("name=%s flush\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_FLUSH);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, 0);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->flush) {
-        return lower_file->f_op->flush(lower_file, id);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->flush(lower_file, id));
     }
     return 0;
 }
@@ -207,12 +299,18 @@ static int proxyfs_flush(struct file *file,
 static int proxyfs_release(struct inode *inode,
                            struct file *file)
 {
-    PROXYFS_DEBUG("inode=%lu, name=%s\n", inode->i_ino, file->f_path.dentry->d_name.name);
+    PROXYFS_STATS(inode->i_sb, FILE_RELEASE);
+    PROXYFS_STATS_ARGS(inode, 0, 0, file->f_flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file) {
-        fput(lower_file);
+        PROXYFS_STATS_LOWER_VOID(fput(lower_file));
     }
     kfree(file->private_data);
+    proxyfs_event_release(&(struct proxyfs_event_args) {
+            .inode = inode,
+            .path = file->f_path.dentry,
+        });
     return 0;
 }
 
@@ -222,10 +320,20 @@ static int proxyfs_fsync(struct file *file,
                          loff_t end,
                          int datasync)
 {
-    PROXYFS_DEBUG("name=%s, start=%lld, end=%lld, datasync=%d\n", file->f_path.dentry->d_name.name, start, end, datasync);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_FSYNC);
+    PROXYFS_STATS_ARGS(file_inode(file), start, end - start, datasync);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->fsync) {
-        return lower_file->f_op->fsync(lower_file, start, end, datasync);
+        int ret = PROXYFS_STATS_LOWER(lower_file->f_op->fsync(lower_file, start, end, datasync));
+        if (ret == 0) {
+            proxyfs_event_fsync(&(struct proxyfs_event_args) {
+                    .inode = file_inode(file),
+                    .path = file->f_path.dentry,
+                    .flags = datasync,
+                });
+        }
+        return ret;
     }
     return 0;
 }
@@ -235,10 +343,12 @@ static int proxyfs_fasync(int fd,
                           struct file *file,
                           int on)
 {
-    PROXYFS_DEBUG("name=%s, fd=%d, on=%d\n", file->f_path.dentry->d_name.name, fd, on);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_FASYNC);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, on);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->fasync) {
-        return lower_file->f_op->fasync(fd, lower_file, on);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->fasync(fd, lower_file, on));
     }
     return -ENOSYS;
 }
@@ -248,10 +358,12 @@ static int proxyfs_lock(struct file *file,
                         int cmd,
                         struct file_lock *fl)
 {
-    PROXYFS_DEBUG("name=%s, cmd=%d\n", file->f_path.dentry->d_name.name, cmd);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_LOCK);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, cmd);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->lock) {
-        return lower_file->f_op->lock(lower_file, cmd, fl);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->lock(lower_file, cmd, fl));
     }
     return -ENOSYS;
 }
@@ -263,10 +375,12 @@ static unsigned long proxyfs_get_unmapped_area(struct file *file,
                                                unsigned long pgoff,
                                                unsigned long flags)
 {
-    PROXYFS_DEBUG("name=%s, len=%lu\n", file->f_path.dentry->d_name.name, len);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_GET_UNMAPPED_AREA);
+    PROXYFS_STATS_ARGS(file_inode(file), (u64)pgoff << PAGE_SHIFT, len, flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->get_unmapped_area) {
-        return lower_file->f_op->get_unmapped_area(lower_file, uaddr, len, pgoff, flags);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->get_unmapped_area(lower_file, uaddr, len, pgoff, flags));
     }
     return 0;
 }
@@ -274,7 +388,6 @@ static unsigned long proxyfs_get_unmapped_area(struct file *file,
 // check_flags()
 static int proxyfs_check_flags(int flags)
 {
-    PROXYFS_DEBUG("check_flags flags=%x\n", flags);
     //
     // Usually it does nothing but can be delegated
     return 0;
@@ -285,10 +398,12 @@ static int proxyfs_flock(struct file *file,
                          int cmd,
                          struct file_lock *fl)
 {
-    PROXYFS_DEBUG("name=%s, cmd=%d\n", file->f_path.dentry->d_name.name, cmd);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_FLOCK);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, cmd);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->flock) {
-        return lower_file->f_op->flock(lower_file, cmd, fl);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->flock(lower_file, cmd, fl));
     }
     return -ENOSYS;
 }
@@ -300,10 +415,12 @@ static ssize_t proxyfs_splice_write(struct pipe_inode_info *pipe,
                                     size_t len,
                                     unsigned int flags)
 {
-    PROXYFS_DEBUG("name=%s, len=%zu\n", file->f_path.dentry->d_name.name, len);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_SPLICE_WRITE);
+    PROXYFS_STATS_ARGS(file_inode(file), ppos ? *ppos : 0, len, flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->splice_write) {
-        return lower_file->f_op->splice_write(pipe, lower_file, ppos, len, flags);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->splice_write(pipe, lower_file, ppos, len, flags));
     }
     return -ENOSYS;
 }
@@ -315,10 +432,12 @@ static ssize_t proxyfs_splice_read(struct file *file,
                                    size_t len,
                                    unsigned int flags)
 {
-    PROXYFS_DEBUG("name=%s, len=%zu\n", file->f_path.dentry->d_name.name, len);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_SPLICE_READ);
+    PROXYFS_STATS_ARGS(file_inode(file), ppos ? *ppos : 0, len, flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->splice_read) {
-        return lower_file->f_op->splice_read(lower_file, ppos, pipe, len, flags);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->splice_read(lower_file, ppos, pipe, len, flags));
     }
     return -ENOSYS;
 }
@@ -326,10 +445,12 @@ static ssize_t proxyfs_splice_read(struct file *file,
 // splice_eof
 static void proxyfs_splice_eof(struct file *file)
 {
-    PROXYFS_DEBUG("name=%s\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_SPLICE_EOF);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, 0);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->splice_eof) {
-        lower_file->f_op->splice_eof(lower_file);
+        PROXYFS_STATS_LOWER_VOID(lower_file->f_op->splice_eof(lower_file));
     }
 }
 
@@ -339,10 +460,12 @@ static int proxyfs_setlease(struct file *file,
                             struct file_lease **flp,
                             void **priv)
 {
-    PROXYFS_DEBUG("name=%s, arg=%d\n", file->f_path.dentry->d_name.name, arg);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_SETLEASE);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, arg);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->setlease) {
-        return lower_file->f_op->setlease(lower_file, arg, flp, priv);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->setlease(lower_file, arg, flp, priv));
     }
     return -ENOSYS;
 }
@@ -353,10 +476,12 @@ static long proxyfs_fallocate(struct file *file,
                               loff_t offset,
                               loff_t len)
 {
-    PROXYFS_DEBUG("name=%s, mode=%d, offset=%lld, len=%lld\n", file->f_path.dentry->d_name.name, mode, offset, len);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_FALLOCATE);
+    PROXYFS_STATS_ARGS(file_inode(file), offset, len, mode);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->fallocate) {
-        return lower_file->f_op->fallocate(lower_file, mode, offset, len);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->fallocate(lower_file, mode, offset, len));
     }
     return -ENOSYS;
 }
@@ -365,10 +490,12 @@ static long proxyfs_fallocate(struct file *file,
 static void proxyfs_show_fdinfo(struct seq_file *m,
                                 struct file *f)
 {
-    PROXYFS_DEBUG("name=%s\n", f->f_path.dentry->d_name.name);
+    PROXYFS_STATS(file_inode(f)->i_sb, FILE_SHOW_FDINFO);
+    PROXYFS_STATS_ARGS(file_inode(f), 0, 0, 0);
+    PROXYFS_STATS_PATH(f->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(f);
     if (lower_file->f_op && lower_file->f_op->show_fdinfo) {
-        lower_file->f_op->show_fdinfo(m, lower_file);
+        PROXYFS_STATS_LOWER_VOID(lower_file->f_op->show_fdinfo(m, lower_file));
     }
 }
 
@@ -376,10 +503,12 @@ static void proxyfs_show_fdinfo(struct seq_file *m,
 // mmap_capabilities
 static unsigned proxyfs_mmap_capabilities(struct file *file)
 {
-    PROXYFS_DEBUG("name=%s\n", file->f_path.dentry->d_name.name);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_MMAP_CAPABILITIES);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, 0);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->mmap_capabilities) {
-        return lower_file->f_op->mmap_capabilities(lower_file);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->mmap_capabilities(lower_file));
     }
     return 0;
 }
@@ -394,14 +523,13 @@ static ssize_t proxyfs_copy_file_range(struct file *file_in,
                                        size_t len,
                                        unsigned int flags)
 {
-    PROXYFS_DEBUG("name_in=%s, name_out=%s, len=%zu\n",
-                  file_in->f_path.dentry->d_name.name,
-                  file_out->f_path.dentry->d_name.name,
-                  len);
+    PROXYFS_STATS(file_inode(file_in)->i_sb, FILE_COPY_FILE_RANGE);
+    PROXYFS_STATS_ARGS(file_inode(file_in), pos_in, len, flags);
+    PROXYFS_STATS_PATH(file_in->f_path.dentry);
     struct file *lower_in = proxyfs_lower_file(file_in);
     struct file *lower_out = proxyfs_lower_file(file_out);
     if (lower_in->f_op && lower_in->f_op->copy_file_range) {
-        return lower_in->f_op->copy_file_range(lower_in, pos_in, lower_out, pos_out, len, flags);
+        return PROXYFS_STATS_LOWER(lower_in->f_op->copy_file_range(lower_in, pos_in, lower_out, pos_out, len, flags));
     }
     return -ENOSYS;
 }
@@ -414,14 +542,13 @@ static loff_t proxyfs_remap_file_range(struct file *file_in,
                                        loff_t len,
                                        unsigned int remap_flags)
 {
-    PROXYFS_DEBUG("name_in=%s, name_out=%s, len=%lld\n",
-                  file_in->f_path.dentry->d_name.name,
-                  file_out->f_path.dentry->d_name.name,
-                  len);
+    PROXYFS_STATS(file_inode(file_in)->i_sb, FILE_REMAP_FILE_RANGE);
+    PROXYFS_STATS_ARGS(file_inode(file_in), pos_in, len, remap_flags);
+    PROXYFS_STATS_PATH(file_in->f_path.dentry);
     struct file *lower_in = proxyfs_lower_file(file_in);
     struct file *lower_out = proxyfs_lower_file(file_out);
     if (lower_in->f_op && lower_in->f_op->remap_file_range) {
-        return lower_in->f_op->remap_file_range(lower_in, pos_in, lower_out, pos_out, len, remap_flags);
+        return PROXYFS_STATS_LOWER(lower_in->f_op->remap_file_range(lower_in, pos_in, lower_out, pos_out, len, remap_flags));
     }
     return -ENOSYS;
 }
@@ -432,10 +559,12 @@ static int proxyfs_fadvise(struct file *file,
                            loff_t len,
                            int advice)
 {
-    PROXYFS_DEBUG("name=%s, offset=%lld, len=%lld, advice=%d\n", file->f_path.dentry->d_name.name, offset, len, advice);
+    PROXYFS_STATS(file_inode(file)->i_sb, FILE_FADVISE);
+    PROXYFS_STATS_ARGS(file_inode(file), offset, len, advice);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->fadvise) {
-        return lower_file->f_op->fadvise(lower_file, offset, len, advice);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->fadvise(lower_file, offset, len, advice));
     }
     return -ENOSYS;
 }
@@ -444,13 +573,15 @@ static int proxyfs_fadvise(struct file *file,
 static int proxyfs_uring_cmd(struct io_uring_cmd *ioucmd,
                              unsigned int issue_flags)
 {
+    PROXYFS_STATS(file_inode(ioucmd->file)->i_sb, FILE_URING_CMD);
     struct file *file = ioucmd->file;
-    PROXYFS_DEBUG("name=%s, flags=0x%x\n", file->f_path.dentry->d_name.name, issue_flags);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, issue_flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->uring_cmd) {
         struct io_uring_cmd lower_cmd = *ioucmd;
         lower_cmd.file = lower_file;
-        return lower_file->f_op->uring_cmd(&lower_cmd, issue_flags);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->uring_cmd(&lower_cmd, issue_flags));
     }
     return -ENOSYS;
 }
@@ -460,13 +591,15 @@ static int proxyfs_uring_cmd_iopoll(struct io_uring_cmd *ioucmd,
                                     struct io_comp_batch *batch,
                                     unsigned int poll_flags)
 {
+    PROXYFS_STATS(file_inode(ioucmd->file)->i_sb, FILE_URING_CMD_IOPOLL);
     struct file *file = ioucmd->file;
-    PROXYFS_DEBUG("name=%s, flags=0x%x\n", file->f_path.dentry->d_name.name, poll_flags);
+    PROXYFS_STATS_ARGS(file_inode(file), 0, 0, poll_flags);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_file->f_op && lower_file->f_op->uring_cmd_iopoll) {
         struct io_uring_cmd lower_cmd = *ioucmd;
         lower_cmd.file = lower_file;
-        return lower_file->f_op->uring_cmd_iopoll(&lower_cmd, batch, poll_flags);
+        return PROXYFS_STATS_LOWER(lower_file->f_op->uring_cmd_iopoll(&lower_cmd, batch, poll_flags));
     }
     return -ENOSYS;
 }
@@ -0,0 +1,724 @@
+// File		:proxyfs-filter.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 20:38:44 2026
+#include <linux/rcupdate.h>
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/mutex.h>
+#include <linux/cred.h>
+#include <linux/seq_file.h>
+#include <linux/jhash.h>
+#include "proxyfs.h"
+
+//
+// Criteria of a rule (a rule matches if all its criteria are met)
+#define PROXYFS_FILTER_UID    0x01
+#define PROXYFS_FILTER_GID    0x02
+#define PROXYFS_FILTER_PID    0x04
+#define PROXYFS_FILTER_TYPE   0x08
+#define PROXYFS_FILTER_OFLAGS 0x10
+#define PROXYFS_FILTER_PREFIX 0x20
+#define PROXYFS_FILTER_SUFFIX 0x40
+
+//
+// Criteria which depend on the task or on the call (not on the file)
+#define PROXYFS_FILTER_TASK   (PROXYFS_FILTER_UID | PROXYFS_FILTER_GID | \
+                               PROXYFS_FILTER_PID | PROXYFS_FILTER_OFLAGS)
+
+static const char *const proxyfs_filter_op_names[PROXYFS_EVENT_OP_COUNT] = {
+#define PROXYFS_FILTER_OP_NAME(NAME, name, CLASS, attrs) [PROXYFS_EVENT_OP_##NAME] = #name,
+    PROXYFS_EVENT_OPS(PROXYFS_FILTER_OP_NAME)
+#undef PROXYFS_FILTER_OP_NAME
+};
+
+static const struct {
+    const char *name;
+    umode_t mode;
+} proxyfs_filter_types[] = {
+    { "reg",  S_IFREG },
+    { "dir",  S_IFDIR },
+    { "lnk",  S_IFLNK },
+    { "chr",  S_IFCHR },
+    { "blk",  S_IFBLK },
+    { "fifo", S_IFIFO },
+    { "sock", S_IFSOCK },
+};
+
+static const struct {
+    const char *name;
+    unsigned int flag;
+} proxyfs_filter_oflags[] = {
+    { "wronly",   O_WRONLY },
+    { "rdwr",     O_RDWR },
+    { "creat",    O_CREAT },
+    { "excl",     O_EXCL },
+    { "trunc",    O_TRUNC },
+    { "append",   O_APPEND },
+    { "nonblock", O_NONBLOCK },
+    { "sync",     O_SYNC },
+    { "direct",   O_DIRECT },
+};
+
+struct proxyfs_filter_rule {
+    u32 criteria;
+    bool include;
+    uid_t uid;
+    gid_t gid;
+    pid_t pid;
+    //
+    // Bit of a file type is `1 << ((mode & S_IFMT) >> 12)`
+    u32 types;
+    //
+    // Open flags, any of them has to be set (open operation only)
+    unsigned int oflags;
+    //
+    // Components of the path prefix (relative to the mount root) packed
+    // one after another, every one is NUL terminated
+    u8 prefix_depth;
+    u8 prefix_offsets[PROXYFS_FILTER_DEPTH];
+    char prefix[PROXYFS_FILTER_PATH_LEN];
+    //
+    // Suffix of the file name
+    u8 suffix_len;
+    char suffix[PROXYFS_FILTER_NAME_LEN];
+    //
+    // Source of the rule (shown with its hit counter)
+    char text[PROXYFS_FILTER_TEXT_LEN];
+};
+
+//
+// Compiled filter set: rules are checked in order, the first matching
+// one decides; operations are mapped to the rules which can match them
+// thus just those ones are checked
+struct proxyfs_filter_set {
+    struct rcu_head rcu;
+    bool include;
+    unsigned int count;
+    u64 op_rules[PROXYFS_EVENT_OP_COUNT];
+    //
+    // Subtree rules: the deepest prefix of the path decides if none of
+    // the rules matches
+    struct proxyfs_trie *trie;
+    u32 subtrees;
+    //
+    // Operations the verdict of which depends on the file only (neither
+    // on the task nor on the open flags), thus it can be cached
+    u64 cacheable;
+    //
+    // Hits of every rule, of the default action, of the subtrees included
+    // and excluded (see `PROXYFS_FILTER_HITS_*`)
+    unsigned long __percpu *hits;
+    struct proxyfs_filter_rule rules[];
+};
+
+#define PROXYFS_FILTER_HITS_DEFAULT(set) ((set)->count)
+#define PROXYFS_FILTER_HITS_INCLUDE(set) ((set)->count + 1)
+#define PROXYFS_FILTER_HITS_EXCLUDE(set) ((set)->count + 2)
+#define PROXYFS_FILTER_HITS_CACHED(set)  ((set)->count + 3)
+#define PROXYFS_FILTER_HITS(set)         ((set)->count + 4)
+
+//
+// Verdicts cached by the inode (`struct proxyfs_inode`): bits of the
+// operations evaluated and monitored, tagged by the hash of the dentry
+// they have been evaluated for, of the generation and of the sequence of
+// `rename_lock` (32 bits)
+//
+// Note: verdicts of the operations past the first 16 ones (permission
+//       requests) are not cached
+#define PROXYFS_FILTER_CACHE_OPS             16
+#define PROXYFS_FILTER_CACHE_MONITORED(op)   BIT_ULL(op)
+#define PROXYFS_FILTER_CACHE_KNOWN(op)       BIT_ULL(16 + (op))
+#define PROXYFS_FILTER_CACHE_TAG_OF(seq)     ((u64)(u32)(seq) << 32)
+#define PROXYFS_FILTER_CACHE_TAG             GENMASK_ULL(63, 32)
+
+static_assert(PROXYFS_EVENT_OP_LOST < PROXYFS_FILTER_CACHE_OPS);
+
+//
+// Generation of the verdicts, changed when the filter set is replaced
+static atomic_t proxyfs_filter_generation = ATOMIC_INIT(1);
+
+//
+// Active filter set, NULL means every event is reported
+static struct proxyfs_filter_set __rcu *proxyfs_filter_set;
+static DEFINE_MUTEX(proxyfs_filter_lock);
+
+//
+// Match the path of the dentry (relative to the mount root) by the
+// prefix, walks the parents instead of rendering the path
+// Note: must be called under RCU read lock
+static bool proxyfs_filter_match_prefix(const struct proxyfs_filter_rule *rule,
+                                        struct dentry *dentry)
+{
+    struct dentry *ancestor = dentry;
+    unsigned int depth = 0;
+    unsigned int i;
+
+    while (!IS_ROOT(ancestor)) {
+        ancestor = READ_ONCE(ancestor->d_parent);
+        depth++;
+    }
+    if (depth < rule->prefix_depth) {
+        return false;
+    }
+    for (ancestor = dentry; depth > rule->prefix_depth; depth--) {
+        ancestor = READ_ONCE(ancestor->d_parent);
+    }
+    //
+    // Note: the names are NUL terminated, the comparison doesn't cross
+    //       the end of a shorter name
+    for (i = rule->prefix_depth; i > 0; i--) {
+        const char *component = rule->prefix + rule->prefix_offsets[i - 1];
+
+        if (strncmp(READ_ONCE(ancestor->d_name.name), component, strlen(component) + 1) != 0) {
+            return false;
+        }
+        ancestor = READ_ONCE(ancestor->d_parent);
+    }
+    return true;
+}
+
+// Note: must be called under RCU read lock
+static bool proxyfs_filter_match_suffix(const struct proxyfs_filter_rule *rule,
+                                        struct dentry *dentry)
+{
+    const char *name = READ_ONCE(dentry->d_name.name);
+    size_t len = strlen(name);
+
+    return len >= rule->suffix_len &&
+        memcmp(name + len - rule->suffix_len, rule->suffix, rule->suffix_len) == 0;
+}
+
+static bool proxyfs_filter_match_rule(const struct proxyfs_filter_rule *rule,
+                                      enum proxyfs_event_op op,
+                                      const struct proxyfs_event_args *args)
+{
+    if ((rule->criteria & PROXYFS_FILTER_PID) &&
+        rule->pid != task_tgid_nr(current)) {
+        return false;
+    }
+    if ((rule->criteria & PROXYFS_FILTER_UID) &&
+        rule->uid != from_kuid(&init_user_ns, current_fsuid())) {
+        return false;
+    }
+    if ((rule->criteria & PROXYFS_FILTER_GID) &&
+        rule->gid != from_kgid(&init_user_ns, current_fsgid())) {
+        return false;
+    }
+    if ((rule->criteria & PROXYFS_FILTER_TYPE) &&
+        (args->inode == NULL ||
+         !(rule->types & BIT((args->inode->i_mode & S_IFMT) >> 12)))) {
+        return false;
+    }
+    if ((rule->criteria & PROXYFS_FILTER_OFLAGS) &&
+        (op != PROXYFS_EVENT_OP_OPEN || !(args->flags & rule->oflags))) {
+        return false;
+    }
+    if ((rule->criteria & PROXYFS_FILTER_PREFIX) &&
+        (args->path == NULL || !proxyfs_filter_match_prefix(rule, args->path))) {
+        return false;
+    }
+    if ((rule->criteria & PROXYFS_FILTER_SUFFIX) &&
+        (args->path == NULL || !proxyfs_filter_match_suffix(rule, args->path))) {
+        return false;
+    }
+    return true;
+}
+
+// Note: must be called under RCU read lock
+static bool proxyfs_filter_evaluate(struct proxyfs_filter_set *set,
+                                    enum proxyfs_event_op op,
+                                    const struct proxyfs_event_args *args)
+{
+    u64 rules = set->op_rules[op];
+    unsigned int i = PROXYFS_FILTER_HITS_DEFAULT(set);
+    bool res = set->include;
+    u8 verdict;
+
+    while (rules != 0) {
+        unsigned int rule = __ffs64(rules);
+
+        rules &= rules - 1;
+        if (proxyfs_filter_match_rule(&set->rules[rule], op, args)) {
+            res = set->rules[rule].include;
+            i = rule;
+            break;
+        }
+    }
+    if (i == PROXYFS_FILTER_HITS_DEFAULT(set) &&
+        set->trie != NULL &&
+        args->path != NULL &&
+        (verdict = proxyfs_trie_match(set->trie, args->path)) != PROXYFS_TRIE_NONE) {
+        res = (verdict == PROXYFS_TRIE_INCLUDE);
+        i = res ? PROXYFS_FILTER_HITS_INCLUDE(set) : PROXYFS_FILTER_HITS_EXCLUDE(set);
+    }
+    this_cpu_inc(set->hits[i]);
+    return res;
+}
+
+//
+// Sequence of the path of the dentry: hash of the dentries up to the mount
+// root and of their `d_seq` (changed when a dentry is moved, unlinked or
+// instantiated), thus it changes once a rename of the file or of any of
+// its ancestors is visible; false is returned if one of them is being
+// changed right now
+//
+// Note: must be called under RCU read lock; it walks up to the root, thus
+//       it keys the permission verdicts only (see `proxyfs_perm_request()`)
+bool proxyfs_filter_path_seq(struct dentry *dentry,
+                             u32 seed,
+                             u32 *seq)
+{
+    unsigned long ptr;
+    unsigned int dseq;
+    u32 hash = seed;
+
+    for (;;) {
+        if ((dseq = raw_read_seqcount(&dentry->d_seq)) & 1) {
+            return false;
+        }
+        ptr = (unsigned long)dentry;
+        hash = jhash_3words(lower_32_bits(ptr), upper_32_bits(ptr), dseq, hash);
+        if (IS_ROOT(dentry)) {
+            break;
+        }
+        dentry = READ_ONCE(dentry->d_parent);
+    }
+    *seq = hash;
+    return true;
+}
+
+//
+// Tag of the verdicts cached for the dentry
+inline static u64 proxyfs_filter_cache_tag(const struct dentry *dentry,
+                                           unsigned int generation,
+                                           unsigned int rename_seq)
+{
+    unsigned long ptr = (unsigned long)dentry;
+
+    return PROXYFS_FILTER_CACHE_TAG_OF(jhash_3words(lower_32_bits(ptr),
+                                                    upper_32_bits(ptr),
+                                                    rename_seq,
+                                                    generation));
+}
+
+//
+// Check if the event should be reported according to the filter set,
+// nothing is allocated (the event is not even formatted yet)
+//
+// Note: verdicts which depend on the file only are cached by the inode,
+//       the cache is valid while neither the generation nor the sequence
+//       of `rename_lock` change. The sequence is changed by VFS once it
+//       moves a dentry (after `proxyfs_rename()` returns), thus a rename
+//       anywhere drops the verdicts but a hit costs just a couple of
+//       loads and a compare; the tag carries the dentry as well, thus
+//       hard links of the file don't share verdicts
+bool proxyfs_filter_check(enum proxyfs_event_op op,
+                          const struct proxyfs_event_args *args)
+{
+    struct proxyfs_inode *inode = NULL;
+    struct proxyfs_filter_set *set;
+    u64 tag = 0;
+    u64 cache = 0;
+    unsigned int generation;
+    unsigned int rename_seq = 0;
+    bool res = true;
+
+    rcu_read_lock();
+    //
+    // Note: the generation is read ahead of the set (paired with the
+    //       release of `proxyfs_filter_publish()`), thus the set is at
+    //       least as new as the generation; a verdict of the set published
+    //       after it is cached under the stale tag
+    generation = (unsigned int)atomic_read_acquire(&proxyfs_filter_generation);
+    do {
+        if ((set = rcu_dereference(proxyfs_filter_set)) == NULL) {
+            break;
+        }
+        if (args->path != NULL &&
+            args->inode != NULL &&
+            (set->cacheable & BIT_ULL(op))) {
+            inode = container_of(args->inode, struct proxyfs_inode, vfs_inode);
+            rename_seq = read_seqbegin(&rename_lock);
+            tag = proxyfs_filter_cache_tag(args->path, generation, rename_seq);
+            cache = atomic64_read(&inode->filter_cache);
+            if ((cache & PROXYFS_FILTER_CACHE_TAG) == tag &&
+                (cache & PROXYFS_FILTER_CACHE_KNOWN(op))) {
+                res = (cache & PROXYFS_FILTER_CACHE_MONITORED(op)) != 0;
+                this_cpu_inc(set->hits[PROXYFS_FILTER_HITS_CACHED(set)]);
+                break;
+            }
+        }
+        res = proxyfs_filter_evaluate(set, op, args);
+        //
+        // The verdict is cached if neither the set nor any path have been
+        // changed while it was evaluated
+        if (inode != NULL &&
+            (unsigned int)atomic_read_acquire(&proxyfs_filter_generation) == generation &&
+            !read_seqretry(&rename_lock, rename_seq)) {
+            //
+            // Note: the verdicts of other operations are kept if the tag
+            //       is the same, losing the race just costs another
+            //       evaluation later
+            atomic64_cmpxchg(&inode->filter_cache,
+                             cache,
+                             ((cache & PROXYFS_FILTER_CACHE_TAG) == tag ? cache : tag) |
+                             PROXYFS_FILTER_CACHE_KNOWN(op) |
+                             (res ? PROXYFS_FILTER_CACHE_MONITORED(op) : 0));
+        }
+    } while (false);
+    rcu_read_unlock();
+    return res;
+}
+
+static int proxyfs_filter_parse_list(char *value,
+                                     u64 *mask,
+                                     int (*lookup)(const char *name, u64 *bit))
+{
+    char *item;
+    u64 bit;
+    int res;
+
+    *mask = 0;
+    while ((item = strsep(&value, ",")) != NULL) {
+        if ((res = lookup(item, &bit)) != 0) {
+            return res;
+        }
+        *mask |= bit;
+    }
+    return 0;
+}
+
+static int proxyfs_filter_lookup_op(const char *name, u64 *bit)
+{
+    int i;
+
+    for (i = 0; i < PROXYFS_EVENT_OP_COUNT; i++) {
+        if (strcmp(name, proxyfs_filter_op_names[i]) == 0) {
+            *bit = BIT_ULL(i);
+            return 0;
+        }
+    }
+    return -EINVAL;
+}
+
+static int proxyfs_filter_lookup_type(const char *name, u64 *bit)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(proxyfs_filter_types); i++) {
+        if (strcmp(name, proxyfs_filter_types[i].name) == 0) {
+            *bit = BIT_ULL(proxyfs_filter_types[i].mode >> 12);
+            return 0;
+        }
+    }
+    return -EINVAL;
+}
+
+static int proxyfs_filter_lookup_oflag(const char *name, u64 *bit)
+{
+    int i;
+
+    for (i = 0; i < ARRAY_SIZE(proxyfs_filter_oflags); i++) {
+        if (strcmp(name, proxyfs_filter_oflags[i].name) == 0) {
+            *bit = proxyfs_filter_oflags[i].flag;
+            return 0;
+        }
+    }
+    return -EINVAL;
+}
+
+static int proxyfs_filter_parse_prefix(struct proxyfs_filter_rule *rule,
+                                       char *value)
+{
+    char *component;
+    size_t pos = 0;
+    size_t len;
+
+    rule->prefix_depth = 0;
+    while ((component = strsep(&value, "/")) != NULL) {
+        if ((len = strlen(component)) == 0) {
+            continue;
+        }
+        if (rule->prefix_depth == PROXYFS_FILTER_DEPTH ||
+            pos + len + 1 > sizeof(rule->prefix)) {
+            return -ENAMETOOLONG;
+        }
+        rule->prefix_offsets[rule->prefix_depth++] = pos;
+        memcpy(rule->prefix + pos, component, len + 1);
+        pos += len + 1;
+    }
+    return 0;
+}
+
+//
+// Compile the rule "include|exclude [<criterion>=<value> ...]", the
+// operations it applies to are returned by `ops`
+static int proxyfs_filter_parse_rule(struct proxyfs_filter_rule *rule,
+                                     char *line,
+                                     u64 *ops)
+{
+    char *token;
+    char *value;
+    u64 mask;
+    int res = 0;
+
+    strscpy(rule->text, line, sizeof(rule->text));
+    token = strsep(&line, " \t");
+    if (strcmp(token, "include") == 0) {
+        rule->include = true;
+    } else if (strcmp(token, "exclude") == 0) {
+        rule->include = false;
+    } else {
+        return -EINVAL;
+    }
+    *ops = BIT_ULL(PROXYFS_EVENT_OP_COUNT) - 1;
+    while (res == 0 && (token = strsep(&line, " \t")) != NULL) {
+        if (*token == '\0') {
+            continue;
+        }
+        if ((value = strchr(token, '=')) == NULL || value[1] == '\0') {
+            return -EINVAL;
+        }
+        *value++ = '\0';
+        if (strcmp(token, "op") == 0) {
+            res = proxyfs_filter_parse_list(value, ops, proxyfs_filter_lookup_op);
+        } else if (strcmp(token, "uid") == 0) {
+            rule->criteria |= PROXYFS_FILTER_UID;
+            res = kstrtouint(value, 0, &rule->uid);
+        } else if (strcmp(token, "gid") == 0) {
+            rule->criteria |= PROXYFS_FILTER_GID;
+            res = kstrtouint(value, 0, &rule->gid);
+        } else if (strcmp(token, "pid") == 0) {
+            rule->criteria |= PROXYFS_FILTER_PID;
+            res = kstrtoint(value, 0, &rule->pid);
+        } else if (strcmp(token, "type") == 0) {
+            rule->criteria |= PROXYFS_FILTER_TYPE;
+            if ((res = proxyfs_filter_parse_list(value, &mask, proxyfs_filter_lookup_type)) == 0) {
+                rule->types = mask;
+            }
+        } else if (strcmp(token, "oflags") == 0) {
+            rule->criteria |= PROXYFS_FILTER_OFLAGS;
+            if ((res = proxyfs_filter_parse_list(value, &mask, proxyfs_filter_lookup_oflag)) == 0) {
+                rule->oflags = mask;
+            }
+        } else if (strcmp(token, "prefix") == 0) {
+            rule->criteria |= PROXYFS_FILTER_PREFIX;
+            res = proxyfs_filter_parse_prefix(rule, value);
+        } else if (strcmp(token, "suffix") == 0) {
+            rule->criteria |= PROXYFS_FILTER_SUFFIX;
+            if ((rule->suffix_len = strlen(value)) >= sizeof(rule->suffix)) {
+                return -ENAMETOOLONG;
+            }
+            memcpy(rule->suffix, value, rule->suffix_len);
+        } else {
+            res = -EINVAL;
+        }
+    }
+    //
+    // Open flags are reported by open events only
+    if (rule->criteria & PROXYFS_FILTER_OFLAGS) {
+        *ops &= BIT_ULL(PROXYFS_EVENT_OP_OPEN);
+    }
+    return res;
+}
+
+static void proxyfs_filter_free(struct proxyfs_filter_set *set)
+{
+    free_percpu(set->hits);
+    proxyfs_trie_free(set->trie);
+    kvfree(set);
+}
+
+static void proxyfs_filter_free_rcu(struct rcu_head *rcu)
+{
+    proxyfs_filter_free(container_of(rcu, struct proxyfs_filter_set, rcu));
+}
+
+//
+// Replace the active filter set, the readers keep the old one until
+// they leave their RCU read sections
+static void proxyfs_filter_publish(struct proxyfs_filter_set *set)
+{
+    struct proxyfs_filter_set *old_set;
+
+    mutex_lock(&proxyfs_filter_lock);
+    old_set = rcu_replace_pointer(proxyfs_filter_set,
+                                  set,
+                                  lockdep_is_held(&proxyfs_filter_lock));
+    //
+    // Note: the set is published ahead of the generation, thus a reader
+    //       seeing the new generation sees the new set
+    smp_mb__before_atomic();
+    atomic_inc(&proxyfs_filter_generation);
+    mutex_unlock(&proxyfs_filter_lock);
+    if (old_set != NULL) {
+        call_rcu(&old_set->rcu, proxyfs_filter_free_rcu);
+    }
+}
+
+//
+// Compile the filter set (one rule per line) and make it active:
+//   default include|exclude
+//   include|exclude [op=<op>,...] [uid=<uid>] [gid=<gid>] [pid=<pid>]
+//                   [type=reg|dir|lnk|chr|blk|fifo|sock,...]
+//                   [oflags=wronly|rdwr|creat|excl|trunc|append|...,...]
+//                   [prefix=<path>] [suffix=<name suffix>]
+//   include|exclude subtree=<path>
+// empty lines and lines started by '#' are skipped; the set without
+// rules including every event is dropped at all
+//
+// Note: subtree rules are indexed by a trie of the path components (the
+//       number of them is not limited), they are checked if none of the
+//       other rules matches
+int proxyfs_filter_compile(char *text)
+{
+    struct proxyfs_trie_builder builder;
+    struct proxyfs_filter_set *set;
+    struct proxyfs_trie *trie;
+    char *line = NULL;
+    u64 ops;
+    int res;
+    int i;
+
+    if ((set = kvzalloc(struct_size(set, rules, PROXYFS_FILTER_RULES), GFP_KERNEL)) == NULL) {
+        return -ENOMEM;
+    }
+    if ((res = proxyfs_trie_builder_init(&builder)) != 0) {
+        kvfree(set);
+        return res;
+    }
+    set->include = true;
+    set->cacheable = BIT_ULL(min_t(unsigned int, PROXYFS_EVENT_OP_COUNT, PROXYFS_FILTER_CACHE_OPS)) - 1;
+    while (res == 0 && (line = strsep(&text, "\n")) != NULL) {
+        line = strim(line);
+        if (*line == '\0' || *line == '#') {
+            continue;
+        }
+        if (strncmp(line, "default ", 8) == 0) {
+            line = strim(line + 8);
+            if (strcmp(line, "include") == 0 || strcmp(line, "exclude") == 0) {
+                set->include = (*line == 'i');
+            } else {
+                res = -EINVAL;
+            }
+            continue;
+        }
+        if (strncmp(line, "include subtree=", 16) == 0 ||
+            strncmp(line, "exclude subtree=", 16) == 0) {
+            res = proxyfs_trie_builder_add(&builder,
+                                           strim(line + 16),
+                                           *line == 'i' ? PROXYFS_TRIE_INCLUDE : PROXYFS_TRIE_EXCLUDE);
+            continue;
+        }
+        if (set->count == PROXYFS_FILTER_RULES) {
+            res = -E2BIG;
+            break;
+        }
+        if ((res = proxyfs_filter_parse_rule(&set->rules[set->count], line, &ops)) == 0) {
+            for (i = 0; i < PROXYFS_EVENT_OP_COUNT; i++) {
+                if (ops & BIT_ULL(i)) {
+                    set->op_rules[i] |= BIT_ULL(set->count);
+                }
+            }
+            if (set->rules[set->count].criteria & PROXYFS_FILTER_TASK) {
+                set->cacheable &= ~ops;
+            }
+            set->count++;
+        }
+    }
+    if (res != 0) {
+        pr_err("%s: invalid filter rule \"%s\": %d\n",
+               MODULE_NAME,
+               line ? line : "",
+               res);
+        proxyfs_trie_builder_destroy(&builder);
+        kvfree(set);
+        return res;
+    }
+    set->subtrees = builder.count;
+    trie = proxyfs_trie_build(&builder);
+    proxyfs_trie_builder_destroy(&builder);
+    if (IS_ERR(trie)) {
+        kvfree(set);
+        return PTR_ERR(trie);
+    }
+    set->trie = trie;
+    if (set->count == 0 && set->trie == NULL && set->include) {
+        kvfree(set);
+        proxyfs_filter_publish(NULL);
+        pr_info("%s: event filter is cleared\n",
+                MODULE_NAME);
+        return 0;
+    }
+    if ((set->hits = __alloc_percpu(sizeof(unsigned long) * PROXYFS_FILTER_HITS(set),
+                                    __alignof__(unsigned long))) == NULL) {
+        proxyfs_trie_free(set->trie);
+        kvfree(set);
+        return -ENOMEM;
+    }
+    proxyfs_filter_publish(set);
+    pr_info("%s: event filter of %u rules and %u subtrees is active\n",
+            MODULE_NAME,
+            set->count,
+            set->subtrees);
+    return 0;
+}
+
+static unsigned long proxyfs_filter_hits(const struct proxyfs_filter_set *set,
+                                         unsigned int i)
+{
+    unsigned long hits = 0;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        hits += per_cpu_ptr(set->hits, cpu)[i];
+    }
+    return hits;
+}
+
+//
+// Rules of the active filter set with their hit counters
+void proxyfs_filter_show(struct seq_file *m)
+{
+    struct proxyfs_filter_set *set;
+    unsigned int i;
+
+    rcu_read_lock();
+    if ((set = rcu_dereference(proxyfs_filter_set)) == NULL) {
+        seq_printf(m, "no filter, every event is reported\n");
+    } else {
+        seq_printf(m, "%-4s %-12s %s\n", "rule", "hits", "source");
+        for (i = 0; i < set->count; i++) {
+            seq_printf(m, "%-4u %-12lu %s\n",
+                       i,
+                       proxyfs_filter_hits(set, i),
+                       set->rules[i].text);
+        }
+        if (set->trie != NULL) {
+            seq_printf(m, "%-4s %-12lu include subtree (%u subtrees, %u trie nodes)\n",
+                       "-",
+                       proxyfs_filter_hits(set, PROXYFS_FILTER_HITS_INCLUDE(set)),
+                       set->subtrees,
+                       proxyfs_trie_size(set->trie));
+            seq_printf(m, "%-4s %-12lu exclude subtree\n",
+                       "-",
+                       proxyfs_filter_hits(set, PROXYFS_FILTER_HITS_EXCLUDE(set)));
+        }
+        seq_printf(m, "%-4s %-12lu cached verdicts\n",
+                   "-",
+                   proxyfs_filter_hits(set, PROXYFS_FILTER_HITS_CACHED(set)));
+        seq_printf(m, "%-4s %-12lu default %s\n",
+                   "-",
+                   proxyfs_filter_hits(set, PROXYFS_FILTER_HITS_DEFAULT(set)),
+                   set->include ? "include" : "exclude");
+    }
+    rcu_read_unlock();
+}
+
+void proxyfs_filter_release(void)
+{
+    proxyfs_filter_publish(NULL);
+    rcu_barrier();
+}
@@ -0,0 +1,375 @@
+// File		:proxyfs-flight.c
+// Author	:Victor Kovalevich
+// Created	:Sat Oct 17 02:26:41 2026
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/workqueue.h>
+#include <linux/log2.h>
+#include "proxyfs.h"
+
+//
+// Call of an operation recorded (see `proxyfs_flight_record()`)
+struct proxyfs_flight_entry {
+    u64 time;
+    u64 ino;
+    u64 latency_ns;
+    s64 ret;
+    u32 dev;
+    u32 pid;
+    u16 op;
+};
+
+//
+// Ring of the calls made on a CPU, the newest entry replaces the oldest
+// one
+//
+// Note: the ring is written with preemption disabled, thus the CPU is
+//       its only writer and no lock is taken
+struct proxyfs_flight_ring {
+    unsigned long head;
+    struct proxyfs_flight_entry entries[];
+};
+
+enum proxyfs_flight_state {
+    PROXYFS_FLIGHT_EMPTY,
+    PROXYFS_FLIGHT_CAPTURING,
+    PROXYFS_FLIGHT_READY,
+};
+
+//
+// Copy of the rings taken when a call is slow or fails (or on demand),
+// it is kept till it is cleared, thus it describes the first trouble
+// rather than the last one
+struct proxyfs_flight_snapshot {
+    atomic_t state;
+    const char *reason;
+    int cpu;
+    bool has_trigger;
+    struct proxyfs_flight_entry trigger;
+    u64 time;
+    //
+    // Entries of every CPU (oldest first) and number of them
+    struct proxyfs_flight_entry *entries;
+    unsigned int *counts;
+    struct work_struct work;
+    //
+    // Triggers fired while the snapshot was held
+    atomic_long_t missed;
+};
+
+static struct {
+    unsigned int records;
+    u64 slow_ns;
+    bool errors;
+} proxyfs_flight;
+
+static DEFINE_PER_CPU(struct proxyfs_flight_ring *, proxyfs_flight_rings);
+static struct proxyfs_flight_snapshot proxyfs_flight_snapshot;
+
+//
+// Copy the entries of the ring (oldest first) to `to`, number of them is
+// returned
+//
+// Note: entries overwritten while they are copied may come out torn
+static unsigned int proxyfs_flight_copy(const struct proxyfs_flight_ring *ring,
+                                        struct proxyfs_flight_entry *to)
+{
+    unsigned long head;
+    unsigned int count;
+    unsigned int i;
+
+    if (ring == NULL) {
+        return 0;
+    }
+    head = READ_ONCE(ring->head);
+    count = min_t(unsigned long, head, proxyfs_flight.records);
+    for (i = 0; i < count; i++) {
+        to[i] = ring->entries[(head - count + i) & (proxyfs_flight.records - 1)];
+    }
+    return count;
+}
+
+static void proxyfs_flight_capture(struct work_struct *work)
+{
+    struct proxyfs_flight_snapshot *snapshot =
+        container_of(work, struct proxyfs_flight_snapshot, work);
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        snapshot->counts[cpu] =
+            proxyfs_flight_copy(per_cpu(proxyfs_flight_rings, cpu),
+                                &snapshot->entries[(size_t)cpu * proxyfs_flight.records]);
+    }
+    snapshot->time = ktime_get_ns();
+    atomic_set_release(&snapshot->state, PROXYFS_FLIGHT_READY);
+}
+
+//
+// Take the snapshot unless one is held already, the rings are copied by
+// a work item thus the handler calling it is not delayed
+static bool proxyfs_flight_trigger(const char *reason,
+                                   const struct proxyfs_flight_entry *entry)
+{
+    struct proxyfs_flight_snapshot *snapshot = &proxyfs_flight_snapshot;
+
+    if (snapshot->entries == NULL) {
+        return false;
+    }
+    if (atomic_read(&snapshot->state) != PROXYFS_FLIGHT_EMPTY ||
+        atomic_cmpxchg(&snapshot->state,
+                       PROXYFS_FLIGHT_EMPTY,
+                       PROXYFS_FLIGHT_CAPTURING) != PROXYFS_FLIGHT_EMPTY) {
+        atomic_long_inc(&snapshot->missed);
+        return false;
+    }
+    snapshot->reason = reason;
+    snapshot->cpu = raw_smp_processor_id();
+    snapshot->has_trigger = entry != NULL;
+    if (entry != NULL) {
+        snapshot->trigger = *entry;
+    }
+    schedule_work(&snapshot->work);
+    return true;
+}
+
+//
+// Errors telling the lower FS (or the system) is in trouble, the ones
+// the callers expect routinely (-ENOENT, -ENODATA, -EAGAIN, ...) don't
+// take the snapshot
+static bool proxyfs_flight_is_failure(long ret)
+{
+    switch (ret) {
+    case -EIO:
+    case -ENOMEM:
+    case -ENOSPC:
+    case -EDQUOT:
+    case -EROFS:
+    case -EUCLEAN:
+    case -ETIMEDOUT:
+        return true;
+    default:
+        return false;
+    }
+}
+
+//
+// Record the call timed to the ring of the current CPU, that costs a few
+// stores; the snapshot is taken if the call is slow or fails
+void proxyfs_flight_record(const struct proxyfs_stats_timer *timer,
+                           u64 latency_ns)
+{
+    struct proxyfs_flight_entry entry = {
+        .time = timer->start,
+        .ino = timer->ino,
+        .latency_ns = latency_ns,
+        .ret = timer->ret,
+        .dev = timer->dev,
+        .pid = task_pid_nr(current),
+        .op = timer->op,
+    };
+    struct proxyfs_flight_ring *ring;
+
+    preempt_disable();
+    if ((ring = this_cpu_read(proxyfs_flight_rings)) == NULL) {
+        preempt_enable();
+        return;
+    }
+    ring->entries[ring->head & (proxyfs_flight.records - 1)] = entry;
+    WRITE_ONCE(ring->head, ring->head + 1);
+    preempt_enable();
+
+    if (proxyfs_flight.slow_ns != 0 && latency_ns >= proxyfs_flight.slow_ns) {
+        proxyfs_flight_trigger("slow", &entry);
+    } else if (proxyfs_flight.errors && proxyfs_flight_is_failure(timer->ret)) {
+        proxyfs_flight_trigger("error", &entry);
+    }
+}
+
+//
+// Take the snapshot on demand, -EBUSY is returned if one is held already
+int proxyfs_flight_snapshot_take(void)
+{
+    if (proxyfs_flight_snapshot.entries == NULL) {
+        return -ENODEV;
+    }
+    return proxyfs_flight_trigger("manual", NULL) ? 0 : -EBUSY;
+}
+
+//
+// Drop the snapshot held, the next trigger takes a new one
+void proxyfs_flight_snapshot_clear(void)
+{
+    atomic_cmpxchg(&proxyfs_flight_snapshot.state,
+                   PROXYFS_FLIGHT_READY,
+                   PROXYFS_FLIGHT_EMPTY);
+}
+
+int proxyfs_flight_init(const struct proxyfs_flight_config *config)
+{
+    struct proxyfs_flight_snapshot *snapshot = &proxyfs_flight_snapshot;
+    struct proxyfs_flight_ring *ring;
+    int cpu;
+
+    atomic_set(&snapshot->state, PROXYFS_FLIGHT_EMPTY);
+    atomic_long_set(&snapshot->missed, 0);
+    INIT_WORK(&snapshot->work, proxyfs_flight_capture);
+    if (config->records == 0) {
+        pr_info("%s: flight recorder is disabled\n",
+                MODULE_NAME);
+        return 0;
+    }
+    if (!is_power_of_2(config->records)) {
+        pr_err("%s: invalid number of flight recorder records %u\n",
+               MODULE_NAME,
+               config->records);
+        return -EINVAL;
+    }
+    proxyfs_flight.records = config->records;
+    proxyfs_flight.slow_ns = (u64)config->slow_ms * NSEC_PER_MSEC;
+    proxyfs_flight.errors = config->errors;
+    //
+    // Note: rings of all the possible CPUs are allocated up front, thus
+    //       CPUs brought online later record their calls as well
+    for_each_possible_cpu(cpu) {
+        if ((ring = kvzalloc_node(struct_size(ring, entries, config->records),
+                                  GFP_KERNEL,
+                                  cpu_to_node(cpu))) == NULL) {
+            pr_err("%s: unable to create flight recorder ring of CPU %d\n",
+                   MODULE_NAME,
+                   cpu);
+            proxyfs_flight_release();
+            return -ENOMEM;
+        }
+        per_cpu(proxyfs_flight_rings, cpu) = ring;
+    }
+    snapshot->counts = kvcalloc(nr_cpu_ids, sizeof(unsigned int), GFP_KERNEL);
+    snapshot->entries = kvcalloc(array_size(nr_cpu_ids, config->records),
+                                 sizeof(struct proxyfs_flight_entry),
+                                 GFP_KERNEL);
+    if (snapshot->counts == NULL || snapshot->entries == NULL) {
+        pr_err("%s: unable to allocate flight recorder snapshot\n",
+               MODULE_NAME);
+        proxyfs_flight_release();
+        return -ENOMEM;
+    }
+    pr_info("%s: flight recorder with %u records per CPU is ready for use (slow call %u ms)\n",
+            MODULE_NAME,
+            config->records,
+            config->slow_ms);
+    return 0;
+}
+
+//
+// Note: must be called when no mount is left
+void proxyfs_flight_release(void)
+{
+    struct proxyfs_flight_snapshot *snapshot = &proxyfs_flight_snapshot;
+    int cpu;
+
+    //
+    // Recorders run with preemption disabled, thus nobody touches the
+    // rings after the grace period
+    synchronize_rcu();
+    cancel_work_sync(&snapshot->work);
+    for_each_possible_cpu(cpu) {
+        kvfree(per_cpu(proxyfs_flight_rings, cpu));
+        per_cpu(proxyfs_flight_rings, cpu) = NULL;
+    }
+    kvfree(snapshot->entries);
+    snapshot->entries = NULL;
+    kvfree(snapshot->counts);
+    snapshot->counts = NULL;
+    atomic_set(&snapshot->state, PROXYFS_FLIGHT_EMPTY);
+}
+
+static void proxyfs_flight_show_header(struct seq_file *m)
+{
+    seq_printf(m, "%-4s %-16s %-26s %-10s %-12s %-8s %-12s %s\n",
+               "cpu", "time", "op", "dev", "ino", "pid", "latency_ns", "ret");
+}
+
+static void proxyfs_flight_show_entry(struct seq_file *m,
+                                      int cpu,
+                                      const struct proxyfs_flight_entry *entry)
+{
+    char dev[16];
+
+    snprintf(dev, sizeof(dev), "%u:%u", MAJOR(entry->dev), MINOR(entry->dev));
+    seq_printf(m, "%-4d %-16llu %-26s %-10s %-12llu %-8u %-12llu %lld\n",
+               cpu,
+               entry->time,
+               proxyfs_stats_op_name(entry->op),
+               dev,
+               entry->ino,
+               entry->pid,
+               entry->latency_ns,
+               entry->ret);
+}
+
+//
+// Calls recorded by every CPU (oldest first), time is the monotonic time
+// (ns) the call was made at
+void proxyfs_flight_show(struct seq_file *m)
+{
+    struct proxyfs_flight_entry *entries;
+    unsigned int count;
+    unsigned int i;
+    int cpu;
+
+    if (proxyfs_flight.records == 0) {
+        seq_printf(m, "flight recorder is disabled\n");
+        return;
+    }
+    if ((entries = kvmalloc_array(proxyfs_flight.records,
+                                  sizeof(struct proxyfs_flight_entry),
+                                  GFP_KERNEL)) == NULL) {
+        return;
+    }
+    proxyfs_flight_show_header(m);
+    for_each_possible_cpu(cpu) {
+        count = proxyfs_flight_copy(per_cpu(proxyfs_flight_rings, cpu), entries);
+        for (i = 0; i < count; i++) {
+            proxyfs_flight_show_entry(m, cpu, &entries[i]);
+        }
+    }
+    kvfree(entries);
+}
+
+//
+// Snapshot held: the call which has taken it followed by the calls
+// recorded by every CPU at the moment
+//
+// Note: the snapshot cleared and retaken while it is shown comes out
+//       mixed up
+void proxyfs_flight_show_snapshot(struct seq_file *m)
+{
+    struct proxyfs_flight_snapshot *snapshot = &proxyfs_flight_snapshot;
+    const struct proxyfs_flight_entry *entries;
+    unsigned int i;
+    int cpu;
+
+    if (atomic_read_acquire(&snapshot->state) != PROXYFS_FLIGHT_READY) {
+        seq_printf(m, "no snapshot (missed %ld)\n",
+                   atomic_long_read(&snapshot->missed));
+        return;
+    }
+    seq_printf(m, "reason=%s cpu=%d time=%llu missed=%ld\n",
+               snapshot->reason,
+               snapshot->cpu,
+               snapshot->time,
+               atomic_long_read(&snapshot->missed));
+    proxyfs_flight_show_header(m);
+    if (snapshot->has_trigger) {
+        proxyfs_flight_show_entry(m, snapshot->cpu, &snapshot->trigger);
+    }
+    seq_printf(m, "\n");
+    proxyfs_flight_show_header(m);
+    for_each_possible_cpu(cpu) {
+        entries = &snapshot->entries[(size_t)cpu * proxyfs_flight.records];
+        for (i = 0; i < snapshot->counts[cpu]; i++) {
+            proxyfs_flight_show_entry(m, cpu, &entries[i]);
+        }
+    }
+}
@@ -22,10 +22,9 @@ static struct dentry *proxyfs_lookup(struct inode *dir,
                                      struct dentry *dentry,
                                      unsigned int flags)
 {
-    PROXYFS_DEBUG("dir=" INODE_FMT ", dentry=%pd, flags=%ul\n",
-                  INODE_ARG(dir),
-                  dentry,
-                  flags);
+    PROXYFS_STATS(dir->i_sb, INODE_LOOKUP);
+    PROXYFS_STATS_ARGS(dir, 0, 0, flags);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *ret = NULL;
     struct dentry *new_lower_dentry = NULL;
     do {
@@ -33,6 +32,9 @@ static struct dentry *proxyfs_lookup(struct inode *dir,
             ret = ERR_PTR(-EINVAL);
             break;
         }
+        //
+        // Lookups are accounted to the directory searched
+        proxyfs_top_account(dentry->d_parent, dir, 0);
         struct dentry *lower_parent = proxyfs_lower_dentry(dentry->d_parent);
         struct dentry *lower_dentry = d_lookup(lower_parent, &dentry->d_name);
         if (!lower_dentry) {
@@ -44,7 +46,7 @@ static struct dentry *proxyfs_lookup(struct inode *dir,
         }
         struct inode *lower_dir = proxyfs_lower_inode(dir);
         if (lower_dir->i_op && lower_dir->i_op->lookup) {
-            struct dentry *res = lower_dir->i_op->lookup(lower_dir, lower_dentry, flags);
+            struct dentry *res = PROXYFS_STATS_LOWER_PTR(lower_dir->i_op->lookup(lower_dir, lower_dentry, flags));
             if (IS_ERR(res)) {
                 ret = res;
                 break;
@@ -77,14 +79,13 @@ static const char *proxyfs_get_link(struct dentry *dentry,
                                     struct inode *inode,
                                     struct delayed_call *done)
 {
-    PROXYFS_DEBUG("dentry=%pd, inode=" INODE_FMT ", done=%p\n",
-                  dentry,
-                  INODE_ARG(inode),
-                  done);
+    PROXYFS_STATS(inode->i_sb, INODE_GET_LINK);
+    PROXYFS_STATS_ARGS(inode, 0, 0, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     if (lower_inode->i_op && lower_inode->i_op->get_link) {
-        return lower_inode->i_op->get_link(lower_dentry, lower_inode, done);
+        return PROXYFS_STATS_LOWER_PTR(lower_inode->i_op->get_link(lower_dentry, lower_inode, done));
     }
     return ERR_PTR(-ENOSYS);
 }
@@ -94,12 +95,11 @@ static int proxyfs_permission(struct mnt_idmap *idmap,
                               struct inode *inode,
                               int mask)
 {
-    PROXYFS_DEBUG("inode=" INODE_FMT ", mask=0x%x\n",
-                  INODE_ARG(inode),
-                  mask);
+    PROXYFS_STATS(inode->i_sb, INODE_PERMISSION);
+    PROXYFS_STATS_ARGS(inode, 0, 0, mask);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     if (lower_inode->i_op && lower_inode->i_op->permission) {
-        return lower_inode->i_op->permission(idmap, lower_inode, mask);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->permission(idmap, lower_inode, mask));
     }
     return -ENOSYS;
 }
@@ -109,13 +109,11 @@ static struct posix_acl *proxyfs_get_inode_acl(struct inode *inode,
                                                int type,
                                                bool rcu)
 {
-    PROXYFS_DEBUG("inode=" INODE_FMT ", type=%d, rcu=%d\n",
-                  INODE_ARG(inode),
-                  type,
-                  rcu);
+    PROXYFS_STATS(inode->i_sb, INODE_GET_INODE_ACL);
+    PROXYFS_STATS_ARGS(inode, 0, 0, type);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     if (lower_inode->i_op && lower_inode->i_op->get_inode_acl) {
-        return lower_inode->i_op->get_inode_acl(lower_inode, type, rcu);
+        return PROXYFS_STATS_LOWER_PTR(lower_inode->i_op->get_inode_acl(lower_inode, type, rcu));
     }
     return ERR_PTR(-ENOSYS);
 }
@@ -125,13 +123,12 @@ static int proxyfs_readlink(struct dentry *dentry,
                             char __user *buffer,
                             int buffer_len)
 {
-    PROXYFS_DEBUG("dentry=%pd, buffer=%p, buffer_len=%d\n",
-                  dentry,
-                  buffer,
-                  buffer_len);
+    PROXYFS_STATS(dentry->d_sb, INODE_READLINK);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, buffer_len, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(d_inode(dentry));
     if (lower_inode->i_op && lower_inode->i_op->readlink) {
-        return lower_inode->i_op->readlink(dentry, buffer, buffer_len);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->readlink(dentry, buffer, buffer_len));
     }
     return -ENOSYS;
 }
@@ -143,15 +140,20 @@ static int proxyfs_create(struct mnt_idmap *idmap,
                           umode_t mode,
                           bool excl)
 {
-    PROXYFS_DEBUG("idmap=%p, dir=" INODE_FMT ", dentry=%pd, mode=0%o, excl=%s\n",
-                  idmap,
-                  INODE_ARG(dir),
-                  dentry,
-                  mode,
-                  (excl ? "true" : "false"));
+    PROXYFS_STATS(dir->i_sb, INODE_CREATE);
+    PROXYFS_STATS_ARGS(dir, 0, 0, mode);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     if (lower_inode->i_op && lower_inode->i_op->create) {
-        return lower_inode->i_op->create(idmap, lower_inode, dentry, mode, excl);
+        int ret = PROXYFS_STATS_LOWER(lower_inode->i_op->create(idmap, lower_inode, dentry, mode, excl));
+        if (ret == 0) {
+            proxyfs_event_create(&(struct proxyfs_event_args) {
+                    .inode = d_inode(dentry) ? d_inode(dentry) : dir,
+                    .path = dentry,
+                    .flags = mode,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -161,15 +163,22 @@ static int proxyfs_link(struct dentry *old_dentry,
                         struct inode *dir,
                         struct dentry *dentry)
 {
-    PROXYFS_DEBUG("old_dentry=%pd, dir=" INODE_FMT ", dentry=%pd\n",
-                  old_dentry,
-                  INODE_ARG(dir),
-                  dentry);
+    PROXYFS_STATS(dir->i_sb, INODE_LINK);
+    PROXYFS_STATS_ARGS(d_inode(old_dentry), 0, 0, 0);
+    PROXYFS_STATS_PATH(old_dentry);
     struct dentry *lower_old_dentry = proxyfs_lower_dentry(old_dentry);
     struct inode *lower_dir = proxyfs_lower_inode(dir);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     if (lower_dir->i_op && lower_dir->i_op->link) {
-        return lower_dir->i_op->link(lower_old_dentry, lower_dir, lower_dentry);
+        int ret = PROXYFS_STATS_LOWER(lower_dir->i_op->link(lower_old_dentry, lower_dir, lower_dentry));
+        if (ret == 0) {
+            proxyfs_event_link(&(struct proxyfs_event_args) {
+                    .inode = d_inode(old_dentry),
+                    .path = old_dentry,
+                    .new_path = dentry,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -178,13 +187,20 @@ static int proxyfs_link(struct dentry *old_dentry,
 static int proxyfs_unlink(struct inode *dir,
                           struct dentry *dentry)
 {
-    PROXYFS_DEBUG("inode=" INODE_FMT ", dentry=%pd\n",
-                  INODE_ARG(dir),
-                  dentry);
+    PROXYFS_STATS(dir->i_sb, INODE_UNLINK);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, 0, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     if (lower_inode->i_op && lower_inode->i_op->unlink) {
-        return lower_inode->i_op->unlink(lower_inode, lower_dentry);
+        int ret = PROXYFS_STATS_LOWER(lower_inode->i_op->unlink(lower_inode, lower_dentry));
+        if (ret == 0) {
+            proxyfs_event_unlink(&(struct proxyfs_event_args) {
+                    .inode = d_inode(dentry),
+                    .path = dentry,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -195,15 +211,20 @@ static int proxyfs_symlink(struct mnt_idmap *idmap,
                            struct dentry *dentry,
                            const char *symname)
 {
-    PROXYFS_DEBUG("idmap=%p, dir=" INODE_FMT ", dentry=%pd, symname=%s\n",
-                  idmap,
-                  INODE_ARG(dir),
-                  dentry,
-                  symname);
+    PROXYFS_STATS(dir->i_sb, INODE_SYMLINK);
+    PROXYFS_STATS_ARGS(dir, 0, 0, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     if (lower_inode->i_op && lower_inode->i_op->symlink) {
-        return lower_inode->i_op->symlink(idmap, lower_inode, lower_dentry, symname);
+        int ret = PROXYFS_STATS_LOWER(lower_inode->i_op->symlink(idmap, lower_inode, lower_dentry, symname));
+        if (ret == 0) {
+            proxyfs_event_symlink(&(struct proxyfs_event_args) {
+                    .inode = d_inode(dentry) ? d_inode(dentry) : dir,
+                    .path = dentry,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -214,15 +235,21 @@ static struct dentry *proxyfs_mkdir(struct mnt_idmap *idmap,
                                     struct dentry *dentry,
                                     umode_t mode)
 {
-    PROXYFS_DEBUG("idmap=%p, dir=" INODE_FMT ", dentry=%pd, mode=0%o\n",
-                  idmap,
-                  INODE_ARG(dir),
-                  dentry,
-                  mode);
+    PROXYFS_STATS(dir->i_sb, INODE_MKDIR);
+    PROXYFS_STATS_ARGS(dir, 0, 0, mode);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     if (lower_inode->i_op && lower_inode->i_op->mkdir) {
-        return lower_inode->i_op->mkdir(idmap, lower_inode, lower_dentry, mode);
+        struct dentry *ret = PROXYFS_STATS_LOWER_PTR(lower_inode->i_op->mkdir(idmap, lower_inode, lower_dentry, mode));
+        if (!IS_ERR(ret)) {
+            proxyfs_event_mkdir(&(struct proxyfs_event_args) {
+                    .inode = d_inode(dentry) ? d_inode(dentry) : dir,
+                    .path = dentry,
+                    .flags = mode,
+                });
+        }
+        return ret;
     }
     return ERR_PTR(-ENOSYS);
 }
@@ -231,13 +258,20 @@ static struct dentry *proxyfs_mkdir(struct mnt_idmap *idmap,
 static int proxyfs_rmdir(struct inode *dir,
                          struct dentry *dentry)
 {
-    PROXYFS_DEBUG("dir=" INODE_FMT ", dentry=%pd\n",
-                  INODE_ARG(dir),
-                  dentry);
+    PROXYFS_STATS(dir->i_sb, INODE_RMDIR);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, 0, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     if (lower_inode->i_op && lower_inode->i_op->rmdir) {
-        return lower_inode->i_op->rmdir(lower_inode, lower_dentry);
+        int ret = PROXYFS_STATS_LOWER(lower_inode->i_op->rmdir(lower_inode, lower_dentry));
+        if (ret == 0) {
+            proxyfs_event_rmdir(&(struct proxyfs_event_args) {
+                    .inode = d_inode(dentry),
+                    .path = dentry,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -249,16 +283,21 @@ static int proxyfs_mknod(struct mnt_idmap *idmap,
                          umode_t mode,
                          dev_t dev)
 {
-    PROXYFS_DEBUG("idmap=%p, dir=" INODE_FMT ", dentry=%pd, mode=0%o, dev=%ul\n",
-                  idmap,
-                  INODE_ARG(dir),
-                  dentry,
-                  mode,
-                  dev);
+    PROXYFS_STATS(dir->i_sb, INODE_MKNOD);
+    PROXYFS_STATS_ARGS(dir, 0, 0, mode);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     if (lower_inode->i_op && lower_inode->i_op->mknod) {
-        return lower_inode->i_op->mknod(idmap, lower_inode, lower_dentry, mode, dev);
+        int ret = PROXYFS_STATS_LOWER(lower_inode->i_op->mknod(idmap, lower_inode, lower_dentry, mode, dev));
+        if (ret == 0) {
+            proxyfs_event_mknod(&(struct proxyfs_event_args) {
+                    .inode = d_inode(dentry) ? d_inode(dentry) : dir,
+                    .path = dentry,
+                    .flags = mode,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -271,19 +310,28 @@ static int proxyfs_rename(struct mnt_idmap *idmap,
                           struct dentry *new_dentry,
                           unsigned int flags)
 {
-    PROXYFS_DEBUG("idmap=%p, old_dir=" INODE_FMT ", old_dentry=%pd, new_dir=" INODE_FMT ", new_dentry=%pd, flags=0x%x\n",
-                  idmap,
-                  INODE_ARG(old_dir),
-                  old_dentry,
-                  INODE_ARG(new_dir),
-                  new_dentry,
-                  flags);
+    PROXYFS_STATS(old_dir->i_sb, INODE_RENAME);
+    PROXYFS_STATS_ARGS(d_inode(old_dentry), 0, 0, flags);
+    PROXYFS_STATS_PATH(old_dentry);
     struct inode *lower_old_dir = proxyfs_lower_inode(old_dir);
     struct dentry *lower_old_dentry = proxyfs_lower_dentry(old_dentry);
     struct inode *lower_new_dir = proxyfs_lower_inode(new_dir);
     struct dentry *lower_new_dentry = proxyfs_lower_dentry(new_dentry);
     if (lower_old_dir->i_op && lower_old_dir->i_op->rename) {
-        return lower_old_dir->i_op->rename(idmap, lower_old_dir, lower_old_dentry, lower_new_dir, lower_new_dentry, flags);
+        int ret = PROXYFS_STATS_LOWER(lower_old_dir->i_op->rename(idmap, lower_old_dir, lower_old_dentry, lower_new_dir, lower_new_dentry, flags));
+        if (ret == 0) {
+            //
+            // Note: verdicts cached for the old paths are dropped once VFS
+            //       moves the dentries (see `proxyfs_filter_check()` and
+            //       `proxyfs_filter_path_seq()`)
+            proxyfs_event_rename(&(struct proxyfs_event_args) {
+                    .inode = d_inode(old_dentry),
+                    .path = old_dentry,
+                    .new_path = new_dentry,
+                    .flags = flags,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -293,14 +341,38 @@ static int proxyfs_setattr(struct mnt_idmap *idmap,
                            struct dentry *dentry,
                            struct iattr *attr)
 {
-    PROXYFS_DEBUG("idmap=%p, dentry=%pd, attr=%p\n",
-                  idmap,
-                  dentry,
-                  attr);
+    PROXYFS_STATS(dentry->d_sb, INODE_SETATTR);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, attr->ia_size, attr->ia_valid);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct inode *lower_inode = d_inode(lower_dentry);
     if (lower_inode->i_op && lower_inode->i_op->setattr) {
-        return lower_inode->i_op->setattr(idmap, lower_dentry, attr);
+        int ret;
+        //
+        // Truncation (including `O_TRUNC` open) has to be allowed by the
+        // monitor
+        if (attr->ia_valid & ATTR_SIZE) {
+            ret = proxyfs_perm_request(PROXYFS_EVENT_OP_TRUNCATE_PERM,
+                                       &(struct proxyfs_event_args) {
+                                           .inode = d_inode(dentry),
+                                           .path = dentry,
+                                           .length = attr->ia_size,
+                                       });
+            if (ret != 0) {
+                return ret;
+            }
+        }
+        ret = PROXYFS_STATS_LOWER(lower_inode->i_op->setattr(idmap, lower_dentry, attr));
+        if (ret == 0) {
+            proxyfs_perm_cache_invalidate(d_inode(dentry));
+            proxyfs_event_setattr(&(struct proxyfs_event_args) {
+                    .inode = d_inode(dentry),
+                    .path = dentry,
+                    .length = attr->ia_size,
+                    .flags = attr->ia_valid,
+                });
+        }
+        return ret;
     }
     return -ENOSYS;
 }
@@ -312,15 +384,12 @@ static int proxyfs_getattr(struct mnt_idmap *idmap,
                            u32 request_mask,
                            unsigned int flags)
 {
-    PROXYFS_DEBUG("idmap=%p, path=%p, stat=%p, request_mask=0x%x, flags=0x%x\n",
-                  idmap,
-                  path,
-                  stat,
-                  request_mask,
-                  flags);
+    PROXYFS_STATS(path->dentry->d_sb, INODE_GETATTR);
+    PROXYFS_STATS_ARGS(d_inode(path->dentry), 0, 0, request_mask);
+    PROXYFS_STATS_PATH(path->dentry);
     struct inode *lower_inode = proxyfs_lower_inode(d_inode(path->dentry));
     if (lower_inode->i_op && lower_inode->i_op->getattr) {
-        return lower_inode->i_op->getattr(idmap, path, stat, request_mask, flags);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->getattr(idmap, path, stat, request_mask, flags));
     }
     return -ENOSYS;
 }
@@ -330,14 +399,13 @@ static ssize_t proxyfs_listxattr(struct dentry *dentry,
                                  char *buffer,
                                  size_t buffer_len)
 {
-    PROXYFS_DEBUG("dentry=%pd, buffer=%p, size=%zu\n",
-                  dentry,
-                  buffer,
-                  buffer_len);
+    PROXYFS_STATS(dentry->d_sb, INODE_LISTXATTR);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, buffer_len, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(d_inode(dentry));
     if (lower_inode->i_op && lower_inode->i_op->listxattr) {
-        return lower_inode->i_op->listxattr(lower_dentry, buffer, buffer_len);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->listxattr(lower_dentry, buffer, buffer_len));
     }
     return -ENOSYS;
 }
@@ -348,26 +416,22 @@ static int proxyfs_fiemap(struct inode *inode,
                           u64 start,
                           u64 len)
 {
-    PROXYFS_DEBUG("inode=" INODE_FMT ", fileinfo=%p, start=%llu, len=%llu\n",
-                  INODE_ARG(inode),
-                  fieinfo,
-                  start,
-                  len);
+    PROXYFS_STATS(inode->i_sb, INODE_FIEMAP);
+    PROXYFS_STATS_ARGS(inode, start, len, fieinfo->fi_flags);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     if (lower_inode->i_op && lower_inode->i_op->fiemap) {
-        return lower_inode->i_op->fiemap(lower_inode, fieinfo, start, len);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->fiemap(lower_inode, fieinfo, start, len));
     }
     return -ENOSYS;
 }
 
 static int proxyfs_update_time(struct inode *inode, int flags)
 {
-    PROXYFS_DEBUG("inode=" INODE_FMT ", flags=0x%x\n",
-                  INODE_ARG(inode),
-                  flags);
+    PROXYFS_STATS(inode->i_sb, INODE_UPDATE_TIME);
+    PROXYFS_STATS_ARGS(inode, 0, 0, flags);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     if (lower_inode->i_op && lower_inode->i_op->update_time) {
-        return lower_inode->i_op->update_time(lower_inode, flags);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->update_time(lower_inode, flags));
     }
     return -ENOSYS;
 }
@@ -379,17 +443,14 @@ static int proxyfs_atomic_open(struct inode *dir,
                                unsigned open_flag,
                                umode_t create_mode)
 {
-    PROXYFS_DEBUG("inode=" INODE_FMT ", dentry=%pd, file=%p, open_flag=0x%x, create_mode=0%o\n",
-                  INODE_ARG(dir),
-                  dentry,
-                  file,
-                  open_flag,
-                  create_mode);
+    PROXYFS_STATS(dir->i_sb, INODE_ATOMIC_OPEN);
+    PROXYFS_STATS_ARGS(dir, 0, 0, open_flag);
+    PROXYFS_STATS_PATH(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     if (lower_inode->i_op && lower_inode->i_op->atomic_open) {
-        return lower_inode->i_op->atomic_open(lower_inode, lower_dentry, lower_file, open_flag, create_mode);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->atomic_open(lower_inode, lower_dentry, lower_file, open_flag, create_mode));
     }
     return -ENOSYS;
 }
@@ -400,15 +461,13 @@ static int proxyfs_tmpfile(struct mnt_idmap *idmap,
                            struct file *file,
                            umode_t mode)
 {
-    PROXYFS_DEBUG("idmap=%p, inode=" INODE_FMT ", file=%p, mode=0%o\n",
-                  idmap,
-                  INODE_ARG(dir),
-                  file,
-                  mode);
+    PROXYFS_STATS(dir->i_sb, INODE_TMPFILE);
+    PROXYFS_STATS_ARGS(dir, 0, 0, mode);
+    PROXYFS_STATS_PATH(file->f_path.dentry);
     struct file *lower_file = proxyfs_lower_file(file);
     struct inode *lower_inode = proxyfs_lower_inode(dir);
     if (lower_inode->i_op && lower_inode->i_op->tmpfile) {
-        return lower_inode->i_op->tmpfile(idmap, lower_inode, lower_file, mode);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->tmpfile(idmap, lower_inode, lower_file, mode));
     }
     return -ENOSYS;
 }
@@ -418,14 +477,13 @@ static struct posix_acl *proxyfs_get_acl(struct mnt_idmap *idmap,
                                          struct dentry *dentry,
                                          int type)
 {
-    PROXYFS_DEBUG("idmap=%p, dentry=%pd, type=%d\n",
-                  idmap,
-                  dentry,
-                  type);
+    PROXYFS_STATS(dentry->d_sb, INODE_GET_ACL);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, 0, type);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(d_inode(dentry));
     if (lower_inode->i_op && lower_inode->i_op->get_acl) {
-        return lower_inode->i_op->get_acl(idmap, lower_dentry, type);
+        return PROXYFS_STATS_LOWER_PTR(lower_inode->i_op->get_acl(idmap, lower_dentry, type));
     }
     return ERR_PTR(-ENOSYS);
 }
@@ -436,15 +494,13 @@ static int proxyfs_set_acl(struct mnt_idmap *idmap,
                            struct posix_acl *acl,
                            int type)
 {
-    PROXYFS_DEBUG("idmap=%p, dentry=%pd, acl=%p, type=%d\n",
-                  idmap,
-                  dentry,
-                  acl,
-                  type);
+    PROXYFS_STATS(dentry->d_sb, INODE_SET_ACL);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, 0, type);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(d_inode(dentry));
     if (lower_inode->i_op && lower_inode->i_op->set_acl) {
-        return lower_inode->i_op->set_acl(idmap, lower_dentry, acl, type);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->set_acl(idmap, lower_dentry, acl, type));
     }
     return -ENOSYS;
 }
@@ -454,14 +510,13 @@ static int proxyfs_fileattr_set(struct mnt_idmap *idmap,
                                 struct dentry *dentry,
                                 struct fileattr *fa)
 {
-    PROXYFS_DEBUG("idmap=%p, dentry=%pd, fa=%p\n",
-                  idmap,
-                  dentry,
-                  fa);
+    PROXYFS_STATS(dentry->d_sb, INODE_FILEATTR_SET);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, 0, fa->flags);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(d_inode(dentry));
     if (lower_inode->i_op && lower_inode->i_op->fileattr_set) {
-        return lower_inode->i_op->fileattr_set(idmap, lower_dentry, fa);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->fileattr_set(idmap, lower_dentry, fa));
     }
     return -ENOSYS;
 }
@@ -470,13 +525,13 @@ static int proxyfs_fileattr_set(struct mnt_idmap *idmap,
 static int proxyfs_fileattr_get(struct dentry *dentry,
                                 struct fileattr *fa)
 {
-    PROXYFS_DEBUG("dentry=%pd, fa=%p\n",
-                  dentry,
-                  fa);
+    PROXYFS_STATS(dentry->d_sb, INODE_FILEATTR_GET);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, 0, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct dentry *lower_dentry = proxyfs_lower_dentry(dentry);
     struct inode *lower_inode = proxyfs_lower_inode(d_inode(dentry));
     if (lower_inode->i_op && lower_inode->i_op->fileattr_get) {
-        return lower_inode->i_op->fileattr_get(lower_dentry, fa);
+        return PROXYFS_STATS_LOWER(lower_inode->i_op->fileattr_get(lower_dentry, fa));
     }
     return -ENOSYS;
 }
@@ -484,11 +539,11 @@ static int proxyfs_fileattr_get(struct dentry *dentry,
 // get_offset_ctx()
 static struct offset_ctx *proxyfs_get_offset_ctx(struct inode *inode)
 {
-    PROXYFS_DEBUG("inode=" INODE_FMT "\n",
-                  INODE_ARG(inode));
+    PROXYFS_STATS(inode->i_sb, INODE_GET_OFFSET_CTX);
+    PROXYFS_STATS_ARGS(inode, 0, 0, 0);
     struct inode *lower_inode = proxyfs_lower_inode(inode);
     if (lower_inode->i_op && lower_inode->i_op->get_offset_ctx) {
-        return lower_inode->i_op->get_offset_ctx(lower_inode);
+        return PROXYFS_STATS_LOWER_PTR(lower_inode->i_op->get_offset_ctx(lower_inode));
     }
     return NULL;
 }
@@ -10,11 +10,114 @@
 // #include <linux/slab.h>
 #include <linux/mount.h>
 #include <linux/init.h>
+#include <linux/slab.h>
 
 //// #include <linux/cred.h>
 //// #include <linux/kernel_read_file.h>
 
 #include "proxyfs.h"
+#include "proxyfs-ring.h"
+#include "proxyfs-trace.h"
+
+//
+// Geometry of the event buffer pool, see `struct proxyfs_buffer_pool_config`
+static unsigned int pool_counts[PROXYFS_BUFFER_CLASS_COUNT] = PROXYFS_BUFFER_CLASS_COUNTS;
+module_param_array(pool_counts, uint, NULL, 0444);
+MODULE_PARM_DESC(pool_counts, "Initial number of event buffers of every size class");
+
+static unsigned int pool_sizes[PROXYFS_BUFFER_CLASS_COUNT] = PROXYFS_BUFFER_CLASS_SIZES;
+module_param_array(pool_sizes, uint, NULL, 0444);
+MODULE_PARM_DESC(pool_sizes, "Event buffer size of every size class (ascending)");
+
+static unsigned int pool_low_watermark = PROXYFS_BUFFER_POOL_LOW_WATERMARK;
+module_param(pool_low_watermark, uint, 0444);
+MODULE_PARM_DESC(pool_low_watermark, "Usage of a size class (percents) to shrink it");
+
+static unsigned int pool_high_watermark = PROXYFS_BUFFER_POOL_HIGH_WATERMARK;
+module_param(pool_high_watermark, uint, 0444);
+MODULE_PARM_DESC(pool_high_watermark, "Usage of a size class (percents) to grow it");
+
+//
+// NETLINK delivery parameters, see `struct proxyfs_socket_config`
+static bool netlink_batch = false;
+module_param(netlink_batch, bool, 0444);
+MODULE_PARM_DESC(netlink_batch, "Pack events to multipart NETLINK messages");
+
+static unsigned int netlink_batch_latency_us = PROXYFS_SOCKET_BATCH_LATENCY_US;
+module_param(netlink_batch_latency_us, uint, 0444);
+MODULE_PARM_DESC(netlink_batch_latency_us, "Longest time (us) an event waits in a batch");
+
+static unsigned int netlink_batch_bytes = PROXYFS_SOCKET_BATCH_BYTES;
+module_param(netlink_batch_bytes, uint, 0444);
+MODULE_PARM_DESC(netlink_batch_bytes, "Size of a batch (bytes) to be sent immediately");
+
+//
+// Shared memory ring parameters, see `struct proxyfs_ring_config`
+static unsigned int ring_records = PROXYFS_RING_RECORDS;
+module_param(ring_records, uint, 0444);
+MODULE_PARM_DESC(ring_records, "Number of records (power of 2) of /dev/proxyfs ring, 0 to disable");
+
+static unsigned int ring_record_size = PROXYFS_RING_RECORD_SIZE;
+module_param(ring_record_size, uint, 0444);
+MODULE_PARM_DESC(ring_record_size, "Minimal size of a record slot of /dev/proxyfs ring (enlarged to fit any event)");
+
+static bool ring_exclusive = true;
+module_param(ring_exclusive, bool, 0444);
+MODULE_PARM_DESC(ring_exclusive, "Don't send events (but permission requests) over NETLINK while /dev/proxyfs ring consumer is attached");
+
+//
+// Event queue parameters, see `struct proxyfs_queue_config`
+static unsigned int queue_records = PROXYFS_QUEUE_RECORDS;
+module_param(queue_records, uint, 0444);
+MODULE_PARM_DESC(queue_records, "Number of records (power of 2) of a per-CPU event queue, 0 to send events synchronously (`block` backpressure policy drops events at once then)");
+
+//
+// Event coalescing parameters, see `struct proxyfs_coalesce_config`
+static unsigned int coalesce_window_us = 0;
+module_param(coalesce_window_us, uint, 0444);
+MODULE_PARM_DESC(coalesce_window_us, "Time window (us) repeated reads/writes of a file are merged within, 0 to disable");
+
+//
+// Permission request parameters, see `struct proxyfs_perm_config`
+static unsigned int perm_timeout_ms = PROXYFS_PERM_TIMEOUT_MS;
+module_param(perm_timeout_ms, uint, 0444);
+MODULE_PARM_DESC(perm_timeout_ms, "Time (ms) a task waits for the verdict of its permission request");
+static bool perm_default_deny = false;
+module_param(perm_default_deny, bool, 0444);
+MODULE_PARM_DESC(perm_default_deny, "Deny the operation if its permission request is not answered in time");
+static unsigned int perm_cache_entries = PROXYFS_PERM_CACHE_ENTRIES;
+module_param(perm_cache_entries, uint, 0444);
+MODULE_PARM_DESC(perm_cache_entries, "Number of verdicts of permission requests cached, 0 to disable");
+
+//
+// Flight recorder parameters, see `struct proxyfs_flight_config`
+static unsigned int flight_records = PROXYFS_FLIGHT_RECORDS;
+module_param(flight_records, uint, 0444);
+MODULE_PARM_DESC(flight_records, "Number of calls (power of 2) recorded by the flight recorder of a CPU, 0 to disable");
+static unsigned int flight_slow_ms = PROXYFS_FLIGHT_SLOW_MS;
+module_param(flight_slow_ms, uint, 0444);
+MODULE_PARM_DESC(flight_slow_ms, "Time (ms) of a call taking the flight recorder snapshot, 0 to disable");
+static bool flight_errors = true;
+module_param(flight_errors, bool, 0444);
+MODULE_PARM_DESC(flight_errors, "Take the flight recorder snapshot when a call fails with an I/O class error");
+
+//
+// Slow call detector parameters, see `struct proxyfs_slow_config`
+static unsigned int slow_threshold_ms = PROXYFS_SLOW_THRESHOLD_MS;
+module_param(slow_threshold_ms, uint, 0444);
+MODULE_PARM_DESC(slow_threshold_ms, "Time (ms) a call is reported as slow after, 0 to disable");
+static unsigned int slow_burst = PROXYFS_SLOW_BURST;
+module_param(slow_burst, uint, 0444);
+MODULE_PARM_DESC(slow_burst, "Number of slow calls reported one by one per second, the rest are summarized");
+static bool slow_stack = false;
+module_param(slow_stack, bool, 0444);
+MODULE_PARM_DESC(slow_stack, "Record the stack of a slow call");
+
+//
+// Heavy hitters parameters, see `struct proxyfs_top_config`
+static unsigned int top_window_s = PROXYFS_TOP_WINDOW_S;
+module_param(top_window_s, uint, 0444);
+MODULE_PARM_DESC(top_window_s, "Window (s) the top files and processes are counted within, 0 to disable");
 
 // mount routine
 static struct dentry *proxyfs_mount(struct file_system_type *fs_type,
@@ -22,28 +125,97 @@ static struct dentry *proxyfs_mount(struct file_system_type *fs_type,
                                     const char *dev_name,
                                     void *data)
 {
-    pr_info("%s: %s: mount lowerdir = %s\n",
-            MODULE_NAME,
-            __FUNCTION__,
-            (char *)data);
+    trace_proxyfs_mount((const char *)data, flags);
     return mount_nodev(fs_type, flags, data, proxyfs_fill_super_block);
 }
 
+// kill_sb routine
+static void proxyfs_kill_sb(struct super_block *sb)
+{
+    struct proxyfs_sb_info *sb_info = sb->s_fs_info;
+
+    proxyfs_procfs_mount_remove(sb);
+    //
+    // Note: pending coalesced records and slow calls hold dentries of
+    //       the mount
+    proxyfs_coalesce_flush_sb(sb);
+    proxyfs_slow_flush();
+    kill_anon_super(sb);
+    //
+    // Note: operations of the mount are not called any more, the info
+    //       is released here on failed mounts as well
+    if (sb_info != NULL) {
+        proxyfs_stats_free(sb_info->stats);
+        kfree(sb_info);
+        sb->s_fs_info = NULL;
+    }
+}
+
 
 // FS description
 static struct file_system_type proxyfs_type = {
     .owner      = THIS_MODULE,
     .name       = MODULE_NAME,
     .mount      = proxyfs_mount,
-    .kill_sb    = kill_anon_super,
+    .kill_sb    = proxyfs_kill_sb,
 };
 
 static int __init proxyfs_init(void)
 {
+    struct proxyfs_context_config config = {
+        .pool = {
+            .low_watermark = pool_low_watermark,
+            .high_watermark = pool_high_watermark,
+        },
+        .socket = {
+            .batch = netlink_batch,
+            .batch_latency_us = netlink_batch_latency_us,
+            .batch_bytes = netlink_batch_bytes,
+        },
+        .ring = {
+            .records = ring_records,
+            .record_size = ring_record_size,
+            .exclusive = ring_exclusive,
+        },
+        .queue = {
+            .records = queue_records,
+        },
+        .coalesce = {
+            .window_us = coalesce_window_us,
+        },
+        .perm = {
+            .timeout_ms = perm_timeout_ms,
+            .default_deny = perm_default_deny,
+            .cache_entries = perm_cache_entries,
+        },
+        .flight = {
+            .records = flight_records,
+            .slow_ms = flight_slow_ms,
+            .errors = flight_errors,
+        },
+        .slow = {
+            .threshold_ms = slow_threshold_ms,
+            .burst = slow_burst,
+            .stack = slow_stack,
+        },
+        .top = {
+            .window_s = top_window_s,
+        },
+    };
+    int res;
+
     pr_info("%s: %s: init\n",
             MODULE_NAME,
             __FUNCTION__);
-    return register_filesystem(&proxyfs_type);
+    memcpy(config.pool.counts, pool_counts, sizeof(config.pool.counts));
+    memcpy(config.pool.sizes, pool_sizes, sizeof(config.pool.sizes));
+    if ((res = proxyfs_context_init(&config)) != 0) {
+        return res;
+    }
+    if ((res = register_filesystem(&proxyfs_type)) != 0) {
+        proxyfs_context_release();
+    }
+    return res;
 }
 
 static void __exit proxyfs_exit(void)
@@ -52,6 +224,7 @@ static void __exit proxyfs_exit(void)
             MODULE_NAME,
             __FUNCTION__);
     unregister_filesystem(&proxyfs_type);
+    proxyfs_context_release();
 }
 
 module_init(proxyfs_init);
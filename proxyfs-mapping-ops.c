@@ -10,12 +10,13 @@ static int proxyfs_writepage(struct page *page,
 {
     if (page && page->mapping) {
         struct inode *inode = page->mapping->host;
+        PROXYFS_STATS(inode->i_sb, MAPPING_WRITEPAGE);
         struct inode *lower_inode = proxyfs_lower_inode(inode);
         if (lower_inode &&
             lower_inode->i_mapping &&
             lower_inode->i_mapping->a_ops &&
             lower_inode->i_mapping->a_ops->writepage) {
-            return lower_inode->i_mapping->a_ops->writepage(page, wbc);
+            return PROXYFS_STATS_LOWER(lower_inode->i_mapping->a_ops->writepage(page, wbc));
         }
     }
     return -EIO;
@@ -27,6 +28,7 @@ static int proxyfs_read_folio(struct file *file,
 {
     if (file) {
         struct inode *inode = file->f_inode;
+        PROXYFS_STATS(inode->i_sb, MAPPING_READ_FOLIO);
         struct inode *lower_inode = proxyfs_lower_inode(inode);
         struct file *lower_file = proxyfs_lower_file(file);
         if (lower_inode &&
@@ -35,7 +37,7 @@ static int proxyfs_read_folio(struct file *file,
             lower_inode->i_mapping->a_ops->read_folio &&
             lower_file)
         {
-            return lower_inode->i_mapping->a_ops->read_folio(lower_file, folio);
+            return PROXYFS_STATS_LOWER(lower_inode->i_mapping->a_ops->read_folio(lower_file, folio));
         }
     }
     return -EIO;
@@ -47,13 +49,14 @@ static int proxyfs_writepages(struct address_space *mapping,
 {
     if (mapping) {
         struct inode *inode = mapping->host;
+        PROXYFS_STATS(inode->i_sb, MAPPING_WRITEPAGES);
         struct inode *lower_inode = proxyfs_lower_inode(inode);
         struct address_space *lower_mapping = lower_inode ? lower_inode->i_mapping : NULL;
         if (lower_mapping &&
             lower_mapping->a_ops &&
             lower_mapping->a_ops->writepages)
         {
-            return lower_mapping->a_ops->writepages(lower_mapping, wbc);
+            return PROXYFS_STATS_LOWER(lower_mapping->a_ops->writepages(lower_mapping, wbc));
         }
     }
     return -EIO;
@@ -65,13 +68,14 @@ static bool proxyfs_dirty_folio(struct address_space *mapping,
 {
     if (mapping) {
         struct inode *inode = mapping->host;
+        PROXYFS_STATS(inode->i_sb, MAPPING_DIRTY_FOLIO);
         struct inode *lower_inode = proxyfs_lower_inode(inode);
         struct address_space *lower_mapping = lower_inode ? lower_inode->i_mapping : NULL;
         if (lower_mapping &&
             lower_mapping->a_ops &&
             lower_mapping->a_ops->dirty_folio)
         {
-            return lower_mapping->a_ops->dirty_folio(lower_mapping, folio);
+            return PROXYFS_STATS_LOWER(lower_mapping->a_ops->dirty_folio(lower_mapping, folio));
         }
     }
     return false;
@@ -83,12 +87,13 @@ static void proxyfs_readahead(struct readahead_control *rac)
     if (rac &&
         rac->mapping) {
         struct inode *inode = rac->mapping->host;
+        PROXYFS_STATS(inode->i_sb, MAPPING_READAHEAD);
         struct inode *lower_inode = proxyfs_lower_inode(inode);
         struct address_space *lower_mapping = lower_inode ? lower_inode->i_mapping : NULL;
         if (lower_mapping && lower_mapping->a_ops &&
             lower_mapping->a_ops->readahead)
         {
-            lower_mapping->a_ops->readahead(rac);
+            PROXYFS_STATS_LOWER_VOID(lower_mapping->a_ops->readahead(rac));
         }
     }
 }
@@ -101,6 +106,7 @@ static int proxyfs_write_begin(struct file *file,
                                struct folio **foliop,
                                void **fsdata)
 {
+    PROXYFS_STATS(mapping->host->i_sb, MAPPING_WRITE_BEGIN);
     pgoff_t index = pos >> PAGE_SHIFT;
     struct folio *folio = NULL;
     struct folio *lower_folio = NULL;
@@ -112,12 +118,12 @@ static int proxyfs_write_begin(struct file *file,
     do {
         // 1. Invoke underlying FS (if available) to create its own folio object
         if (lower_mapping->a_ops && lower_mapping->a_ops->write_begin) {
-            if ((ret = lower_mapping->a_ops->write_begin(lower_file,
-                                                         lower_mapping,
-                                                         pos,
-                                                         len,
-                                                         &lower_folio,
-                                                         fsdata)) != 0)  {
+            if ((ret = PROXYFS_STATS_LOWER(lower_mapping->a_ops->write_begin(lower_file,
+                                                                             lower_mapping,
+                                                                             pos,
+                                                                             len,
+                                                                             &lower_folio,
+                                                                             fsdata))) != 0)  {
                 break;
             }
         } else {
@@ -163,7 +169,7 @@ static int proxyfs_write_begin(struct file *file,
         // TBD: probably we need to call `folio_put(lower_folio)` if reference
         //      count is increased (extra check is required)
         if (lower_mapping->a_ops->release_folio) {
-            lower_mapping->a_ops->release_folio(lower_folio, GFP_KERNEL);
+            PROXYFS_STATS_LOWER_VOID(lower_mapping->a_ops->release_folio(lower_folio, GFP_KERNEL));
         }
         lower_folio = NULL;
     }
@@ -179,6 +185,7 @@ static int proxyfs_write_end(struct file *file,
                              struct folio *folio,
                              void *fsdata)
 {
+    PROXYFS_STATS(mapping->host->i_sb, MAPPING_WRITE_END);
     struct file *lower_file = proxyfs_lower_file(file);
     struct address_space *lower_mapping = lower_file->f_mapping;
     struct folio *lower_folio = proxyfs_lower_folio(folio);
@@ -186,13 +193,13 @@ static int proxyfs_write_end(struct file *file,
     int ret = copied;
 
     if (lower_mapping && lower_mapping->a_ops && lower_mapping->a_ops->write_end) {
-        ret = lower_mapping->a_ops->write_end(lower_file,
-                                              lower_mapping,
-                                              pos,
-                                              len,
-                                              copied,
-                                              lower_folio,
-                                              fsdata);
+        ret = PROXYFS_STATS_LOWER(lower_mapping->a_ops->write_end(lower_file,
+                                                                  lower_mapping,
+                                                                  pos,
+                                                                  len,
+                                                                  copied,
+                                                                  lower_folio,
+                                                                  fsdata));
     } else {
         ret = -ENOSYS;
     }
@@ -206,10 +213,11 @@ static sector_t proxyfs_bmap(struct address_space *mapping,
 {
     if (mapping) {
         struct inode *inode = mapping->host;
+        PROXYFS_STATS(inode->i_sb, MAPPING_BMAP);
         struct inode *lower_inode = proxyfs_lower_inode(inode);
         struct address_space *lower_mapping = lower_inode ? lower_inode->i_mapping : NULL;
         if (lower_mapping && lower_mapping->a_ops && lower_mapping->a_ops->bmap) {
-            return lower_mapping->a_ops->bmap(lower_mapping, block);
+            return PROXYFS_STATS_LOWER(lower_mapping->a_ops->bmap(lower_mapping, block));
         }
     }
     return 0;
@@ -251,6 +259,7 @@ static ssize_t proxyfs_direct_IO(struct kiocb *iocb,
     if (iocb == NULL) {
         return -EINVAL;
     }
+    PROXYFS_STATS(file_inode(iocb->ki_filp)->i_sb, MAPPING_DIRECT_IO);
     struct file *lower_file = proxyfs_lower_file(iocb->ki_filp);
     if (lower_file &&
         lower_file->f_mapping &&
@@ -258,7 +267,7 @@ static ssize_t proxyfs_direct_IO(struct kiocb *iocb,
         lower_file->f_mapping->a_ops->direct_IO) {
         struct kiocb lower_iocb = *iocb;
         lower_iocb.ki_filp = lower_file;
-        return lower_file->f_mapping->a_ops->direct_IO(&lower_iocb, iter);
+        return PROXYFS_STATS_LOWER(lower_file->f_mapping->a_ops->direct_IO(&lower_iocb, iter));
     }
     return -ENOSYS;
 }
@@ -0,0 +1,466 @@
+// File		:proxyfs-perm.c
+// Author	:Victor Kovalevich
+// Created	:Sat Oct 17 00:27:45 2026
+#include <linux/hashtable.h>
+#include <linux/completion.h>
+#include <linux/jiffies.h>
+#include <linux/sched.h>
+#include <linux/slab.h>
+#include <linux/cred.h>
+#include <linux/iversion.h>
+#include <linux/seq_file.h>
+#include "proxyfs.h"
+
+//
+// Permission request of a task waiting for the verdict of the client, the
+// request lives on the stack of the task
+struct proxyfs_perm_request {
+    struct hlist_node node;
+    u64 id;
+    u32 response;
+    struct completion done;
+};
+
+static DEFINE_HASHTABLE(proxyfs_perm_requests, PROXYFS_PERM_HASH_BITS);
+//
+// Protects the table of the pending requests, a verdict completes the
+// request under the lock (thus the task may return once it is unhashed)
+//
+// Note: the requests are cancelled by the batch timer as well (softirq
+//       context, the client is withdrawn there), thus the lock is taken
+//       with bottom halves disabled
+static DEFINE_SPINLOCK(proxyfs_perm_lock);
+
+//
+// Verdict of the client cached by the proxy inode, it is valid while the
+// version and the change time of the lower inode and the path of the file
+// are the same as when the request was issued
+struct proxyfs_perm_cache_entry {
+    struct hlist_node node;
+    struct list_head lru;
+    struct proxyfs_inode *inode;
+    enum proxyfs_event_op op;
+    uid_t uid;
+    u64 version;
+    struct timespec64 ctime;
+    u32 path;
+    u32 response;
+};
+
+//
+// Protects the cached verdicts of all inodes and their LRU list (the
+// least recently used verdicts are first)
+//
+// Note: the verdicts are flushed by the batch timer as well (softirq
+//       context, the client is withdrawn there), thus the lock is taken
+//       with bottom halves disabled
+static DEFINE_SPINLOCK(proxyfs_perm_cache_lock);
+static LIST_HEAD(proxyfs_perm_cache_lru);
+
+static struct {
+    unsigned int entries;
+    unsigned int max_entries;
+    atomic_long_t hits;
+    atomic_long_t misses;
+} proxyfs_perm_cache;
+
+static struct {
+    unsigned int timeout_ms;
+    u32 default_response;
+    atomic64_t seq;
+    atomic_t pending;
+    atomic_long_t allowed;
+    atomic_long_t denied;
+    atomic_long_t timeouts;
+    atomic_long_t unknown;
+} proxyfs_perm;
+
+//
+// Check if the registered client answers permission requests of the
+// current task (the client itself is never asked)
+static bool proxyfs_perm_is_requested(void)
+{
+    struct proxyfs_client *client;
+    bool res = false;
+    int idx;
+
+    if (!proxyfs_context_check_is_running()) {
+        return false;
+    }
+    idx = proxyfs_context_client_read_lock();
+    if ((client = proxyfs_context_get_client()) != NULL) {
+        res = (client->classes & BIT(PROXYFS_EVENT_CLASS_PERMISSION)) &&
+            client->pid != task_tgid(current);
+    }
+    proxyfs_context_client_read_unlock(idx);
+    return res;
+}
+
+//
+// Key of the verdict: the state of the file it has been given for
+struct proxyfs_perm_cache_key {
+    enum proxyfs_event_op op;
+    uid_t uid;
+    u64 version;
+    struct timespec64 ctime;
+    //
+    // Sequence of the path (see `proxyfs_filter_path_seq()`), thus the
+    // verdicts are dropped once the file or a directory above it is moved
+    u32 path;
+};
+
+//
+// Take the key of the request, false is returned if the verdict can't be
+// cached (the path of the file is being changed right now)
+static bool proxyfs_perm_cache_key_init(struct proxyfs_perm_cache_key *key,
+                                        enum proxyfs_event_op op,
+                                        const struct proxyfs_event_args *args)
+{
+    struct inode *lower_inode = proxyfs_lower_inode(args->inode) ?: args->inode;
+    bool res = true;
+
+    key->op = op;
+    key->uid = from_kuid(&init_user_ns, current_fsuid());
+    key->version = IS_I_VERSION(lower_inode) ? inode_query_iversion(lower_inode) : 0;
+    key->ctime = inode_get_ctime(lower_inode);
+    key->path = 0;
+    if (args->path != NULL) {
+        rcu_read_lock();
+        res = proxyfs_filter_path_seq(args->path, 0, &key->path);
+        rcu_read_unlock();
+    }
+    return res;
+}
+
+static bool proxyfs_perm_cache_match(const struct proxyfs_perm_cache_entry *entry,
+                                     const struct proxyfs_perm_cache_key *key)
+{
+    return entry->op == key->op && entry->uid == key->uid;
+}
+
+//
+// Cached verdict of the key, 0 is returned if there is none
+static u32 proxyfs_perm_cache_lookup(struct inode *inode,
+                                     const struct proxyfs_perm_cache_key *key)
+{
+    struct proxyfs_inode *proxyfs_inode = container_of(inode, struct proxyfs_inode, vfs_inode);
+    struct proxyfs_perm_cache_entry *entry;
+    u32 response = 0;
+
+    if (READ_ONCE(proxyfs_perm_cache.max_entries) == 0) {
+        return 0;
+    }
+    if (hlist_empty(&proxyfs_inode->perm_cache)) {
+        atomic_long_inc(&proxyfs_perm_cache.misses);
+        return 0;
+    }
+    spin_lock_bh(&proxyfs_perm_cache_lock);
+    hlist_for_each_entry(entry, &proxyfs_inode->perm_cache, node) {
+        if (proxyfs_perm_cache_match(entry, key)) {
+            if (entry->version == key->version &&
+                timespec64_equal(&entry->ctime, &key->ctime) &&
+                entry->path == key->path) {
+                list_move_tail(&entry->lru, &proxyfs_perm_cache_lru);
+                response = entry->response;
+            }
+            break;
+        }
+    }
+    spin_unlock_bh(&proxyfs_perm_cache_lock);
+    atomic_long_inc(response ? &proxyfs_perm_cache.hits : &proxyfs_perm_cache.misses);
+    return response;
+}
+
+// Note: must be called with the cache lock held
+static void proxyfs_perm_cache_unlink(struct proxyfs_perm_cache_entry *entry)
+{
+    hlist_del(&entry->node);
+    list_del(&entry->lru);
+    proxyfs_perm_cache.entries--;
+}
+
+//
+// Cache the verdict given for the key, the least recently used verdict
+// is evicted if the cache is full
+static void proxyfs_perm_cache_insert(struct inode *inode,
+                                      const struct proxyfs_perm_cache_key *key,
+                                      u32 response)
+{
+    struct proxyfs_inode *proxyfs_inode = container_of(inode, struct proxyfs_inode, vfs_inode);
+    struct proxyfs_perm_cache_entry *entry;
+    struct proxyfs_perm_cache_entry *evicted = NULL;
+    struct proxyfs_perm_cache_entry *new_entry;
+
+    if (READ_ONCE(proxyfs_perm_cache.max_entries) == 0 ||
+        (new_entry = kmalloc(sizeof(*new_entry), GFP_KERNEL)) == NULL) {
+        return;
+    }
+    new_entry->inode = proxyfs_inode;
+    new_entry->op = key->op;
+    new_entry->uid = key->uid;
+    new_entry->version = key->version;
+    new_entry->ctime = key->ctime;
+    new_entry->path = key->path;
+    new_entry->response = response;
+
+    spin_lock_bh(&proxyfs_perm_cache_lock);
+    hlist_for_each_entry(entry, &proxyfs_inode->perm_cache, node) {
+        if (proxyfs_perm_cache_match(entry, key)) {
+            proxyfs_perm_cache_unlink(entry);
+            evicted = entry;
+            break;
+        }
+    }
+    if (evicted == NULL && proxyfs_perm_cache.entries >= proxyfs_perm_cache.max_entries) {
+        evicted = list_first_entry(&proxyfs_perm_cache_lru, struct proxyfs_perm_cache_entry, lru);
+        proxyfs_perm_cache_unlink(evicted);
+    }
+    hlist_add_head(&new_entry->node, &proxyfs_inode->perm_cache);
+    list_add_tail(&new_entry->lru, &proxyfs_perm_cache_lru);
+    proxyfs_perm_cache.entries++;
+    spin_unlock_bh(&proxyfs_perm_cache_lock);
+
+    kfree(evicted);
+}
+
+//
+// Drop the verdicts cached by the inode (its content, attributes or name
+// have changed or it is destroyed)
+void proxyfs_perm_cache_invalidate(struct inode *inode)
+{
+    struct proxyfs_inode *proxyfs_inode;
+    struct proxyfs_perm_cache_entry *entry;
+    struct hlist_node *tmp;
+    HLIST_HEAD(dropped);
+
+    if (inode == NULL) {
+        return;
+    }
+    proxyfs_inode = container_of(inode, struct proxyfs_inode, vfs_inode);
+    if (hlist_empty(&proxyfs_inode->perm_cache)) {
+        return;
+    }
+    spin_lock_bh(&proxyfs_perm_cache_lock);
+    hlist_for_each_entry_safe(entry, tmp, &proxyfs_inode->perm_cache, node) {
+        proxyfs_perm_cache_unlink(entry);
+        hlist_add_head(&entry->node, &dropped);
+    }
+    spin_unlock_bh(&proxyfs_perm_cache_lock);
+    hlist_for_each_entry_safe(entry, tmp, &dropped, node) {
+        kfree(entry);
+    }
+}
+
+//
+// Drop all the cached verdicts (the client which gave them is gone)
+void proxyfs_perm_cache_flush(void)
+{
+    struct proxyfs_perm_cache_entry *entry;
+    struct proxyfs_perm_cache_entry *tmp;
+    LIST_HEAD(dropped);
+
+    spin_lock_bh(&proxyfs_perm_cache_lock);
+    list_for_each_entry_safe(entry, tmp, &proxyfs_perm_cache_lru, lru) {
+        hlist_del(&entry->node);
+    }
+    list_splice_init(&proxyfs_perm_cache_lru, &dropped);
+    proxyfs_perm_cache.entries = 0;
+    spin_unlock_bh(&proxyfs_perm_cache_lock);
+    list_for_each_entry_safe(entry, tmp, &dropped, lru) {
+        kfree(entry);
+    }
+}
+
+//
+// Send the request to the client and wait for its verdict, 0 is returned
+// if there is no verdict (`timeout` is negative if the wait is killed)
+static u32 proxyfs_perm_ask(enum proxyfs_event_op op,
+                            const struct proxyfs_event_args *args,
+                            long *timeout)
+{
+    struct proxyfs_perm_request request;
+    struct proxyfs_event_args request_args = *args;
+    u32 response;
+
+    request.id = atomic64_inc_return(&proxyfs_perm.seq);
+    request.response = 0;
+    init_completion(&request.done);
+    spin_lock_bh(&proxyfs_perm_lock);
+    hash_add(proxyfs_perm_requests, &request.node, request.id);
+    spin_unlock_bh(&proxyfs_perm_lock);
+    atomic_inc(&proxyfs_perm.pending);
+
+    *timeout = 0;
+    request_args.request = request.id;
+    if (proxyfs_event_request(op, &request_args)) {
+        *timeout = wait_for_completion_killable_timeout(&request.done,
+                                                        msecs_to_jiffies(READ_ONCE(proxyfs_perm.timeout_ms)));
+    }
+
+    spin_lock_bh(&proxyfs_perm_lock);
+    if (hash_hashed(&request.node)) {
+        hash_del(&request.node);
+    }
+    response = request.response;
+    spin_unlock_bh(&proxyfs_perm_lock);
+    atomic_dec(&proxyfs_perm.pending);
+    return response;
+}
+
+//
+// Ask the client if the operation is permitted and wait for its verdict,
+// 0 is returned if the operation is allowed, -EPERM if it is denied;
+// verdicts of the client are cached until the file changes
+//
+// Note: the task waits killable, thus a stalled client can't keep a task
+//       which is being killed; the default verdict is applied on timeout
+int proxyfs_perm_request(enum proxyfs_event_op op,
+                         const struct proxyfs_event_args *args)
+{
+    struct proxyfs_perm_cache_key key;
+    bool cacheable;
+    long timeout;
+    u32 response;
+
+    if (!proxyfs_perm_is_requested() ||
+        !proxyfs_pids_is_monitored() ||
+        !proxyfs_filter_check(op, args)) {
+        return 0;
+    }
+    //
+    // Note: the key is taken before the request is sent, thus a change
+    //       made while the client decides makes the verdict stale
+    cacheable = proxyfs_perm_cache_key_init(&key, op, args);
+    if (!cacheable || (response = proxyfs_perm_cache_lookup(args->inode, &key)) == 0) {
+        if ((response = proxyfs_perm_ask(op, args, &timeout)) != 0) {
+            if (cacheable) {
+                proxyfs_perm_cache_insert(args->inode, &key, response);
+            }
+        } else if (timeout < 0) {
+            return -EINTR;
+        } else {
+            atomic_long_inc(&proxyfs_perm.timeouts);
+            response = READ_ONCE(proxyfs_perm.default_response);
+        }
+    }
+    if (response == PROXYFS_PERM_ALLOW) {
+        atomic_long_inc(&proxyfs_perm.allowed);
+        return 0;
+    }
+    atomic_long_inc(&proxyfs_perm.denied);
+    return -EPERM;
+}
+
+//
+// Complete the requests answered by the verdicts, the verdicts are taken
+// from the registered client only
+void proxyfs_perm_verdicts(u32 portid,
+                           const struct proxyfs_client_verdict *verdicts,
+                           u32 count)
+{
+    struct proxyfs_perm_request *request;
+    struct proxyfs_client *client;
+    bool found;
+    u32 i;
+    int idx;
+
+    idx = proxyfs_context_client_read_lock();
+    client = proxyfs_context_get_client();
+    if (client == NULL || client->portid != portid) {
+        proxyfs_context_client_read_unlock(idx);
+        pr_warn("%s: Verdicts from port %u which is not the client are ignored\n",
+                MODULE_NAME,
+                portid);
+        return;
+    }
+    proxyfs_context_client_read_unlock(idx);
+
+    spin_lock_bh(&proxyfs_perm_lock);
+    for (i = 0; i < count; i++) {
+        if (verdicts[i].response != PROXYFS_PERM_ALLOW &&
+            verdicts[i].response != PROXYFS_PERM_DENY) {
+            atomic_long_inc(&proxyfs_perm.unknown);
+            continue;
+        }
+        found = false;
+        hash_for_each_possible(proxyfs_perm_requests, request, node, verdicts[i].request) {
+            if (request->id == verdicts[i].request) {
+                hash_del(&request->node);
+                request->response = verdicts[i].response;
+                complete(&request->done);
+                found = true;
+                break;
+            }
+        }
+        //
+        // Note: the request may have timed out already
+        if (!found) {
+            atomic_long_inc(&proxyfs_perm.unknown);
+        }
+    }
+    spin_unlock_bh(&proxyfs_perm_lock);
+}
+
+//
+// Wake up the tasks waiting for the verdicts (the client is gone), the
+// default verdict is applied to their requests
+void proxyfs_perm_cancel(void)
+{
+    struct proxyfs_perm_request *request;
+    struct hlist_node *tmp;
+    int bkt;
+
+    spin_lock_bh(&proxyfs_perm_lock);
+    hash_for_each_safe(proxyfs_perm_requests, bkt, tmp, request, node) {
+        hash_del(&request->node);
+        complete(&request->done);
+    }
+    spin_unlock_bh(&proxyfs_perm_lock);
+}
+
+void proxyfs_perm_show_stats(struct seq_file *m)
+{
+    seq_printf(m, "timeout_ms=%u default=%s pending=%d\n",
+               READ_ONCE(proxyfs_perm.timeout_ms),
+               proxyfs_perm.default_response == PROXYFS_PERM_ALLOW ? "allow" : "deny",
+               atomic_read(&proxyfs_perm.pending));
+    seq_printf(m, "allowed=%ld denied=%ld timeouts=%ld unknown=%ld\n",
+               atomic_long_read(&proxyfs_perm.allowed),
+               atomic_long_read(&proxyfs_perm.denied),
+               atomic_long_read(&proxyfs_perm.timeouts),
+               atomic_long_read(&proxyfs_perm.unknown));
+    spin_lock_bh(&proxyfs_perm_cache_lock);
+    seq_printf(m, "cache: entries=%u max=%u hits=%ld misses=%ld\n",
+               proxyfs_perm_cache.entries,
+               proxyfs_perm_cache.max_entries,
+               atomic_long_read(&proxyfs_perm_cache.hits),
+               atomic_long_read(&proxyfs_perm_cache.misses));
+    spin_unlock_bh(&proxyfs_perm_cache_lock);
+}
+
+void proxyfs_perm_init(const struct proxyfs_perm_config *config)
+{
+    proxyfs_perm.timeout_ms = config->timeout_ms;
+    proxyfs_perm.default_response = config->default_deny ? PROXYFS_PERM_DENY : PROXYFS_PERM_ALLOW;
+    atomic64_set(&proxyfs_perm.seq, 0);
+    atomic_set(&proxyfs_perm.pending, 0);
+    atomic_long_set(&proxyfs_perm.allowed, 0);
+    atomic_long_set(&proxyfs_perm.denied, 0);
+    atomic_long_set(&proxyfs_perm.timeouts, 0);
+    atomic_long_set(&proxyfs_perm.unknown, 0);
+    proxyfs_perm_cache.max_entries = config->cache_entries;
+    atomic_long_set(&proxyfs_perm_cache.hits, 0);
+    atomic_long_set(&proxyfs_perm_cache.misses, 0);
+    pr_info("%s: permission requests time out in %u ms (default verdict: %s)\n",
+            MODULE_NAME,
+            config->timeout_ms,
+            config->default_deny ? "deny" : "allow");
+}
+
+void proxyfs_perm_release(void)
+{
+    //
+    // Note: the module is stopped, thus no new requests are issued
+    proxyfs_perm_cancel();
+    proxyfs_perm_cache_flush();
+}
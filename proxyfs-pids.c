@@ -0,0 +1,225 @@
+// File		:proxyfs-pids.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 23:04:31 2026
+#include <linux/hashtable.h>
+#include <linux/rculist.h>
+#include <linux/slab.h>
+#include <linux/mutex.h>
+#include <linux/cgroup.h>
+#include <linux/jump_label.h>
+#include <linux/seq_file.h>
+#include "proxyfs.h"
+
+enum proxyfs_pids_kind {
+    PROXYFS_PIDS_PID,
+    PROXYFS_PIDS_TGID,
+    PROXYFS_PIDS_CGROUP,
+    PROXYFS_PIDS_KIND_COUNT
+};
+
+static const char *const proxyfs_pids_kind_names[PROXYFS_PIDS_KIND_COUNT] = {
+    [PROXYFS_PIDS_PID] = "pid",
+    [PROXYFS_PIDS_TGID] = "tgid",
+    [PROXYFS_PIDS_CGROUP] = "cgroup",
+};
+
+struct proxyfs_pids_entry {
+    struct hlist_node node;
+    struct rcu_head rcu;
+    enum proxyfs_pids_kind kind;
+    u64 id;
+    bool include;
+};
+
+//
+// Set of the tasks (threads, processes or cgroups) excluded from the
+// monitoring or the only ones monitored (if there is any included)
+//
+// Note: only the event emission (and thus the permission requests) is
+//       suppressed for the tasks not monitored. Their calls are still
+//       timed and counted by the mount statistics, traced, recorded by
+//       the flight recorder, checked by the slow detector and accounted
+//       to the heavy hitters. The permission cache is invalidated on
+//       their changes as well, since the cached verdicts of the other
+//       tasks would go stale otherwise
+static DEFINE_HASHTABLE(proxyfs_pids_table, PROXYFS_PIDS_HASH_BITS);
+static DEFINE_MUTEX(proxyfs_pids_lock);
+static unsigned int proxyfs_pids_count[2];
+
+//
+// Enabled while the set is not empty, thus the check costs nothing
+// otherwise
+DEFINE_STATIC_KEY_FALSE(proxyfs_pids_active);
+
+static u64 proxyfs_pids_key(enum proxyfs_pids_kind kind, u64 id)
+{
+    return id ^ ((u64)kind << 62);
+}
+
+// Note: must be called under RCU read lock (or the lock of the set)
+static struct proxyfs_pids_entry *proxyfs_pids_find(enum proxyfs_pids_kind kind,
+                                                    u64 id)
+{
+    struct proxyfs_pids_entry *entry;
+
+    hash_for_each_possible_rcu(proxyfs_pids_table, entry, node, proxyfs_pids_key(kind, id),
+                               lockdep_is_held(&proxyfs_pids_lock)) {
+        if (entry->kind == kind && entry->id == id) {
+            return entry;
+        }
+    }
+    return NULL;
+}
+
+//
+// Check if the current task is monitored: it is not excluded and it is
+// included if there are tasks included
+bool proxyfs_pids_check(void)
+{
+    struct proxyfs_pids_entry *entry;
+    u64 ids[PROXYFS_PIDS_KIND_COUNT];
+    bool included = false;
+    bool res = true;
+    int kind;
+
+    rcu_read_lock();
+    ids[PROXYFS_PIDS_PID] = task_pid_nr(current);
+    ids[PROXYFS_PIDS_TGID] = task_tgid_nr(current);
+#ifdef CONFIG_CGROUPS
+    ids[PROXYFS_PIDS_CGROUP] = cgroup_id(task_dfl_cgroup(current));
+#else
+    ids[PROXYFS_PIDS_CGROUP] = 0;
+#endif
+    for (kind = 0; kind < PROXYFS_PIDS_KIND_COUNT; kind++) {
+        if ((entry = proxyfs_pids_find(kind, ids[kind])) == NULL) {
+            continue;
+        }
+        if (!entry->include) {
+            res = false;
+            break;
+        }
+        included = true;
+    }
+    if (res && !included && READ_ONCE(proxyfs_pids_count[true]) != 0) {
+        res = false;
+    }
+    rcu_read_unlock();
+    return res;
+}
+
+static void proxyfs_pids_remove(struct proxyfs_pids_entry *entry)
+{
+    hash_del_rcu(&entry->node);
+    WRITE_ONCE(proxyfs_pids_count[entry->include], proxyfs_pids_count[entry->include] - 1);
+    kfree_rcu(entry, rcu);
+}
+
+// Note: must be called with the lock of the set held
+static void proxyfs_pids_update_key(void)
+{
+    if (proxyfs_pids_count[false] + proxyfs_pids_count[true] != 0) {
+        static_branch_enable(&proxyfs_pids_active);
+    } else {
+        static_branch_disable(&proxyfs_pids_active);
+    }
+}
+
+static void proxyfs_pids_clear(void)
+{
+    struct proxyfs_pids_entry *entry;
+    struct hlist_node *tmp;
+    int bkt;
+
+    hash_for_each_safe(proxyfs_pids_table, bkt, tmp, entry, node) {
+        proxyfs_pids_remove(entry);
+    }
+}
+
+//
+// Update the set by a command:
+//   include|exclude|remove pid|tgid|cgroup <id>
+//   clear
+int proxyfs_pids_configure(const char *line)
+{
+    struct proxyfs_pids_entry *entry;
+    char action[16];
+    char kind_name[16];
+    u64 id;
+    int kind;
+    int res = 0;
+
+    if (sscanf(line, "%15s", action) == 1 && strcmp(action, "clear") == 0) {
+        mutex_lock(&proxyfs_pids_lock);
+        proxyfs_pids_clear();
+        proxyfs_pids_update_key();
+        mutex_unlock(&proxyfs_pids_lock);
+        return 0;
+    }
+    if (sscanf(line, "%15s %15s %llu", action, kind_name, &id) != 3) {
+        return -EINVAL;
+    }
+    for (kind = 0; kind < PROXYFS_PIDS_KIND_COUNT; kind++) {
+        if (strcmp(kind_name, proxyfs_pids_kind_names[kind]) == 0) {
+            break;
+        }
+    }
+    if (kind == PROXYFS_PIDS_KIND_COUNT ||
+        (strcmp(action, "include") != 0 &&
+         strcmp(action, "exclude") != 0 &&
+         strcmp(action, "remove") != 0)) {
+        return -EINVAL;
+    }
+
+    mutex_lock(&proxyfs_pids_lock);
+    do {
+        if ((entry = proxyfs_pids_find(kind, id)) != NULL) {
+            proxyfs_pids_remove(entry);
+        }
+        if (*action == 'r') {
+            break;
+        }
+        if (proxyfs_pids_count[false] + proxyfs_pids_count[true] >= PROXYFS_PIDS_MAX) {
+            res = -ENOSPC;
+            break;
+        }
+        if ((entry = kzalloc(sizeof(*entry), GFP_KERNEL)) == NULL) {
+            res = -ENOMEM;
+            break;
+        }
+        entry->kind = kind;
+        entry->id = id;
+        entry->include = (*action == 'i');
+        WRITE_ONCE(proxyfs_pids_count[entry->include], proxyfs_pids_count[entry->include] + 1);
+        hash_add_rcu(proxyfs_pids_table, &entry->node, proxyfs_pids_key(kind, id));
+    } while (false);
+    proxyfs_pids_update_key();
+    mutex_unlock(&proxyfs_pids_lock);
+    return res;
+}
+
+void proxyfs_pids_show(struct seq_file *m)
+{
+    struct proxyfs_pids_entry *entry;
+    int bkt;
+
+    mutex_lock(&proxyfs_pids_lock);
+    seq_printf(m, "included=%u excluded=%u\n",
+               proxyfs_pids_count[true],
+               proxyfs_pids_count[false]);
+    hash_for_each(proxyfs_pids_table, bkt, entry, node) {
+        seq_printf(m, "%s %s %llu\n",
+                   entry->include ? "include" : "exclude",
+                   proxyfs_pids_kind_names[entry->kind],
+                   entry->id);
+    }
+    mutex_unlock(&proxyfs_pids_lock);
+}
+
+void proxyfs_pids_release(void)
+{
+    mutex_lock(&proxyfs_pids_lock);
+    proxyfs_pids_clear();
+    proxyfs_pids_update_key();
+    mutex_unlock(&proxyfs_pids_lock);
+    rcu_barrier();
+}
@@ -2,8 +2,16 @@
 // Author	:Victor Kovalevich
 // Created	:Fri Jul 11 13:09:17 2025
 #include <linux/proc_fs.h>
+#include <linux/uaccess.h>
+#include <linux/string.h>
+#include <linux/slab.h>
 #include "proxyfs.h"
 
+//
+// Directory of the per-mount entries (named after the device numbers of
+// the mounts)
+static struct proc_dir_entry *proxyfs_procfs_mounts;
+
 static int proxyfs_procfs_unitid_show(struct seq_file* m, void* v)
 {
     seq_printf(m, "%d\n", PROXYFS_NETLINK_USER);
@@ -12,16 +20,266 @@ static int proxyfs_procfs_unitid_show(struct seq_file* m, void* v)
 
 static int proxyfs_procfs_filters_show(struct seq_file* m, void* v)
 {
-    seq_printf(m, "%s\n", "filters - NOT IMPLEMENTED YET");
+    proxyfs_filter_show(m);
+    seq_printf(m, "\n");
+    proxyfs_ratelimit_show_limits(m);
     return 0;
 }
 
+//
+// Command "<level> <rate> [<burst> [<sample>]]" sets the rate limit of
+// the level (see `proxyfs_ratelimit_configure()`), anything else is a
+// filter set replacing the active one (see `proxyfs_filter_compile()`)
+static ssize_t proxyfs_procfs_filters_write(struct file* file,
+                                            const char __user* buffer,
+                                            size_t count,
+                                            loff_t* pos)
+{
+    char *cmd;
+    int res;
+
+    if (count == 0 || count > PROXYFS_PROCFS_CMD_LEN) {
+        return -EINVAL;
+    }
+    if ((cmd = kvmalloc(count + 1, GFP_KERNEL)) == NULL) {
+        return -ENOMEM;
+    }
+    if (copy_from_user(cmd, buffer, count) != 0) {
+        kvfree(cmd);
+        return -EFAULT;
+    }
+    cmd[count] = '\0';
+    if ((res = proxyfs_ratelimit_configure(cmd)) == -ENOENT) {
+        res = proxyfs_filter_compile(cmd);
+    }
+    kvfree(cmd);
+    return res != 0 ? res : count;
+}
+
 static int proxyfs_procfs_pids_show(struct seq_file* m, void* v)
 {
-    seq_printf(m, "%s\n", "pids - NOT IMPLEMENTED YET");
+    proxyfs_pids_show(m);
+    seq_printf(m, "\n");
+    proxyfs_ratelimit_show_buckets(m);
+    return 0;
+}
+
+//
+// Every line is a command updating the PID/TGID/cgroup set (see
+// `proxyfs_pids_configure()`), the first failing one stops the write
+static ssize_t proxyfs_procfs_pids_write(struct file* file,
+                                         const char __user* buffer,
+                                         size_t count,
+                                         loff_t* pos)
+{
+    char *cmd;
+    char *text;
+    char *line;
+    int res = 0;
+
+    if (count == 0 || count > PROXYFS_PROCFS_CMD_LEN) {
+        return -EINVAL;
+    }
+    if ((cmd = kvmalloc(count + 1, GFP_KERNEL)) == NULL) {
+        return -ENOMEM;
+    }
+    if (copy_from_user(cmd, buffer, count) != 0) {
+        kvfree(cmd);
+        return -EFAULT;
+    }
+    cmd[count] = '\0';
+    text = cmd;
+    while (res == 0 && (line = strsep(&text, "\n")) != NULL) {
+        line = strim(line);
+        if (*line == '\0' || *line == '#') {
+            continue;
+        }
+        if ((res = proxyfs_pids_configure(line)) != 0) {
+            pr_err("%s: invalid pids command \"%s\" (%d)\n",
+                   MODULE_NAME,
+                   line,
+                   res);
+        }
+    }
+    kvfree(cmd);
+    return res != 0 ? res : count;
+}
+
+static int proxyfs_procfs_pool_show(struct seq_file* m, void* v)
+{
+    struct proxyfs_buffer_pool *buffer_pool = proxyfs_context_get_buffer_pool();
+    unsigned int i;
+    int c;
+
+    seq_printf(m, "%-8s %-10s %-10s %-10s %-12s %-12s\n",
+               "size", "capacity", "in_use", "peak", "fallbacks", "failures");
+    for (c = 0; c < PROXYFS_BUFFER_CLASS_COUNT; c++) {
+        struct proxyfs_buffer_class *buffer_class = &buffer_pool->classes[c];
+        seq_printf(m, "%-8u %-10u %-10d %-10d %-12ld %-12ld\n",
+                   buffer_class->size,
+                   proxyfs_buffer_class_capacity(buffer_class),
+                   proxyfs_buffer_class_in_use(buffer_class),
+                   READ_ONCE(buffer_class->peak),
+                   atomic_long_read(&buffer_class->fallbacks),
+                   atomic_long_read(&buffer_class->failures));
+    }
+
+    mutex_lock(&buffer_pool->resize_lock);
+    seq_printf(m, "\nresize history (low %u%%, high %u%%):\n",
+               buffer_pool->low_watermark,
+               buffer_pool->high_watermark);
+    i = buffer_pool->history_count > PROXYFS_BUFFER_POOL_HISTORY ?
+        buffer_pool->history_count - PROXYFS_BUFFER_POOL_HISTORY : 0;
+    for (; i < buffer_pool->history_count; i++) {
+        struct proxyfs_buffer_resize_record *record =
+            &buffer_pool->history[i % PROXYFS_BUFFER_POOL_HISTORY];
+        seq_printf(m, "%lld size=%u capacity=%u->%u in_use=%d\n",
+                   (long long)record->time,
+                   record->class_size,
+                   record->from,
+                   record->to,
+                   record->in_use);
+    }
+    mutex_unlock(&buffer_pool->resize_lock);
+    return 0;
+}
+
+static int proxyfs_procfs_batch_show(struct seq_file* m, void* v)
+{
+    proxyfs_socket_show_stats(m);
+    return 0;
+}
+
+static int proxyfs_procfs_queue_show(struct seq_file* m, void* v)
+{
+    proxyfs_queue_show_stats(m);
+    return 0;
+}
+
+static int proxyfs_procfs_coalesce_show(struct seq_file* m, void* v)
+{
+    proxyfs_coalesce_show_stats(m);
+    return 0;
+}
+
+static int proxyfs_procfs_perm_show(struct seq_file* m, void* v)
+{
+    proxyfs_perm_show_stats(m);
     return 0;
 }
 
+static int proxyfs_procfs_flight_show(struct seq_file* m, void* v)
+{
+    proxyfs_flight_show(m);
+    return 0;
+}
+
+//
+// Command "snapshot" takes the snapshot of the flight recorders, "clear"
+// drops the one held
+static ssize_t proxyfs_procfs_flight_write(struct file* file,
+                                           const char __user* buffer,
+                                           size_t count,
+                                           loff_t* pos)
+{
+    char cmd[16];
+    char *text;
+    int res = 0;
+
+    if (count == 0 || count >= sizeof(cmd)) {
+        return -EINVAL;
+    }
+    if (copy_from_user(cmd, buffer, count) != 0) {
+        return -EFAULT;
+    }
+    cmd[count] = '\0';
+    text = strim(cmd);
+    if (strcmp(text, "snapshot") == 0) {
+        res = proxyfs_flight_snapshot_take();
+    } else if (strcmp(text, "clear") == 0) {
+        proxyfs_flight_snapshot_clear();
+    } else {
+        res = -EINVAL;
+    }
+    return res != 0 ? res : count;
+}
+
+static int proxyfs_procfs_flight_snapshot_show(struct seq_file* m, void* v)
+{
+    proxyfs_flight_show_snapshot(m);
+    return 0;
+}
+
+static int proxyfs_procfs_slow_show(struct seq_file* m, void* v)
+{
+    proxyfs_slow_show(m);
+    return 0;
+}
+
+//
+// Command "<op> <ms>" sets the slow call threshold of the operation, see
+// `proxyfs_slow_configure()`
+static ssize_t proxyfs_procfs_slow_write(struct file* file,
+                                         const char __user* buffer,
+                                         size_t count,
+                                         loff_t* pos)
+{
+    char cmd[64];
+    int res;
+
+    if (count == 0 || count >= sizeof(cmd)) {
+        return -EINVAL;
+    }
+    if (copy_from_user(cmd, buffer, count) != 0) {
+        return -EFAULT;
+    }
+    cmd[count] = '\0';
+    if ((res = proxyfs_slow_configure(strim(cmd))) != 0) {
+        return res;
+    }
+    return count;
+}
+
+static int proxyfs_procfs_top_show(struct seq_file* m, void* v)
+{
+    proxyfs_top_show(m);
+    return 0;
+}
+
+static int proxyfs_procfs_mount_show(struct seq_file* m, void* v)
+{
+    struct super_block *sb = m->private;
+
+    proxyfs_backpressure_show_stats(m, proxyfs_sb_backpressure(sb));
+    seq_printf(m, "\n");
+    proxyfs_stats_show(m, proxyfs_sb_stats(sb));
+    return 0;
+}
+
+//
+// Command "reset" zeroes the operation statistics of the mount
+static ssize_t proxyfs_procfs_mount_write(struct file* file,
+                                          const char __user* buffer,
+                                          size_t count,
+                                          loff_t* pos)
+{
+    struct super_block *sb = ((struct seq_file *)file->private_data)->private;
+    char cmd[16];
+
+    if (count == 0 || count >= sizeof(cmd)) {
+        return -EINVAL;
+    }
+    if (copy_from_user(cmd, buffer, count) != 0) {
+        return -EFAULT;
+    }
+    cmd[count] = '\0';
+    if (strcmp(strim(cmd), "reset") != 0) {
+        return -EINVAL;
+    }
+    proxyfs_stats_reset(proxyfs_sb_stats(sb));
+    return count;
+}
+
 static int proxyfs_procfs_unitid_open(struct inode* inode, struct file* file)
 {
     return single_open(file, proxyfs_procfs_unitid_show, NULL);
@@ -37,6 +295,56 @@ static int proxyfs_procfs_pids_open(struct inode* inode, struct file* file)
     return single_open(file, proxyfs_procfs_pids_show, NULL);
 }
 
+static int proxyfs_procfs_pool_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_pool_show, NULL);
+}
+
+static int proxyfs_procfs_batch_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_batch_show, NULL);
+}
+
+static int proxyfs_procfs_queue_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_queue_show, NULL);
+}
+
+static int proxyfs_procfs_coalesce_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_coalesce_show, NULL);
+}
+
+static int proxyfs_procfs_perm_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_perm_show, NULL);
+}
+
+static int proxyfs_procfs_flight_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_flight_show, NULL);
+}
+
+static int proxyfs_procfs_flight_snapshot_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_flight_snapshot_show, NULL);
+}
+
+static int proxyfs_procfs_slow_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_slow_show, NULL);
+}
+
+static int proxyfs_procfs_top_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_top_show, NULL);
+}
+
+static int proxyfs_procfs_mount_open(struct inode* inode, struct file* file)
+{
+    return single_open(file, proxyfs_procfs_mount_show, pde_data(inode));
+}
+
 static const struct proc_ops proxyfs_procfs_unitid_ops ={
     .proc_open = proxyfs_procfs_unitid_open,
     .proc_read = seq_read,
@@ -47,6 +355,7 @@ static const struct proc_ops proxyfs_procfs_unitid_ops ={
 static const struct proc_ops proxyfs_procfs_filters_ops ={
     .proc_open = proxyfs_procfs_filters_open,
     .proc_read = seq_read,
+    .proc_write = proxyfs_procfs_filters_write,
     .proc_lseek = seq_lseek,
     .proc_release = single_release,
 };
@@ -54,6 +363,80 @@ static const struct proc_ops proxyfs_procfs_filters_ops ={
 static const struct proc_ops proxyfs_procfs_pids_ops = {
     .proc_open = proxyfs_procfs_pids_open,
     .proc_read = seq_read,
+    .proc_write = proxyfs_procfs_pids_write,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_pool_ops = {
+    .proc_open = proxyfs_procfs_pool_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_batch_ops = {
+    .proc_open = proxyfs_procfs_batch_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_queue_ops = {
+    .proc_open = proxyfs_procfs_queue_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_coalesce_ops = {
+    .proc_open = proxyfs_procfs_coalesce_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_perm_ops = {
+    .proc_open = proxyfs_procfs_perm_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_flight_ops = {
+    .proc_open = proxyfs_procfs_flight_open,
+    .proc_read = seq_read,
+    .proc_write = proxyfs_procfs_flight_write,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_flight_snapshot_ops = {
+    .proc_open = proxyfs_procfs_flight_snapshot_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_slow_ops = {
+    .proc_open = proxyfs_procfs_slow_open,
+    .proc_read = seq_read,
+    .proc_write = proxyfs_procfs_slow_write,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_top_ops = {
+    .proc_open = proxyfs_procfs_top_open,
+    .proc_read = seq_read,
+    .proc_lseek = seq_lseek,
+    .proc_release = single_release,
+};
+
+static const struct proc_ops proxyfs_procfs_mount_ops = {
+    .proc_open = proxyfs_procfs_mount_open,
+    .proc_read = seq_read,
+    .proc_write = proxyfs_procfs_mount_write,
     .proc_lseek = seq_lseek,
     .proc_release = single_release,
 };
@@ -78,16 +461,66 @@ struct proc_dir_entry* proxyfs_procfs_setup(void)
             MODULE_NAME,
             PROXYFS_PROCFS_DIR,
             PROXYFS_PROCFS_UNIT_ID);
-    proc_create(PROXYFS_PROCFS_FILTERS, 0444, lsm_proc_dir, &proxyfs_procfs_filters_ops);
+    proc_create(PROXYFS_PROCFS_FILTERS, 0644, lsm_proc_dir, &proxyfs_procfs_filters_ops);
     pr_info("%s: created /proc/%s/%s\n",
             MODULE_NAME,
             PROXYFS_PROCFS_DIR,
             PROXYFS_PROCFS_FILTERS);
-    proc_create(PROXYFS_PROCFS_PIDS, 0444, lsm_proc_dir, &proxyfs_procfs_pids_ops);
+    proc_create(PROXYFS_PROCFS_PIDS, 0644, lsm_proc_dir, &proxyfs_procfs_pids_ops);
     pr_info("%s: created /proc/%s/%s\n",
             MODULE_NAME,
             PROXYFS_PROCFS_DIR,
             PROXYFS_PROCFS_PIDS);
+    proc_create(PROXYFS_PROCFS_POOL, 0444, lsm_proc_dir, &proxyfs_procfs_pool_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_POOL);
+    proc_create(PROXYFS_PROCFS_BATCH, 0444, lsm_proc_dir, &proxyfs_procfs_batch_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_BATCH);
+    proc_create(PROXYFS_PROCFS_QUEUE, 0444, lsm_proc_dir, &proxyfs_procfs_queue_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_QUEUE);
+    proc_create(PROXYFS_PROCFS_COALESCE, 0444, lsm_proc_dir, &proxyfs_procfs_coalesce_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_COALESCE);
+    proc_create(PROXYFS_PROCFS_PERM, 0444, lsm_proc_dir, &proxyfs_procfs_perm_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_PERM);
+    proc_create(PROXYFS_PROCFS_FLIGHT, 0644, lsm_proc_dir, &proxyfs_procfs_flight_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_FLIGHT);
+    proc_create(PROXYFS_PROCFS_FLIGHT_SNAPSHOT, 0444, lsm_proc_dir, &proxyfs_procfs_flight_snapshot_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_FLIGHT_SNAPSHOT);
+    proc_create(PROXYFS_PROCFS_SLOW, 0644, lsm_proc_dir, &proxyfs_procfs_slow_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_SLOW);
+    proc_create(PROXYFS_PROCFS_TOP, 0444, lsm_proc_dir, &proxyfs_procfs_top_ops);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_TOP);
+    proxyfs_procfs_mounts = proc_mkdir(PROXYFS_PROCFS_MOUNTS, lsm_proc_dir);
+    pr_info("%s: created /proc/%s/%s\n",
+            MODULE_NAME,
+            PROXYFS_PROCFS_DIR,
+            PROXYFS_PROCFS_MOUNTS);
 
     return lsm_proc_dir;
 }
@@ -95,4 +528,43 @@ struct proc_dir_entry* proxyfs_procfs_setup(void)
 void proxyfs_procfs_release(void)
 {
     remove_proc_subtree(PROXYFS_PROCFS_DIR, NULL);
+    proxyfs_procfs_mounts = NULL;
+}
+
+//
+// Create /proc/proxyfs/mounts/<major>:<minor> entry of the mount
+//
+// Note: the mount works without the entry if it cannot be created
+void proxyfs_procfs_mount_create(struct super_block *sb)
+{
+    struct proxyfs_sb_info *sb_info = sb->s_fs_info;
+    char name[32];
+
+    if (proxyfs_procfs_mounts == NULL) {
+        return;
+    }
+    snprintf(name, sizeof(name), "%u:%u", MAJOR(sb->s_dev), MINOR(sb->s_dev));
+    if ((sb_info->proc_entry = proc_create_data(name,
+                                                0644,
+                                                proxyfs_procfs_mounts,
+                                                &proxyfs_procfs_mount_ops,
+                                                sb)) == NULL) {
+        pr_err("%s: unable to create /proc/%s/%s/%s\n",
+               MODULE_NAME,
+               PROXYFS_PROCFS_DIR,
+               PROXYFS_PROCFS_MOUNTS,
+               name);
+    }
+}
+
+//
+// Remove the entry of the mount, readers of the entry are waited for
+void proxyfs_procfs_mount_remove(struct super_block *sb)
+{
+    struct proxyfs_sb_info *sb_info = sb->s_fs_info;
+
+    if (sb_info != NULL) {
+        proc_remove(sb_info->proc_entry);
+        sb_info->proc_entry = NULL;
+    }
 }
@@ -0,0 +1,411 @@
+// File		:proxyfs-queue.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 15:02:37 2026
+#include <linux/kthread.h>
+#include <linux/percpu.h>
+#include <linux/cpu.h>
+#include <linux/topology.h>
+#include <linux/slab.h>
+#include <linux/log2.h>
+#include <linux/seq_file.h>
+#include <linux/wait.h>
+#include <linux/jiffies.h>
+#include "proxyfs.h"
+
+struct proxyfs_queue_slot {
+    void *buffer;
+    size_t len;
+    unsigned int group;
+};
+
+//
+// Queue of encoded events of a CPU: producers are the event handlers
+// running on the CPU (with preemption disabled, thus there is a single
+// producer at a time), the consumer is the worker thread of the CPU
+//
+// Note: head and tail are free running counters, a slot of an index is
+//       `slots[index & mask]`
+struct proxyfs_queue {
+    //
+    // Updated by the producers only
+    u64 head ____cacheline_aligned_in_smp;
+    unsigned long enqueued;
+    unsigned long dropped;
+    //
+    // Updated by the worker (and by the producers stealing the oldest
+    // event, see `proxyfs_queue_steal()`)
+    u64 tail ____cacheline_aligned_in_smp;
+    unsigned long sent;
+    unsigned long wakeups;
+
+    unsigned int mask;
+    struct proxyfs_queue_slot *slots;
+    struct task_struct *worker;
+};
+
+static DEFINE_PER_CPU(struct proxyfs_queue *, proxyfs_queues);
+
+//
+// Event handlers waiting for room (see `proxyfs_queue_wait()`), woken up
+// every time a worker has drained some events
+static DECLARE_WAIT_QUEUE_HEAD(proxyfs_queue_waiters);
+static atomic_long_t proxyfs_queue_drains = ATOMIC_LONG_INIT(0);
+
+//
+// Take the oldest event out of the full queue (`drop_oldest` policy)
+// and release it, false is returned if the worker has just taken it
+// Note: must be called with preemption disabled
+static bool proxyfs_queue_steal(struct proxyfs_queue *queue)
+{
+    struct proxyfs_queue_slot slot;
+    u64 tail = smp_load_acquire(&queue->tail);
+
+    if (tail == queue->head) {
+        return false;
+    }
+    slot = queue->slots[tail & queue->mask];
+    //
+    // Note: the worker takes events by the same CAS, thus just one of
+    //       them owns the copy of the slot
+    if (!try_cmpxchg64(&queue->tail, &tail, tail + 1)) {
+        return false;
+    }
+    proxyfs_buffer_pool_free(proxyfs_context_get_buffer_pool(), slot.buffer);
+    queue->dropped++;
+    return true;
+}
+
+//
+// Send up to `budget` queued events, number of sent events is returned
+static unsigned int proxyfs_queue_drain(struct proxyfs_queue *queue,
+                                        unsigned int budget)
+{
+    struct proxyfs_buffer_pool *buffer_pool = proxyfs_context_get_buffer_pool();
+    struct proxyfs_queue_slot slot;
+    u64 head = smp_load_acquire(&queue->head);
+    u64 tail = READ_ONCE(queue->tail);
+    unsigned int count = 0;
+
+    while (tail != head && count < budget) {
+        slot = queue->slots[tail & queue->mask];
+        //
+        // Note: the CAS orders the copy of the slot before the slot is
+        //       released to the producer; it fails if the producer has
+        //       stolen the event, `tail` is reloaded then
+        if (!try_cmpxchg64(&queue->tail, &tail, tail + 1)) {
+            continue;
+        }
+        tail++;
+        proxyfs_context_send_msg(slot.buffer, slot.len, slot.group);
+        proxyfs_buffer_pool_free(buffer_pool, slot.buffer);
+        count++;
+    }
+    queue->sent += count;
+    if (count != 0) {
+        atomic_long_inc(&proxyfs_queue_drains);
+        if (wq_has_sleeper(&proxyfs_queue_waiters)) {
+            wake_up_all(&proxyfs_queue_waiters);
+        }
+    }
+    return count;
+}
+
+static int proxyfs_queue_worker(void *data)
+{
+    struct proxyfs_queue *queue = data;
+
+    while (true) {
+        set_current_state(TASK_INTERRUPTIBLE);
+        if (kthread_should_stop()) {
+            __set_current_state(TASK_RUNNING);
+            break;
+        }
+        if (smp_load_acquire(&queue->head) == READ_ONCE(queue->tail)) {
+            schedule();
+            queue->wakeups++;
+            continue;
+        }
+        __set_current_state(TASK_RUNNING);
+        //
+        // Note: the pending NETLINK batch is not flushed when the queue is
+        //       drained, it is sent once it is full or its latency bound
+        //       expires (flushing every drain would send tiny batches)
+        proxyfs_queue_drain(queue, PROXYFS_QUEUE_BATCH);
+        cond_resched();
+    }
+    return 0;
+}
+
+//
+// Single attempt to queue the event to the queue of the current CPU
+static int proxyfs_queue_try_push(void *buffer,
+                                  size_t len,
+                                  unsigned int group,
+                                  struct proxyfs_backpressure *bp)
+{
+    struct proxyfs_queue *queue;
+    u64 head;
+    int res = -ENODEV;
+
+    preempt_disable();
+    queue = this_cpu_read(proxyfs_queues);
+    do {
+        if (queue == NULL || !proxyfs_context_check_is_running()) {
+            break;
+        }
+        head = queue->head;
+        if (head - smp_load_acquire(&queue->tail) > queue->mask) {
+            if (bp->policy != PROXYFS_BACKPRESSURE_DROP_OLDEST) {
+                queue->dropped++;
+                res = -ENOSPC;
+                break;
+            }
+            //
+            // Note: if the worker has taken the oldest event meanwhile
+            //       there is room anyway
+            if (proxyfs_queue_steal(queue)) {
+                proxyfs_backpressure_drop(bp, PROXYFS_DROP_QUEUE);
+            }
+        }
+        queue->slots[head & queue->mask] = (struct proxyfs_queue_slot) {
+            .buffer = buffer,
+            .len = len,
+            .group = group,
+        };
+        smp_store_release(&queue->head, head + 1);
+        queue->enqueued++;
+        //
+        // Wakeups are coalesced: the worker sleeps only when it has drained
+        // the queue, thus it is enough to wake it up on the first event
+        // Note: pairs with the barrier of `set_current_state()` of the worker
+        smp_mb();
+        if (READ_ONCE(queue->tail) == head) {
+            wake_up_process(queue->worker);
+        }
+        res = 0;
+    } while (false);
+    preempt_enable();
+    return res;
+}
+
+//
+// Queue the event to be sent by the worker of the current CPU, the queue
+// takes the buffer over if 0 is returned; the full queue is handled
+// according to the backpressure policy: -ENOSPC is returned if the event
+// is dropped, -ETIMEDOUT if there is still no room after the timeout of
+// `block` policy; -ENODEV is returned if there is no queue (the event
+// should be sent synchronously)
+int proxyfs_queue_push(void *buffer,
+                       size_t len,
+                       unsigned int group,
+                       struct proxyfs_backpressure *bp)
+{
+    long timeout = usecs_to_jiffies(bp->timeout_us);
+    unsigned long generation;
+    int res;
+
+    while (true) {
+        generation = proxyfs_queue_generation();
+        res = proxyfs_queue_try_push(buffer, len, group, bp);
+        if (res != -ENOSPC || bp->policy != PROXYFS_BACKPRESSURE_BLOCK) {
+            break;
+        }
+        if (timeout <= 0) {
+            res = -ETIMEDOUT;
+            break;
+        }
+        timeout = proxyfs_queue_wait(generation, timeout);
+    }
+    return res;
+}
+
+//
+// Release the oldest queued event of the current CPU to make room in
+// the buffer pool (`drop_oldest` policy)
+bool proxyfs_queue_drop_oldest(void)
+{
+    struct proxyfs_queue *queue;
+    bool res = false;
+
+    preempt_disable();
+    if ((queue = this_cpu_read(proxyfs_queues)) != NULL) {
+        res = proxyfs_queue_steal(queue);
+    }
+    preempt_enable();
+    return res;
+}
+
+//
+// Check if the events are queued (every possible CPU has a queue then)
+// rather than sent synchronously
+bool proxyfs_queue_is_enabled(void)
+{
+    return raw_cpu_read(proxyfs_queues) != NULL;
+}
+
+//
+// Number of drains done by the workers so far, see `proxyfs_queue_wait()`
+unsigned long proxyfs_queue_generation(void)
+{
+    return atomic_long_read(&proxyfs_queue_drains);
+}
+
+//
+// Wait until a worker drains some events after `generation` was taken,
+// the remaining timeout (jiffies) is returned, 0 if it is expired
+long proxyfs_queue_wait(unsigned long generation, long timeout)
+{
+    return wait_event_timeout(proxyfs_queue_waiters,
+                              proxyfs_queue_generation() != generation,
+                              timeout);
+}
+
+//
+// Usage (percents) of the queue of the current CPU
+unsigned int proxyfs_queue_pressure(void)
+{
+    struct proxyfs_queue *queue;
+    unsigned int res = 0;
+
+    preempt_disable();
+    if ((queue = this_cpu_read(proxyfs_queues)) != NULL) {
+        res = (READ_ONCE(queue->head) - READ_ONCE(queue->tail)) * 100 / (queue->mask + 1);
+    }
+    preempt_enable();
+    return res;
+}
+
+void proxyfs_queue_show_stats(struct seq_file *m)
+{
+    struct proxyfs_queue *queue;
+    int cpu;
+
+    seq_printf(m, "%-6s %-6s %-10s %-12s %-12s %-12s %-12s\n",
+               "cpu", "node", "pending", "enqueued", "sent", "dropped", "wakeups");
+    for_each_possible_cpu(cpu) {
+        if ((queue = per_cpu(proxyfs_queues, cpu)) == NULL) {
+            continue;
+        }
+        seq_printf(m, "%-6d %-6d %-10llu %-12lu %-12lu %-12lu %-12lu\n",
+                   cpu,
+                   cpu_to_node(cpu),
+                   READ_ONCE(queue->head) - READ_ONCE(queue->tail),
+                   READ_ONCE(queue->enqueued),
+                   READ_ONCE(queue->sent),
+                   READ_ONCE(queue->dropped),
+                   READ_ONCE(queue->wakeups));
+    }
+}
+
+static void proxyfs_queue_free(struct proxyfs_queue *queue)
+{
+    kvfree(queue->slots);
+    kfree(queue);
+}
+
+//
+// Allocate the queue and start the worker on the node of the CPU
+static struct proxyfs_queue *proxyfs_queue_create(int cpu, unsigned int records)
+{
+    struct proxyfs_queue *queue;
+    int node = cpu_to_node(cpu);
+
+    if ((queue = kzalloc_node(sizeof(*queue), GFP_KERNEL, node)) == NULL) {
+        return NULL;
+    }
+    if ((queue->slots = kvmalloc_node(array_size(records, sizeof(struct proxyfs_queue_slot)),
+                                      GFP_KERNEL | __GFP_ZERO,
+                                      node)) == NULL) {
+        kfree(queue);
+        return NULL;
+    }
+    queue->mask = records - 1;
+    queue->worker = kthread_create_on_node(proxyfs_queue_worker,
+                                           queue,
+                                           node,
+                                           "%s/%d",
+                                           MODULE_NAME,
+                                           cpu);
+    if (IS_ERR(queue->worker)) {
+        proxyfs_queue_free(queue);
+        return NULL;
+    }
+    //
+    // Note: the worker of an offline CPU is left to the scheduler (it
+    //       can't be bound to a CPU it can't run on), it keeps draining
+    //       the queue once the CPU is brought online
+    if (cpu_online(cpu)) {
+        kthread_bind(queue->worker, cpu);
+    }
+    return queue;
+}
+
+int proxyfs_queue_init(const struct proxyfs_queue_config *config)
+{
+    struct proxyfs_queue *queue;
+    int cpu;
+    int res = 0;
+
+    if (config->records == 0) {
+        pr_info("%s: event queues are disabled, events are sent synchronously\n",
+                MODULE_NAME);
+        return 0;
+    }
+    if (!is_power_of_2(config->records)) {
+        pr_err("%s: invalid number of event queue records %u\n",
+               MODULE_NAME,
+               config->records);
+        return -EINVAL;
+    }
+    //
+    // Note: every possible CPU has a queue, thus the events of CPUs
+    //       brought online later are queued as well; the worker of a CPU
+    //       going offline is migrated by the scheduler and keeps draining
+    //       its queue
+    cpus_read_lock();
+    for_each_possible_cpu(cpu) {
+        if ((queue = proxyfs_queue_create(cpu, config->records)) == NULL) {
+            pr_err("%s: unable to create event queue of CPU %d\n",
+                   MODULE_NAME,
+                   cpu);
+            res = -ENOMEM;
+            break;
+        }
+        per_cpu(proxyfs_queues, cpu) = queue;
+        wake_up_process(queue->worker);
+    }
+    cpus_read_unlock();
+
+    if (res != 0) {
+        proxyfs_queue_release();
+        return res;
+    }
+    pr_info("%s: event queues with %u records are ready for use\n",
+            MODULE_NAME,
+            config->records);
+    return 0;
+}
+
+//
+// Stop the workers and send the events left in the queues
+// Note: must be called when the module is not in running state anymore
+void proxyfs_queue_release(void)
+{
+    struct proxyfs_queue *queue;
+    int cpu;
+
+    //
+    // Producers check the running state with preemption disabled, thus
+    // no one is going to push an event after the grace period
+    synchronize_rcu();
+    for_each_possible_cpu(cpu) {
+        if ((queue = per_cpu(proxyfs_queues, cpu)) == NULL) {
+            continue;
+        }
+        per_cpu(proxyfs_queues, cpu) = NULL;
+        kthread_stop(queue->worker);
+        proxyfs_queue_drain(queue, U32_MAX);
+        proxyfs_queue_free(queue);
+    }
+    proxyfs_socket_flush();
+}
@@ -0,0 +1,426 @@
+// File		:proxyfs-ratelimit.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 19:22:16 2026
+#include <linux/percpu.h>
+#include <linux/cpumask.h>
+#include <linux/hash.h>
+#include <linux/mutex.h>
+#include <linux/timekeeping.h>
+#include <linux/cred.h>
+#include <linux/kdev_t.h>
+#include <linux/seq_file.h>
+#include <linux/spinlock.h>
+#include "proxyfs.h"
+
+static const char *const proxyfs_ratelimit_level_names[PROXYFS_RATELIMIT_LEVEL_COUNT] = {
+    [PROXYFS_RATELIMIT_MOUNT] = "mount",
+    [PROXYFS_RATELIMIT_UID] = "uid",
+    [PROXYFS_RATELIMIT_PID] = "pid",
+    [PROXYFS_RATELIMIT_INODE] = "inode",
+};
+
+//
+// Limit of a level, the shared bucket of a key earns one token every
+// `cost_ns` and holds at most `capacity_ns` worth of them; a CPU borrows
+// up to `borrow_ns` of them at once; 0 rate disables the level
+struct proxyfs_ratelimit_limit {
+    unsigned int rate;
+    unsigned int burst;
+    unsigned int sample;
+    u64 cost_ns;
+    u64 capacity_ns;
+    u64 borrow_ns;
+};
+
+//
+// Part of the burst a CPU borrows from the shared bucket at once, but
+// not less than the floor (or the whole burst if it is smaller), thus
+// the shared bucket is locked once per that many events at most
+#define PROXYFS_RATELIMIT_BORROW_SHARE 16
+#define PROXYFS_RATELIMIT_BORROW_MIN   16
+
+//
+// Shared token bucket of a key: the budget of the key on all the CPUs,
+// it is refilled at the rate of the limit
+struct proxyfs_ratelimit_shared {
+    spinlock_t lock;
+    u64 key;
+    u32 dev;
+    bool used;
+    u64 credit_ns;
+    u64 last;
+};
+
+//
+// Token bucket of a key on a CPU: the tokens borrowed from the shared
+// bucket, kept as credit (ns); once the shared bucket is found empty it
+// is not looked at again before `retry` (it earns a token by then)
+struct proxyfs_ratelimit_bucket {
+    u64 key;
+    u32 dev;
+    bool used;
+    u64 credit_ns;
+    u64 last;
+    u64 retry;
+    u32 sample_counter;
+    unsigned long suppressed;
+};
+
+//
+// Buckets of a CPU: every level has a table the keys are mapped to
+// directly (a colliding key takes the bucket over)
+//
+// Note: a key passes events at the full rate on any CPU, the events of
+//       a key on all the CPUs exceed the limit by the tokens borrowed
+//       and not spent yet (at most `nr_cpus * borrow_ns`); on the other
+//       hand a CPU may be short of tokens while another one holds them
+struct proxyfs_ratelimit_cpu {
+    struct proxyfs_ratelimit_bucket buckets[PROXYFS_RATELIMIT_LEVEL_COUNT][PROXYFS_RATELIMIT_SLOTS];
+    unsigned long passed[PROXYFS_RATELIMIT_LEVEL_COUNT];
+    unsigned long sampled[PROXYFS_RATELIMIT_LEVEL_COUNT];
+    unsigned long suppressed[PROXYFS_RATELIMIT_LEVEL_COUNT];
+};
+
+static DEFINE_PER_CPU(struct proxyfs_ratelimit_cpu, proxyfs_ratelimit_cpus);
+
+static struct proxyfs_ratelimit_shared proxyfs_ratelimit_shared[PROXYFS_RATELIMIT_LEVEL_COUNT][PROXYFS_RATELIMIT_SLOTS] = {
+    [0 ... PROXYFS_RATELIMIT_LEVEL_COUNT - 1] = {
+        [0 ... PROXYFS_RATELIMIT_SLOTS - 1] = {
+            .lock = __SPIN_LOCK_UNLOCKED(proxyfs_ratelimit_shared.lock),
+        },
+    },
+};
+
+static struct proxyfs_ratelimit_limit proxyfs_ratelimit_limits[PROXYFS_RATELIMIT_LEVEL_COUNT];
+static DEFINE_MUTEX(proxyfs_ratelimit_lock);
+//
+// Bit mask of the enabled levels (the limiter is skipped if it is 0)
+static unsigned int proxyfs_ratelimit_levels;
+
+//
+// Borrow tokens of the key from its shared bucket (up to `borrow_ns`),
+// the credit borrowed is returned
+//
+// Note: a key taking the shared bucket over starts with no credit but the
+//       one earned since the bucket was used last, otherwise keys
+//       colliding in turn would get the full burst every time
+static u64 proxyfs_ratelimit_borrow(const struct proxyfs_ratelimit_limit *limit,
+                                    unsigned int slot,
+                                    enum proxyfs_ratelimit_level level,
+                                    u64 key,
+                                    u32 dev,
+                                    u64 now)
+{
+    struct proxyfs_ratelimit_shared *shared = &proxyfs_ratelimit_shared[level][slot];
+    u64 capacity_ns = READ_ONCE(limit->capacity_ns);
+    u64 credit_ns;
+
+    spin_lock(&shared->lock);
+    if (!shared->used) {
+        shared->used = true;
+        shared->key = key;
+        shared->dev = dev;
+        shared->credit_ns = capacity_ns;
+        shared->last = now;
+    } else if (shared->key != key || shared->dev != dev) {
+        shared->key = key;
+        shared->dev = dev;
+        shared->credit_ns = 0;
+    }
+    if (now > shared->last) {
+        shared->credit_ns = min(shared->credit_ns + (now - shared->last), capacity_ns);
+        shared->last = now;
+    }
+    credit_ns = min(shared->credit_ns, READ_ONCE(limit->borrow_ns));
+    shared->credit_ns -= credit_ns;
+    spin_unlock(&shared->lock);
+    return credit_ns;
+}
+
+//
+// Take a token of the key bucket, true is returned if the event passes
+// and the credit spent on it is stored to `taken_ns` (0 if the event
+// passes as a sample or the level is disabled)
+// Note: must be called with preemption disabled
+static bool proxyfs_ratelimit_take(struct proxyfs_ratelimit_cpu *ratelimit_cpu,
+                                   enum proxyfs_ratelimit_level level,
+                                   u64 key,
+                                   u32 dev,
+                                   u64 now,
+                                   u64 *taken_ns)
+{
+    struct proxyfs_ratelimit_limit *limit = &proxyfs_ratelimit_limits[level];
+    struct proxyfs_ratelimit_bucket *bucket;
+    u64 cost_ns = READ_ONCE(limit->cost_ns);
+    unsigned int sample = READ_ONCE(limit->sample);
+    unsigned int slot;
+
+    *taken_ns = 0;
+    if (cost_ns == 0) {
+        return true;
+    }
+    slot = hash_64(key ^ dev, PROXYFS_RATELIMIT_SLOTS_BITS);
+    bucket = &ratelimit_cpu->buckets[level][slot];
+    if (!bucket->used || bucket->key != key || bucket->dev != dev) {
+        //
+        // Note: the credit left by the key replaced is just lost
+        bucket->used = true;
+        bucket->key = key;
+        bucket->dev = dev;
+        bucket->credit_ns = 0;
+        bucket->retry = 0;
+        bucket->sample_counter = 0;
+        bucket->suppressed = 0;
+    }
+    bucket->last = now;
+    if (bucket->credit_ns < cost_ns && now >= bucket->retry) {
+        bucket->credit_ns += proxyfs_ratelimit_borrow(limit, slot, level, key, dev, now);
+        bucket->retry = bucket->credit_ns < cost_ns ? now + cost_ns : 0;
+    }
+    if (bucket->credit_ns >= cost_ns) {
+        bucket->credit_ns -= cost_ns;
+        ratelimit_cpu->passed[level]++;
+        *taken_ns = cost_ns;
+        return true;
+    }
+    //
+    // Over budget: just every `sample`-th event passes
+    if (sample != 0 && ++bucket->sample_counter % sample == 0) {
+        ratelimit_cpu->sampled[level]++;
+        return true;
+    }
+    bucket->suppressed++;
+    ratelimit_cpu->suppressed[level]++;
+    return false;
+}
+
+//
+// Give the token taken by `proxyfs_ratelimit_take()` back to the key
+// bucket
+// Note: must be called with preemption disabled, thus the bucket still
+//       belongs to the key
+static void proxyfs_ratelimit_refund(struct proxyfs_ratelimit_cpu *ratelimit_cpu,
+                                     enum proxyfs_ratelimit_level level,
+                                     u64 key,
+                                     u32 dev,
+                                     u64 taken_ns)
+{
+    struct proxyfs_ratelimit_bucket *bucket;
+
+    if (taken_ns == 0) {
+        return;
+    }
+    bucket = &ratelimit_cpu->buckets[level][hash_64(key ^ dev, PROXYFS_RATELIMIT_SLOTS_BITS)];
+    bucket->credit_ns += taken_ns;
+}
+
+//
+// Check if the event fits the budgets of its mount, UID, PID and inode,
+// the event has to pass every enabled level
+//
+// Note: the levels passed already get their tokens back if a later one
+//       rejects the event, a suppressed event costs nothing then; the
+//       `passed` counter of a level still counts such an event
+bool proxyfs_ratelimit_admit(const struct proxyfs_event_args *args)
+{
+    struct proxyfs_ratelimit_cpu *ratelimit_cpu;
+    u64 keys[PROXYFS_RATELIMIT_LEVEL_COUNT];
+    u32 devs[PROXYFS_RATELIMIT_LEVEL_COUNT] = { 0 };
+    u64 taken_ns[PROXYFS_RATELIMIT_LEVEL_COUNT];
+    u32 dev;
+    u64 now;
+    int level;
+
+    if (READ_ONCE(proxyfs_ratelimit_levels) == 0) {
+        return true;
+    }
+    dev = args->inode ? new_encode_dev(args->inode->i_sb->s_dev) : 0;
+    keys[PROXYFS_RATELIMIT_MOUNT] = dev;
+    keys[PROXYFS_RATELIMIT_UID] = args->pid ? args->uid : from_kuid(&init_user_ns, current_fsuid());
+    keys[PROXYFS_RATELIMIT_PID] = args->pid ? args->tgid : task_tgid_nr(current);
+    keys[PROXYFS_RATELIMIT_INODE] = args->inode ? args->inode->i_ino : 0;
+    devs[PROXYFS_RATELIMIT_INODE] = dev;
+    now = ktime_get_ns();
+    ratelimit_cpu = get_cpu_ptr(&proxyfs_ratelimit_cpus);
+    for (level = 0; level < PROXYFS_RATELIMIT_LEVEL_COUNT; level++) {
+        if (level == PROXYFS_RATELIMIT_INODE && args->inode == NULL) {
+            taken_ns[level] = 0;
+            continue;
+        }
+        if (!proxyfs_ratelimit_take(ratelimit_cpu, level, keys[level], devs[level], now, &taken_ns[level])) {
+            break;
+        }
+    }
+    if (level == PROXYFS_RATELIMIT_LEVEL_COUNT) {
+        put_cpu_ptr(&proxyfs_ratelimit_cpus);
+        return true;
+    }
+    while (level-- > 0) {
+        proxyfs_ratelimit_refund(ratelimit_cpu, level, keys[level], devs[level], taken_ns[level]);
+    }
+    put_cpu_ptr(&proxyfs_ratelimit_cpus);
+    return false;
+}
+
+//
+// Set the limit of a level by a line "<level> <rate> [<burst> [<sample>]]"
+// (events per second, 0 rate disables the level), -ENOENT is returned
+// if the line doesn't start by a level name
+int proxyfs_ratelimit_configure(const char *line)
+{
+    char name[16];
+    unsigned int levels = 0;
+    unsigned int rate = 0;
+    unsigned int burst = 0;
+    unsigned int sample = 0;
+    u64 cost_ns = 0;
+    u64 capacity_ns = 0;
+    u64 borrow_ns = 0;
+    int level;
+    int i;
+
+    if (sscanf(line, "%15s", name) != 1) {
+        return -ENOENT;
+    }
+    for (level = 0; level < PROXYFS_RATELIMIT_LEVEL_COUNT; level++) {
+        if (strcmp(name, proxyfs_ratelimit_level_names[level]) == 0) {
+            break;
+        }
+    }
+    if (level == PROXYFS_RATELIMIT_LEVEL_COUNT) {
+        return -ENOENT;
+    }
+    if (sscanf(line, "%15s %u %u %u", name, &rate, &burst, &sample) < 2 ||
+        rate > NSEC_PER_SEC) {
+        return -EINVAL;
+    }
+    if (burst == 0) {
+        burst = rate;
+    }
+    if (rate != 0) {
+        cost_ns = NSEC_PER_SEC / rate;
+        capacity_ns = (u64)burst * cost_ns;
+        borrow_ns = (u64)max(burst / PROXYFS_RATELIMIT_BORROW_SHARE,
+                             min(burst, PROXYFS_RATELIMIT_BORROW_MIN)) * cost_ns;
+    }
+
+    mutex_lock(&proxyfs_ratelimit_lock);
+    proxyfs_ratelimit_limits[level].rate = rate;
+    proxyfs_ratelimit_limits[level].burst = burst;
+    WRITE_ONCE(proxyfs_ratelimit_limits[level].sample, sample);
+    WRITE_ONCE(proxyfs_ratelimit_limits[level].capacity_ns, capacity_ns);
+    WRITE_ONCE(proxyfs_ratelimit_limits[level].borrow_ns, borrow_ns);
+    WRITE_ONCE(proxyfs_ratelimit_limits[level].cost_ns, cost_ns);
+    for (i = 0; i < PROXYFS_RATELIMIT_LEVEL_COUNT; i++) {
+        if (proxyfs_ratelimit_limits[i].rate != 0) {
+            levels |= BIT(i);
+        }
+    }
+    WRITE_ONCE(proxyfs_ratelimit_levels, levels);
+    mutex_unlock(&proxyfs_ratelimit_lock);
+
+    pr_info("%s: %s rate limit is set to %u events/s (burst %u, sample 1/%u)\n",
+            MODULE_NAME,
+            proxyfs_ratelimit_level_names[level],
+            rate,
+            burst,
+            sample);
+    return 0;
+}
+
+//
+// Limits of the levels and the number of events passed, sampled and
+// suppressed by every level
+void proxyfs_ratelimit_show_limits(struct seq_file *m)
+{
+    unsigned long passed;
+    unsigned long sampled;
+    unsigned long suppressed;
+    int level;
+    int cpu;
+
+    seq_printf(m, "%-8s %-10s %-10s %-8s %-12s %-12s %-12s\n",
+               "level", "rate", "burst", "sample", "passed", "sampled", "suppressed");
+    mutex_lock(&proxyfs_ratelimit_lock);
+    for (level = 0; level < PROXYFS_RATELIMIT_LEVEL_COUNT; level++) {
+        passed = 0;
+        sampled = 0;
+        suppressed = 0;
+        for_each_possible_cpu(cpu) {
+            struct proxyfs_ratelimit_cpu *ratelimit_cpu = per_cpu_ptr(&proxyfs_ratelimit_cpus, cpu);
+
+            passed += READ_ONCE(ratelimit_cpu->passed[level]);
+            sampled += READ_ONCE(ratelimit_cpu->sampled[level]);
+            suppressed += READ_ONCE(ratelimit_cpu->suppressed[level]);
+        }
+        seq_printf(m, "%-8s %-10u %-10u %-8u %-12lu %-12lu %-12lu\n",
+                   proxyfs_ratelimit_level_names[level],
+                   proxyfs_ratelimit_limits[level].rate,
+                   proxyfs_ratelimit_limits[level].burst,
+                   proxyfs_ratelimit_limits[level].sample,
+                   passed,
+                   sampled,
+                   suppressed);
+    }
+    mutex_unlock(&proxyfs_ratelimit_lock);
+}
+
+//
+// Live buckets of the keys: tokens left in the shared bucket of a key
+// (cpu "all") and tokens borrowed by every CPU and events suppressed there
+//
+// Note: the buckets are read without synchronization, the values are
+//       approximate
+void proxyfs_ratelimit_show_buckets(struct seq_file *m)
+{
+    u64 now = ktime_get_ns();
+    unsigned int i;
+    int level;
+    int cpu;
+
+    seq_printf(m, "%-8s %-20s %-10s %-4s %-10s %-12s\n",
+               "level", "key", "dev", "cpu", "tokens", "suppressed");
+    for (level = 0; level < PROXYFS_RATELIMIT_LEVEL_COUNT; level++) {
+        u64 cost_ns = READ_ONCE(proxyfs_ratelimit_limits[level].cost_ns);
+        u64 capacity_ns = READ_ONCE(proxyfs_ratelimit_limits[level].capacity_ns);
+
+        if (cost_ns == 0) {
+            continue;
+        }
+        for (i = 0; i < PROXYFS_RATELIMIT_SLOTS; i++) {
+            struct proxyfs_ratelimit_shared *shared = &proxyfs_ratelimit_shared[level][i];
+            u64 last = READ_ONCE(shared->last);
+            u64 credit_ns = READ_ONCE(shared->credit_ns);
+
+            if (!READ_ONCE(shared->used)) {
+                continue;
+            }
+            credit_ns = now > last ? min(credit_ns + (now - last), capacity_ns) : credit_ns;
+            seq_printf(m, "%-8s %-20llu %-10u %-4s %-10llu %-12s\n",
+                       proxyfs_ratelimit_level_names[level],
+                       READ_ONCE(shared->key),
+                       READ_ONCE(shared->dev),
+                       "all",
+                       div64_u64(credit_ns, cost_ns),
+                       "-");
+        }
+        for_each_possible_cpu(cpu) {
+            struct proxyfs_ratelimit_cpu *ratelimit_cpu = per_cpu_ptr(&proxyfs_ratelimit_cpus, cpu);
+
+            for (i = 0; i < PROXYFS_RATELIMIT_SLOTS; i++) {
+                struct proxyfs_ratelimit_bucket *bucket = &ratelimit_cpu->buckets[level][i];
+
+                if (!READ_ONCE(bucket->used)) {
+                    continue;
+                }
+                seq_printf(m, "%-8s %-20llu %-10u %-4d %-10llu %-12lu\n",
+                           proxyfs_ratelimit_level_names[level],
+                           READ_ONCE(bucket->key),
+                           READ_ONCE(bucket->dev),
+                           cpu,
+                           div64_u64(READ_ONCE(bucket->credit_ns), cost_ns),
+                           READ_ONCE(bucket->suppressed));
+            }
+        }
+    }
+}
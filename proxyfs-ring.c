@@ -0,0 +1,261 @@
+// File		:proxyfs-ring.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 10:12:41 2026
+#include <linux/miscdevice.h>
+#include <linux/vmalloc.h>
+#include <linux/poll.h>
+#include <linux/mm.h>
+#include <linux/wait.h>
+#include <linux/log2.h>
+#include "proxyfs.h"
+#include "proxyfs-ring.h"
+
+struct proxyfs_ring {
+    //
+    // Memory shared with the consumer: header followed by the records
+    void *area;
+    size_t area_size;
+    struct proxyfs_ring_header *header;
+    char *records;
+    //
+    // Geometry and counters of the ring, the header just exports copies
+    // of them
+    //
+    // Note: the header is writable by the consumer, thus nothing but
+    //       `consumer` is read back from it (and it is not trusted)
+    u32 record_size;
+    u32 record_count;
+    u64 producer;
+    u64 dropped;
+    //
+    // The ring replaces NETLINK channel while the consumer is attached
+    bool exclusive;
+    //
+    // Serializes producers
+    spinlock_t lock;
+    wait_queue_head_t wait;
+    //
+    // Set while the device is opened (just one consumer is allowed)
+    atomic_t attached;
+};
+
+static struct proxyfs_ring proxyfs_ring;
+
+static int proxyfs_ring_open(struct inode *inode, struct file *file)
+{
+    struct proxyfs_ring *ring = &proxyfs_ring;
+    unsigned long flags;
+
+    if (atomic_cmpxchg(&ring->attached, 0, 1) != 0) {
+        return -EBUSY;
+    }
+    //
+    // Every consumer starts with an empty ring
+    spin_lock_irqsave(&ring->lock, flags);
+    ring->producer = 0;
+    ring->dropped = 0;
+    WRITE_ONCE(ring->header->producer, 0);
+    WRITE_ONCE(ring->header->consumer, 0);
+    WRITE_ONCE(ring->header->dropped, 0);
+    spin_unlock_irqrestore(&ring->lock, flags);
+    pr_info("%s: ring consumer attached (pid %d)\n",
+            MODULE_NAME,
+            current->pid);
+    return 0;
+}
+
+static int proxyfs_ring_release_file(struct inode *inode, struct file *file)
+{
+    atomic_set(&proxyfs_ring.attached, 0);
+    pr_info("%s: ring consumer detached\n",
+            MODULE_NAME);
+    return 0;
+}
+
+static int proxyfs_ring_mmap(struct file *file, struct vm_area_struct *vma)
+{
+    struct proxyfs_ring *ring = &proxyfs_ring;
+
+    if (vma->vm_pgoff != 0 ||
+        vma->vm_end - vma->vm_start != ring->area_size) {
+        return -EINVAL;
+    }
+    return remap_vmalloc_range(vma, ring->area, 0);
+}
+
+static __poll_t proxyfs_ring_poll(struct file *file, struct poll_table_struct *pts)
+{
+    struct proxyfs_ring *ring = &proxyfs_ring;
+
+    poll_wait(file, &ring->wait, pts);
+    if (READ_ONCE(ring->producer) != READ_ONCE(ring->header->consumer)) {
+        return EPOLLIN | EPOLLRDNORM;
+    }
+    return 0;
+}
+
+static const struct file_operations proxyfs_ring_fops = {
+    .owner = THIS_MODULE,
+    .open = proxyfs_ring_open,
+    .release = proxyfs_ring_release_file,
+    .mmap = proxyfs_ring_mmap,
+    .poll = proxyfs_ring_poll,
+    .llseek = noop_llseek,
+};
+
+static struct miscdevice proxyfs_ring_device = {
+    .minor = MISC_DYNAMIC_MINOR,
+    .name = PROXYFS_RING_DEVICE,
+    .fops = &proxyfs_ring_fops,
+    .mode = 0600,
+};
+
+//
+// Count the record dropped and export the counter to the consumer
+// Note: must be called under `ring->lock`
+static void proxyfs_ring_drop(struct proxyfs_ring *ring)
+{
+    ring->dropped++;
+    WRITE_ONCE(ring->header->dropped, ring->dropped);
+}
+
+//
+// Write the message to the ring, false is returned if there is no
+// consumer attached (thus the message should be delivered another way)
+bool proxyfs_ring_write(const char *msg_body, size_t msg_len)
+{
+    struct proxyfs_ring *ring = &proxyfs_ring;
+    struct proxyfs_ring_record *record;
+    unsigned long flags;
+    u64 producer;
+    u64 consumer;
+    bool wakeup = false;
+
+    if (ring->area == NULL || !atomic_read(&ring->attached)) {
+        return false;
+    }
+    if (msg_len > ring->record_size - sizeof(struct proxyfs_ring_record)) {
+        spin_lock_irqsave(&ring->lock, flags);
+        proxyfs_ring_drop(ring);
+        spin_unlock_irqrestore(&ring->lock, flags);
+        return true;
+    }
+
+    spin_lock_irqsave(&ring->lock, flags);
+    producer = ring->producer;
+    //
+    // Note: acquire pairs with release of the consumer, thus the record
+    //       is not overwritten until the consumer is done with it; a
+    //       consumer index ahead of the producer one (or too far behind)
+    //       is bogus and the ring is treated as full then
+    consumer = smp_load_acquire(&ring->header->consumer);
+    if (producer - consumer >= ring->record_count) {
+        proxyfs_ring_drop(ring);
+    } else {
+        record = (struct proxyfs_ring_record *)(ring->records +
+                                                (producer & (ring->record_count - 1)) * ring->record_size);
+        record->len = msg_len;
+        record->reserved = 0;
+        memcpy(record + 1, msg_body, msg_len);
+        ring->producer = producer + 1;
+        smp_store_release(&ring->header->producer, producer + 1);
+        //
+        // Wakeups are coalesced: a consumer sleeps only when it has drained
+        // the ring, thus it is enough to wake it up on the first record
+        wakeup = (producer == consumer);
+    }
+    spin_unlock_irqrestore(&ring->lock, flags);
+
+    if (wakeup && wq_has_sleeper(&ring->wait)) {
+        wake_up_interruptible(&ring->wait);
+    }
+    return true;
+}
+
+bool proxyfs_ring_is_attached(void)
+{
+    return proxyfs_ring.area != NULL && atomic_read(&proxyfs_ring.attached);
+}
+
+bool proxyfs_ring_is_exclusive(void)
+{
+    return proxyfs_ring.exclusive;
+}
+
+int proxyfs_ring_init(const struct proxyfs_ring_config *config)
+{
+    struct proxyfs_ring *ring = &proxyfs_ring;
+    size_t data_offset = PAGE_ALIGN(sizeof(struct proxyfs_ring_header));
+    unsigned int record_size;
+    int res;
+
+    memset(ring, 0, sizeof(*ring));
+    if (config->records == 0) {
+        pr_info("%s: shared memory ring is disabled\n",
+                MODULE_NAME);
+        return 0;
+    }
+    if (!is_power_of_2(config->records) ||
+        config->record_size <= sizeof(struct proxyfs_ring_record) ||
+        config->record_size % sizeof(u64) != 0) {
+        pr_err("%s: invalid shared memory ring geometry (%u records %u bytes length)\n",
+               MODULE_NAME,
+               config->records,
+               config->record_size);
+        return -EINVAL;
+    }
+    //
+    // Every message is held by a buffer of the pool, thus a slot fitting
+    // the largest buffer takes any message (no one is dropped as too long)
+    record_size = max_t(unsigned int,
+                        config->record_size,
+                        round_up(sizeof(struct proxyfs_ring_record) +
+                                 proxyfs_buffer_pool_max_size(proxyfs_context_get_buffer_pool()),
+                                 sizeof(u64)));
+    ring->area_size = PAGE_ALIGN(data_offset + (size_t)config->records * record_size);
+    if ((ring->area = vmalloc_user(ring->area_size)) == NULL) {
+        pr_err("%s: unable to allocate shared memory ring\n",
+               MODULE_NAME);
+        return -ENOMEM;
+    }
+    ring->header = ring->area;
+    ring->records = (char *)ring->area + data_offset;
+    ring->header->version = PROXYFS_RING_VERSION;
+    ring->header->record_size = record_size;
+    ring->header->record_count = config->records;
+    ring->header->data_offset = data_offset;
+    ring->record_size = record_size;
+    ring->record_count = config->records;
+    ring->exclusive = config->exclusive;
+    spin_lock_init(&ring->lock);
+    init_waitqueue_head(&ring->wait);
+    atomic_set(&ring->attached, 0);
+
+    if ((res = misc_register(&proxyfs_ring_device)) != 0) {
+        pr_err("%s: unable to register /dev/%s: %d\n",
+               MODULE_NAME,
+               PROXYFS_RING_DEVICE,
+               res);
+        vfree(ring->area);
+        ring->area = NULL;
+        return res;
+    }
+    pr_info("%s: shared memory ring /dev/%s with %u records %u bytes length is ready for use\n",
+            MODULE_NAME,
+            PROXYFS_RING_DEVICE,
+            config->records,
+            record_size);
+    return 0;
+}
+
+void proxyfs_ring_release(void)
+{
+    struct proxyfs_ring *ring = &proxyfs_ring;
+
+    if (ring->area == NULL) {
+        return;
+    }
+    misc_deregister(&proxyfs_ring_device);
+    vfree(ring->area);
+    ring->area = NULL;
+}
@@ -0,0 +1,57 @@
+// File		:proxyfs-ring.h
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 10:12:41 2026
+//
+// Layout of the shared memory event ring exposed by `/dev/proxyfs`, the
+// header is shared with userspace consumers
+#ifndef __PROXYFS_RING_H__
+#define __PROXYFS_RING_H__
+#include <linux/types.h>
+
+#define PROXYFS_RING_DEVICE  "proxyfs"
+#define PROXYFS_RING_VERSION 1
+
+//
+// Default geometry of the ring: number of records (power of 2) and
+// size of a record slot (including `struct proxyfs_ring_record`)
+//
+// Note: the slot is enlarged to fit the largest buffer of the pool, thus
+//       the actual size is reported by the header
+#define PROXYFS_RING_RECORDS     1024
+#define PROXYFS_RING_RECORD_SIZE 256
+
+//
+// The ring is mapped as a whole: the header occupies the first
+// `data_offset` bytes, records follow it every `record_size` bytes
+//
+// Producer and consumer indexes are free running counters, record of an
+// index is at `data_offset + (index & (record_count - 1)) * record_size`;
+// the consumer reads `producer` with acquire semantics, processes records
+// up to it and publishes `consumer` with release semantics
+//
+// Note: the kernel keeps its own copies of the geometry and the counters,
+//       changing them here has no effect but on the consumer itself
+struct proxyfs_ring_header {
+    __u32 version;
+    __u32 record_size;
+    __u32 record_count;
+    __u32 data_offset;
+    //
+    // Records not written as the ring was full or a record was too long
+    __u64 dropped;
+    //
+    // Updated by the kernel only
+    __u64 producer __attribute__((aligned(64)));
+    //
+    // Updated by the consumer only
+    __u64 consumer __attribute__((aligned(64)));
+};
+
+struct proxyfs_ring_record {
+    __u32 len;
+    __u32 reserved;
+    //
+    // `len` bytes of the message follow
+};
+
+#endif //  !__PROXYFS_RING_H__
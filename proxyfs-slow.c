@@ -0,0 +1,395 @@
+// File		:proxyfs-slow.c
+// Author	:Victor Kovalevich
+// Created	:Sat Oct 17 03:08:52 2026
+#include <linux/spinlock.h>
+#include <linux/mutex.h>
+#include <linux/workqueue.h>
+#include <linux/stacktrace.h>
+#include <linux/seq_file.h>
+#include <linux/dcache.h>
+#include <linux/cred.h>
+#include <linux/sched.h>
+#include <linux/string.h>
+#include "proxyfs.h"
+
+//
+// Slow call waiting to be reported, its dentry is referenced till then
+struct proxyfs_slow_call {
+    enum proxyfs_stats_op op;
+    struct dentry *dentry;
+    u64 time;
+    u64 ino;
+    u32 dev;
+    pid_t pid;
+    pid_t tgid;
+    uid_t uid;
+    u64 latency_ns;
+    u64 lower_ns;
+    long ret;
+    char fstype[PROXYFS_SLOW_FSTYPE_LEN];
+    unsigned int nr_stack;
+    unsigned long stack[PROXYFS_SLOW_STACK_DEPTH];
+};
+
+//
+// Report kept in the ring, a summary (`calls` is not 0) stands for the
+// calls of the operation suppressed within a window, its `latency_ns` is
+// the longest one
+struct proxyfs_slow_report {
+    struct proxyfs_slow_call call;
+    u32 calls;
+    char path[PROXYFS_SLOW_PATH_LEN];
+};
+
+static struct {
+    //
+    // Threshold (ns) of every operation (0 if its calls are not checked)
+    // and the one set for all of them
+    u64 threshold_ns[PROXYFS_STATS_OP_COUNT];
+    u64 default_ns;
+    unsigned int burst;
+    bool stack;
+    //
+    // Window, calls waiting to be reported and the ones suppressed,
+    // the lock is taken by the handlers thus it never sleeps
+    spinlock_t lock;
+    u64 window_start;
+    unsigned int window_reports;
+    struct proxyfs_slow_call pending[PROXYFS_SLOW_PENDING];
+    unsigned int pending_head;
+    unsigned int pending_count;
+    u32 suppressed[PROXYFS_STATS_OP_COUNT];
+    u64 suppressed_ns[PROXYFS_STATS_OP_COUNT];
+    bool summary_scheduled;
+    //
+    // Reports kept, written by the work items only
+    struct mutex reports_lock;
+    struct proxyfs_slow_report reports[PROXYFS_SLOW_RECORDS];
+    unsigned long reports_head;
+    struct work_struct report_work;
+    struct delayed_work summary_work;
+    atomic_long_t calls;
+    atomic_long_t reported;
+    atomic_long_t summarized;
+} proxyfs_slow;
+
+static void proxyfs_slow_keep(const struct proxyfs_slow_report *report)
+{
+    mutex_lock(&proxyfs_slow.reports_lock);
+    proxyfs_slow.reports[proxyfs_slow.reports_head++ % PROXYFS_SLOW_RECORDS] = *report;
+    mutex_unlock(&proxyfs_slow.reports_lock);
+}
+
+static void proxyfs_slow_render_path(struct proxyfs_slow_report *report)
+{
+    char *path;
+
+    if (report->call.dentry == NULL) {
+        strscpy(report->path, "-", sizeof(report->path));
+        return;
+    }
+    path = dentry_path_raw(report->call.dentry, report->path, sizeof(report->path));
+    if (IS_ERR(path)) {
+        strscpy(report->path, "?", sizeof(report->path));
+        return;
+    }
+    memmove(report->path, path, strlen(path) + 1);
+}
+
+//
+// Report the slow calls pending: the paths are rendered here, thus the
+// handlers (which may run in atomic context) don't do that
+static void proxyfs_slow_report_calls(struct work_struct *work)
+{
+    struct proxyfs_slow_report report;
+    unsigned long flags;
+
+    for (;;) {
+        memset(&report, 0, sizeof(report));
+        spin_lock_irqsave(&proxyfs_slow.lock, flags);
+        if (proxyfs_slow.pending_count == 0) {
+            spin_unlock_irqrestore(&proxyfs_slow.lock, flags);
+            break;
+        }
+        report.call = proxyfs_slow.pending[proxyfs_slow.pending_head];
+        proxyfs_slow.pending_head = (proxyfs_slow.pending_head + 1) % PROXYFS_SLOW_PENDING;
+        proxyfs_slow.pending_count--;
+        spin_unlock_irqrestore(&proxyfs_slow.lock, flags);
+
+        proxyfs_slow_render_path(&report);
+        proxyfs_event_notify(PROXYFS_EVENT_OP_SLOW,
+                             &(struct proxyfs_event_args) {
+                                 .inode = report.call.dentry ? d_inode(report.call.dentry) : NULL,
+                                 .path = report.call.dentry,
+                                 .pid = report.call.pid,
+                                 .tgid = report.call.tgid,
+                                 .uid = report.call.uid,
+                                 .timestamp = report.call.time,
+                                 .operation = proxyfs_stats_op_name(report.call.op),
+                                 .fstype = report.call.fstype,
+                                 .latency = report.call.latency_ns,
+                             });
+        dput(report.call.dentry);
+        report.call.dentry = NULL;
+        proxyfs_slow_keep(&report);
+        atomic_long_inc(&proxyfs_slow.reported);
+    }
+}
+
+//
+// Summarize the slow calls suppressed within the window, one report per
+// operation
+static void proxyfs_slow_report_summary(struct work_struct *work)
+{
+    u32 suppressed[PROXYFS_STATS_OP_COUNT];
+    u64 suppressed_ns[PROXYFS_STATS_OP_COUNT];
+    struct proxyfs_slow_report report;
+    unsigned long flags;
+    u64 now = ktime_get_real_ns();
+    int op;
+
+    spin_lock_irqsave(&proxyfs_slow.lock, flags);
+    memcpy(suppressed, proxyfs_slow.suppressed, sizeof(suppressed));
+    memcpy(suppressed_ns, proxyfs_slow.suppressed_ns, sizeof(suppressed_ns));
+    memset(proxyfs_slow.suppressed, 0, sizeof(proxyfs_slow.suppressed));
+    memset(proxyfs_slow.suppressed_ns, 0, sizeof(proxyfs_slow.suppressed_ns));
+    proxyfs_slow.summary_scheduled = false;
+    spin_unlock_irqrestore(&proxyfs_slow.lock, flags);
+
+    for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+        if (suppressed[op] == 0) {
+            continue;
+        }
+        memset(&report, 0, sizeof(report));
+        report.call.op = op;
+        report.call.time = now;
+        report.call.latency_ns = suppressed_ns[op];
+        report.calls = suppressed[op];
+        strscpy(report.path, "-", sizeof(report.path));
+        proxyfs_event_notify(PROXYFS_EVENT_OP_SLOW_SUMMARY,
+                             &(struct proxyfs_event_args) {
+                                 .timestamp = now,
+                                 .operation = proxyfs_stats_op_name(op),
+                                 .calls = suppressed[op],
+                                 .latency = suppressed_ns[op],
+                             });
+        proxyfs_slow_keep(&report);
+        atomic_long_add(suppressed[op], &proxyfs_slow.summarized);
+    }
+}
+
+//
+// Queue the slow call to be reported, the calls over the budget of the
+// window (or the ones not fitting the queue) are just counted to be
+// summarized when the window ends
+static noinline void proxyfs_slow_submit(const struct proxyfs_stats_timer *timer,
+                                         u64 latency_ns)
+{
+    struct super_block *lower_sb = proxyfs_lower_sb(timer->sb);
+    struct proxyfs_slow_call *call;
+    unsigned long flags;
+    u64 now = ktime_get_ns();
+    bool report = false;
+    bool summarize = false;
+
+    atomic_long_inc(&proxyfs_slow.calls);
+    spin_lock_irqsave(&proxyfs_slow.lock, flags);
+    if (now - proxyfs_slow.window_start >= PROXYFS_SLOW_WINDOW_MS * NSEC_PER_MSEC) {
+        proxyfs_slow.window_start = now;
+        proxyfs_slow.window_reports = 0;
+    }
+    if (proxyfs_slow.window_reports < proxyfs_slow.burst &&
+        proxyfs_slow.pending_count < PROXYFS_SLOW_PENDING) {
+        call = &proxyfs_slow.pending[(proxyfs_slow.pending_head + proxyfs_slow.pending_count) %
+                                     PROXYFS_SLOW_PENDING];
+        proxyfs_slow.pending_count++;
+        proxyfs_slow.window_reports++;
+        call->op = timer->op;
+        call->dentry = timer->dentry ? dget(timer->dentry) : NULL;
+        call->time = ktime_get_real_ns();
+        call->ino = timer->ino;
+        call->dev = new_encode_dev(timer->dev);
+        call->pid = task_pid_nr(current);
+        call->tgid = task_tgid_nr(current);
+        call->uid = from_kuid(&init_user_ns, current_fsuid());
+        call->latency_ns = latency_ns;
+        call->lower_ns = timer->lower_ns;
+        call->ret = timer->ret;
+        strscpy(call->fstype,
+                lower_sb ? lower_sb->s_type->name : "?",
+                sizeof(call->fstype));
+        call->nr_stack = proxyfs_slow.stack ?
+            stack_trace_save(call->stack, PROXYFS_SLOW_STACK_DEPTH, 2) : 0;
+        report = true;
+    } else {
+        proxyfs_slow.suppressed[timer->op]++;
+        proxyfs_slow.suppressed_ns[timer->op] = max(proxyfs_slow.suppressed_ns[timer->op],
+                                                    latency_ns);
+        if (!proxyfs_slow.summary_scheduled) {
+            proxyfs_slow.summary_scheduled = true;
+            summarize = true;
+        }
+    }
+    spin_unlock_irqrestore(&proxyfs_slow.lock, flags);
+
+    if (report) {
+        schedule_work(&proxyfs_slow.report_work);
+    }
+    if (summarize) {
+        schedule_delayed_work(&proxyfs_slow.summary_work,
+                              msecs_to_jiffies(PROXYFS_SLOW_WINDOW_MS));
+    }
+}
+
+//
+// Check the duration of the call against the threshold of its operation,
+// that costs a load and a compare unless the call is slow
+void proxyfs_slow_check(const struct proxyfs_stats_timer *timer,
+                        u64 latency_ns)
+{
+    u64 threshold_ns = READ_ONCE(proxyfs_slow.threshold_ns[timer->op]);
+
+    if (threshold_ns != 0 && latency_ns >= threshold_ns) {
+        proxyfs_slow_submit(timer, latency_ns);
+    }
+}
+
+//
+// Report the slow calls pending, thus the dentries they reference are
+// released
+//
+// Note: must be called before the dentries of a mount are shrunk
+void proxyfs_slow_flush(void)
+{
+    flush_work(&proxyfs_slow.report_work);
+}
+
+void proxyfs_slow_init(const struct proxyfs_slow_config *config)
+{
+    int op;
+
+    spin_lock_init(&proxyfs_slow.lock);
+    mutex_init(&proxyfs_slow.reports_lock);
+    INIT_WORK(&proxyfs_slow.report_work, proxyfs_slow_report_calls);
+    INIT_DELAYED_WORK(&proxyfs_slow.summary_work, proxyfs_slow_report_summary);
+    atomic_long_set(&proxyfs_slow.calls, 0);
+    atomic_long_set(&proxyfs_slow.reported, 0);
+    atomic_long_set(&proxyfs_slow.summarized, 0);
+    proxyfs_slow.burst = config->burst;
+    proxyfs_slow.stack = config->stack;
+    proxyfs_slow.default_ns = (u64)config->threshold_ms * NSEC_PER_MSEC;
+    for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+        proxyfs_slow.threshold_ns[op] = proxyfs_slow.default_ns;
+    }
+    pr_info("%s: calls slower than %u ms are reported (%u per %u ms)\n",
+            MODULE_NAME,
+            config->threshold_ms,
+            config->burst,
+            PROXYFS_SLOW_WINDOW_MS);
+}
+
+//
+// Note: must be called when no mount is left
+void proxyfs_slow_release(void)
+{
+    flush_work(&proxyfs_slow.report_work);
+    cancel_delayed_work_sync(&proxyfs_slow.summary_work);
+}
+
+//
+// Command "<op> <ms>" sets the threshold of the operation (see
+// `PROXYFS_STATS_OPS()`), "all <ms>" sets it for every operation; 0
+// stops checking the calls
+int proxyfs_slow_configure(const char *line)
+{
+    char name[32];
+    unsigned int threshold_ms;
+    int op;
+
+    if (sscanf(line, "%31s %u", name, &threshold_ms) != 2) {
+        return -EINVAL;
+    }
+    if (strcmp(name, "all") == 0) {
+        WRITE_ONCE(proxyfs_slow.default_ns, (u64)threshold_ms * NSEC_PER_MSEC);
+        for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+            WRITE_ONCE(proxyfs_slow.threshold_ns[op], (u64)threshold_ms * NSEC_PER_MSEC);
+        }
+        return 0;
+    }
+    if ((op = proxyfs_stats_op_find(name)) < 0) {
+        return op;
+    }
+    WRITE_ONCE(proxyfs_slow.threshold_ns[op], (u64)threshold_ms * NSEC_PER_MSEC);
+    return 0;
+}
+
+static void proxyfs_slow_show_report(struct seq_file *m,
+                                     const struct proxyfs_slow_report *report)
+{
+    const struct proxyfs_slow_call *call = &report->call;
+    unsigned int i;
+
+    if (report->calls != 0) {
+        seq_printf(m, "%llu summary op=%s calls=%u max_latency_ns=%llu\n",
+                   call->time,
+                   proxyfs_stats_op_name(call->op),
+                   report->calls,
+                   call->latency_ns);
+        return;
+    }
+    seq_printf(m, "%llu slow op=%s path=%s dev=%u:%u ino=%llu pid=%d tgid=%d uid=%u "
+               "fstype=%s latency_ns=%llu lower_ns=%llu ret=%ld\n",
+               call->time,
+               proxyfs_stats_op_name(call->op),
+               report->path,
+               MAJOR(new_decode_dev(call->dev)),
+               MINOR(new_decode_dev(call->dev)),
+               call->ino,
+               call->pid,
+               call->tgid,
+               call->uid,
+               call->fstype,
+               call->latency_ns,
+               call->lower_ns,
+               call->ret);
+    for (i = 0; i < call->nr_stack; i++) {
+        seq_printf(m, "\t%pS\n", (void *)call->stack[i]);
+    }
+}
+
+//
+// Thresholds differing from the one of all the operations, counters and
+// the reports kept (oldest first, time is the real time in ns)
+void proxyfs_slow_show(struct seq_file *m)
+{
+    u64 default_ns = READ_ONCE(proxyfs_slow.default_ns);
+    unsigned long head;
+    unsigned long i;
+    int op;
+
+    seq_printf(m, "threshold_ms: %llu\n", div_u64(default_ns, NSEC_PER_MSEC));
+    for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+        u64 threshold_ns = READ_ONCE(proxyfs_slow.threshold_ns[op]);
+
+        if (threshold_ns != default_ns) {
+            seq_printf(m, "\t%s: %llu\n",
+                       proxyfs_stats_op_name(op),
+                       div_u64(threshold_ns, NSEC_PER_MSEC));
+        }
+    }
+    seq_printf(m, "burst: %u per %u ms\n",
+               proxyfs_slow.burst,
+               PROXYFS_SLOW_WINDOW_MS);
+    seq_printf(m, "calls: %ld reported: %ld summarized: %ld\n\n",
+               atomic_long_read(&proxyfs_slow.calls),
+               atomic_long_read(&proxyfs_slow.reported),
+               atomic_long_read(&proxyfs_slow.summarized));
+
+    mutex_lock(&proxyfs_slow.reports_lock);
+    head = proxyfs_slow.reports_head;
+    i = head > PROXYFS_SLOW_RECORDS ? head - PROXYFS_SLOW_RECORDS : 0;
+    for (; i < head; i++) {
+        proxyfs_slow_show_report(m, &proxyfs_slow.reports[i % PROXYFS_SLOW_RECORDS]);
+    }
+    mutex_unlock(&proxyfs_slow.reports_lock);
+}
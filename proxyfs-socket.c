@@ -2,50 +2,455 @@
 // Author	:Victor Kovalevich
 // Created	:Fri Jul 11 13:07:00 2025
 #include <linux/netlink.h>
+#include <linux/hrtimer.h>
+#include <linux/log2.h>
+#include <linux/overflow.h>
+#include <linux/seq_file.h>
+#include <net/netlink.h>
 #include "proxyfs.h"
+#include "proxyfs-trace.h"
+
+//
+// Reason of a batch to be sent
+enum proxyfs_socket_flush_reason {
+    PROXYFS_SOCKET_FLUSH_SIZE,
+    PROXYFS_SOCKET_FLUSH_TIMER,
+    PROXYFS_SOCKET_FLUSH_EXPLICIT,
+    PROXYFS_SOCKET_FLUSH_REASONS
+};
+
+//
+// Destinations of the messages: the registered client and multicast
+// group of every event class (groups are numbered from 1, thus a group
+// is an index of its destination)
+#define PROXYFS_SOCKET_UNICAST      0
+#define PROXYFS_SOCKET_DESTINATIONS (1 + PROXYFS_EVENT_CLASS_COUNT)
+
+//
+// Events pending to be sent as a single multipart NETLINK message
+struct proxyfs_socket_batch {
+    spinlock_t lock;
+    struct sk_buff *skb;
+    unsigned int count;
+    struct hrtimer timer;
+    //
+    // Multicast group the batch is sent to, `PROXYFS_SOCKET_UNICAST`
+    // for the registered client
+    unsigned int group;
+    //
+    // Statistics (updated under `lock`): number of sent batches by log2
+    // of their event count and by the flush reason
+    unsigned long histogram[PROXYFS_SOCKET_BATCH_BUCKETS];
+    unsigned long reasons[PROXYFS_SOCKET_FLUSH_REASONS];
+};
+
+static struct proxyfs_socket_config proxyfs_socket_config;
+static struct proxyfs_socket_batch proxyfs_socket_batches[PROXYFS_SOCKET_DESTINATIONS];
+
+//
+// Messages NETLINK has not accepted (the receive queue of a client is full)
+static atomic_long_t proxyfs_socket_drops = ATOMIC_LONG_INIT(0);
 
 //
 // NETLINK receive message callback
 static void proxyfs_socket_recv_msg(struct sk_buff *sk_buffer)
 {
     struct nlmsghdr* nl_header;
+    struct proxyfs_client_hello *hello;
+    struct proxyfs_client_verdicts *verdicts;
+    struct bpf_prog *prog = NULL;
+    u32 portid = NETLINK_CB(sk_buffer).portid;
+    u32 classes = U32_MAX & ~BIT(PROXYFS_EVENT_CLASS_PERMISSION);
+    u16 filter_len = 0;
+    int old_client_port;
+    int res;
 
-    ///// //
-    ///// // Note: following code can be used for minimal access restrictions
-    ///// const struct cred* cred = NETLINK_CB(sk_buffer).sk ? NETLINK_CB(sk_buffer).sk->sk_socket->file->f_cred : NULL;
-    ///// if (!cap_raised(cred->cap_effective, CAP_NET_ADMIN)) {
-    /////     pr_warn("Access denied: no CAP_NET_ADMIN capability\n");
-    /////     return;
-    ///// }
-
-    nl_header = (struct nlmsghdr*)sk_buffer->data;
-    proxyfs_context_set_client_pid(nl_header->nlmsg_pid);
-    pr_info("%s: Registered client PID=%d\n",
-            MODULE_NAME,
-            proxyfs_context_get_client_pid());
-    if (nl_header->nlmsg_len > 0 && nlmsg_data(nl_header)) {
-        pr_info("%s: Registration message: %s\n",
+    //
+    // Note: registration and verdicts are restricted to privileged
+    //       processes, otherwise anybody could take the events over or
+    //       answer the permission requests
+    if (!netlink_capable(sk_buffer, CAP_NET_ADMIN)) {
+        pr_warn_ratelimited("%s: Access denied to port %u: no CAP_NET_ADMIN capability\n",
+                            MODULE_NAME,
+                            portid);
+        return;
+    }
+    //
+    // Note: the length claimed by the header is trusted only if it fits
+    //       the buffer received
+    nl_header = nlmsg_hdr(sk_buffer);
+    if (sk_buffer->len < NLMSG_HDRLEN || !nlmsg_ok(nl_header, sk_buffer->len)) {
+        pr_err("%s: Malformed message of client port %u\n",
+               MODULE_NAME,
+               portid);
+        return;
+    }
+    //
+    // Verdicts of the permission requests answered by the client
+    verdicts = nlmsg_data(nl_header);
+    if (nlmsg_len(nl_header) >= sizeof(struct proxyfs_client_verdicts) &&
+        verdicts->magic == PROXYFS_CLIENT_VERDICT_MAGIC) {
+        if (nlmsg_len(nl_header) < struct_size(verdicts, verdicts, verdicts->count)) {
+            pr_err("%s: Truncated verdicts of client port %u\n",
+                   MODULE_NAME,
+                   portid);
+            return;
+        }
+        proxyfs_perm_verdicts(portid, verdicts->verdicts, verdicts->count);
+        return;
+    }
+    hello = nlmsg_data(nl_header);
+    //
+    // Note: clients which don't attach a program may send the hello
+    //       without the program fields
+    if (nlmsg_len(nl_header) >= offsetof(struct proxyfs_client_hello, filter_len) &&
+        hello->magic == PROXYFS_CLIENT_HELLO_MAGIC &&
+        hello->version == PROXYFS_EVENT_VERSION) {
+        if (hello->classes != 0) {
+            classes = hello->classes;
+        }
+        if (nlmsg_len(nl_header) >= sizeof(struct proxyfs_client_hello)) {
+            filter_len = hello->filter_len;
+        }
+        if (nlmsg_len(nl_header) < struct_size(hello, filter, filter_len)) {
+            pr_err("%s: Truncated filter program of client port %u\n",
+                   MODULE_NAME,
+                   portid);
+            return;
+        }
+        if (filter_len != 0 && (res = proxyfs_bpf_create(&prog, hello->filter, filter_len)) != 0) {
+            pr_err("%s: Invalid filter program of client port %u (%d)\n",
+                   MODULE_NAME,
+                   portid,
+                   res);
+            return;
+        }
+    } else if (nlmsg_len(nl_header) > 0) {
+        pr_info("%s: Registration message: %.*s\n",
                 MODULE_NAME,
+                nlmsg_len(nl_header),
                 (char*)nlmsg_data(nl_header));
     }
+    if ((old_client_port = proxyfs_context_register_client(portid, classes, prog)) < 0) {
+        pr_err("%s: Unable to register client PID=%d\n",
+               MODULE_NAME,
+               task_tgid_vnr(current));
+        return;
+    }
+    if (old_client_port > 0 && (u32)old_client_port != portid) {
+        pr_warn("%s: Client port %d is replaced by port %u, "
+                "several clients should join multicast groups instead\n",
+                MODULE_NAME,
+                old_client_port,
+                portid);
+    }
+    pr_info("%s: Registered client PID=%d port %u classes 0x%x filter %u insns\n",
+            MODULE_NAME,
+            task_tgid_vnr(current),
+            portid,
+            classes,
+            filter_len);
+}
+
+//
+// NETLINK socket of a client is closed, the client is withdrawn (thus
+// there is no need to check if the client is alive on every message)
+static int proxyfs_socket_notify(struct notifier_block *nb,
+                                 unsigned long event,
+                                 void *ptr)
+{
+    struct netlink_notify *notify = ptr;
+
+    if (event == NETLINK_URELEASE &&
+        notify->protocol == PROXYFS_NETLINK_USER &&
+        net_eq(notify->net, &init_net) &&
+        proxyfs_context_unregister_client(notify->portid)) {
+        pr_info("%s: Client port %u is closed\n",
+                MODULE_NAME,
+                notify->portid);
+    }
+    return NOTIFY_DONE;
+}
+
+static struct notifier_block proxyfs_socket_notifier = {
+    .notifier_call = proxyfs_socket_notify,
+};
+
+//
+// Detach the pending batch and terminate it by `NLMSG_DONE` message,
+// NULL is returned if there is no pending batch
+// Note: must be called under `batch->lock`
+static struct sk_buff *proxyfs_socket_batch_detach(struct proxyfs_socket_batch *batch,
+                                                   enum proxyfs_socket_flush_reason reason)
+{
+    struct sk_buff *skb = batch->skb;
+
+    if (skb == NULL) {
+        return NULL;
+    }
+    //
+    // Note: room for the terminating message is reserved on every append
+    nlmsg_put(skb, 0, 0, NLMSG_DONE, 0, NLM_F_MULTI);
+    batch->histogram[min_t(unsigned int,
+                           ilog2(batch->count),
+                           PROXYFS_SOCKET_BATCH_BUCKETS - 1)]++;
+    batch->reasons[reason]++;
+    batch->skb = NULL;
+    batch->count = 0;
+    return skb;
+}
+
+static void proxyfs_socket_unicast(struct sk_buff *skb)
+{
+    struct proxyfs_client *client;
+    int idx = proxyfs_context_client_read_lock();
+    int res;
+
+    do {
+        if ((client = proxyfs_context_get_client()) == NULL) {
+            kfree_skb(skb);
+            break;
+        }
+        if ((res = nlmsg_unicast(proxyfs_context_get_nl_socket(),
+                                 skb,
+                                 client->portid)) >= 0) {
+            atomic_long_inc(&client->sent);
+            break;
+        }
+        atomic_long_inc(&client->dropped);
+        atomic_long_inc(&proxyfs_socket_drops);
+        //
+        // Note: a client which is just too slow (ENOBUFS, EAGAIN) stays
+        //       registered, NETLINK reports the overrun to it
+        if (res != -ECONNREFUSED) {
+            break;
+        }
+        pr_err("%s: Error sending to port %u due to the issue: %d, "
+               "connection is closed ",
+               MODULE_NAME,
+               client->portid,
+               res);
+        proxyfs_context_unregister_client(client->portid);
+    } while (false);
+    proxyfs_context_client_read_unlock(idx);
+}
+
+//
+// Send the message to the registered client or multicast group, the
+// message is released even an issue occurs
+static void proxyfs_socket_deliver(struct sk_buff *skb,
+                                   unsigned int group,
+                                   gfp_t gfp)
+{
+    int res;
+
+    if (group == PROXYFS_SOCKET_UNICAST) {
+        proxyfs_socket_unicast(skb);
+        return;
+    }
+    //
+    // Note: -ESRCH just means the subscribers have left the group
+    if ((res = nlmsg_multicast(proxyfs_context_get_nl_socket(),
+                               skb,
+                               0,
+                               group,
+                               gfp)) < 0 && res != -ESRCH) {
+        atomic_long_inc(&proxyfs_socket_drops);
+        pr_err_ratelimited("%s: Error sending to multicast group %u due to the issue: %d\n",
+                           MODULE_NAME,
+                           group,
+                           res);
+    }
+}
+
+static void proxyfs_socket_batch_send(struct proxyfs_socket_batch *batch,
+                                      struct sk_buff *skb)
+{
+    if (skb == NULL) {
+        return;
+    }
+    if (proxyfs_context_get_nl_socket() == NULL) {
+        kfree_skb(skb);
+        return;
+    }
+    proxyfs_socket_deliver(skb, batch->group, GFP_ATOMIC);
+}
+
+//
+// Latency bound of a batch is expired (runs in softirq context)
+static enum hrtimer_restart proxyfs_socket_batch_timer(struct hrtimer *timer)
+{
+    struct proxyfs_socket_batch *batch = container_of(timer, struct proxyfs_socket_batch, timer);
+    struct sk_buff *skb;
+    unsigned long flags;
+
+    spin_lock_irqsave(&batch->lock, flags);
+    skb = proxyfs_socket_batch_detach(batch, PROXYFS_SOCKET_FLUSH_TIMER);
+    spin_unlock_irqrestore(&batch->lock, flags);
+    proxyfs_socket_batch_send(batch, skb);
+
+    return HRTIMER_NORESTART;
+}
+
+//
+// Append the message to the pending batch, the batch is sent if it has
+// no room for the message
+static void proxyfs_socket_batch_append(struct proxyfs_socket_batch *batch,
+                                        const char* msg_body,
+                                        size_t msg_len)
+{
+    size_t room = nlmsg_total_size(msg_len) + nlmsg_total_size(0);
+    struct sk_buff *skb = NULL;
+    struct nlmsghdr* nl_header;
+    unsigned long flags;
+
+    spin_lock_irqsave(&batch->lock, flags);
+    do {
+        if (batch->skb != NULL && skb_tailroom(batch->skb) < room) {
+            skb = proxyfs_socket_batch_detach(batch, PROXYFS_SOCKET_FLUSH_SIZE);
+        }
+        if (batch->skb == NULL) {
+            if ((batch->skb = alloc_skb(max_t(size_t, proxyfs_socket_config.batch_bytes, room),
+                                        GFP_ATOMIC)) == NULL) {
+                pr_err("%s: Failed to allocate sk_buffer_out\n",
+                       MODULE_NAME);
+                break;
+            }
+            hrtimer_start(&batch->timer,
+                          ns_to_ktime((u64)proxyfs_socket_config.batch_latency_us * NSEC_PER_USEC),
+                          HRTIMER_MODE_REL_SOFT);
+        }
+        nl_header = nlmsg_put(batch->skb, 0, 0, PROXYFS_NLMSG_EVENT, msg_len, NLM_F_MULTI);
+        memcpy(nlmsg_data(nl_header), msg_body, msg_len);
+        batch->count++;
+    } while (false);
+    spin_unlock_irqrestore(&batch->lock, flags);
+
+    proxyfs_socket_batch_send(batch, skb);
+}
+
+//
+// Send the pending batches immediately
+void proxyfs_socket_flush(void)
+{
+    struct proxyfs_socket_batch *batch;
+    struct sk_buff *skb;
+    unsigned long flags;
+    unsigned int i;
+
+    if (!proxyfs_socket_config.batch) {
+        return;
+    }
+    for (i = 0; i < PROXYFS_SOCKET_DESTINATIONS; i++) {
+        batch = &proxyfs_socket_batches[i];
+        spin_lock_irqsave(&batch->lock, flags);
+        //
+        // Note: the timer is cancelled under the lock, thus it can't be
+        //       the one armed by the next batch; a callback running already
+        //       finds the batch empty once it gets the lock
+        //       (`hrtimer_try_to_cancel()` doesn't wait for it)
+        if ((skb = proxyfs_socket_batch_detach(batch, PROXYFS_SOCKET_FLUSH_EXPLICIT)) != NULL) {
+            hrtimer_try_to_cancel(&batch->timer);
+        }
+        spin_unlock_irqrestore(&batch->lock, flags);
+        proxyfs_socket_batch_send(batch, skb);
+    }
+}
+
+void proxyfs_socket_show_stats(struct seq_file *m)
+{
+    unsigned long histogram[PROXYFS_SOCKET_BATCH_BUCKETS] = {};
+    unsigned long reasons[PROXYFS_SOCKET_FLUSH_REASONS] = {};
+    struct proxyfs_client *client;
+    unsigned int i;
+    unsigned int j;
+    int idx;
+
+    for (i = 0; i < PROXYFS_SOCKET_DESTINATIONS; i++) {
+        for (j = 0; j < PROXYFS_SOCKET_BATCH_BUCKETS; j++) {
+            histogram[j] += READ_ONCE(proxyfs_socket_batches[i].histogram[j]);
+        }
+        for (j = 0; j < PROXYFS_SOCKET_FLUSH_REASONS; j++) {
+            reasons[j] += READ_ONCE(proxyfs_socket_batches[i].reasons[j]);
+        }
+    }
+    seq_printf(m, "batch=%d latency_us=%u bytes=%u\n",
+               proxyfs_socket_config.batch,
+               proxyfs_socket_config.batch_latency_us,
+               proxyfs_socket_config.batch_bytes);
+    seq_printf(m, "flush: size=%lu timer=%lu explicit=%lu\n",
+               reasons[PROXYFS_SOCKET_FLUSH_SIZE],
+               reasons[PROXYFS_SOCKET_FLUSH_TIMER],
+               reasons[PROXYFS_SOCKET_FLUSH_EXPLICIT]);
+    seq_printf(m, "drops=%ld\n",
+               atomic_long_read(&proxyfs_socket_drops));
+    idx = proxyfs_context_client_read_lock();
+    if ((client = proxyfs_context_get_client()) != NULL) {
+        seq_printf(m, "client: port=%u pid=%d classes=0x%x sent=%ld dropped=%ld\n",
+                   client->portid,
+                   pid_vnr(client->pid),
+                   client->classes,
+                   atomic_long_read(&client->sent),
+                   atomic_long_read(&client->dropped));
+        if (client->prog != NULL) {
+            seq_printf(m, "client filter: jited=%u accepted=%ld rejected=%ld\n",
+                       client->prog->jited,
+                       atomic_long_read(&client->accepted),
+                       atomic_long_read(&client->rejected));
+        }
+    }
+    proxyfs_context_client_read_unlock(idx);
+    seq_printf(m, "%-12s %s\n", "events", "batches");
+    for (i = 0; i < PROXYFS_SOCKET_BATCH_BUCKETS; i++) {
+        seq_printf(m, "%-12lu %lu\n",
+                   1UL << i,
+                   histogram[i]);
+    }
 }
 
-struct sock* proxyfs_socket_init(const int nl_unit_id)
+//
+// Check if anybody has joined the multicast group
+bool proxyfs_socket_has_listeners(unsigned int group)
+{
+    struct sock* nl_socket = proxyfs_context_get_nl_socket();
+
+    return nl_socket != NULL &&
+        group != PROXYFS_SOCKET_UNICAST &&
+        group < PROXYFS_SOCKET_DESTINATIONS &&
+        netlink_has_listeners(nl_socket, group);
+}
+
+struct sock* proxyfs_socket_init(const int nl_unit_id,
+                                 const struct proxyfs_socket_config *config)
 {
     struct netlink_kernel_cfg nl_cfg = {
         .input = proxyfs_socket_recv_msg,
         .flags = 0,
-        .groups = 0,
+        .groups = PROXYFS_EVENT_CLASS_COUNT,
     };
     struct sock* nl_socket = NULL;
+    unsigned int i;
+
     if ((nl_socket = netlink_kernel_create(&init_net, nl_unit_id, &nl_cfg)) == NULL) {
         pr_err("%s: unable to create a Netlink socket with [%d] unit\n",
                MODULE_NAME,
                nl_unit_id);
     } else {
-        pr_info("%s: netlink_kernel_create() with [%d] unit\n",
+        pr_info("%s: netlink_kernel_create() with [%d] unit and %d multicast groups\n",
                 MODULE_NAME,
-                nl_unit_id);
+                nl_unit_id,
+                PROXYFS_EVENT_CLASS_COUNT);
+        proxyfs_socket_config = *config;
+        netlink_register_notifier(&proxyfs_socket_notifier);
+        memset(proxyfs_socket_batches, 0, sizeof(proxyfs_socket_batches));
+        for (i = 0; i < PROXYFS_SOCKET_DESTINATIONS; i++) {
+            spin_lock_init(&proxyfs_socket_batches[i].lock);
+            hrtimer_setup(&proxyfs_socket_batches[i].timer,
+                          proxyfs_socket_batch_timer,
+                          CLOCK_MONOTONIC,
+                          HRTIMER_MODE_REL_SOFT);
+            proxyfs_socket_batches[i].group = i;
+        }
     }
 
     return nl_socket;
@@ -53,66 +458,85 @@ struct sock* proxyfs_socket_init(const int nl_unit_id)
 
 void proxyfs_socket_release(struct sock* nl_socket)
 {
+    unsigned int i;
+
     if (nl_socket == NULL) {
         return;
     }
 
+    proxyfs_socket_flush();
+    for (i = 0; i < PROXYFS_SOCKET_DESTINATIONS; i++) {
+        hrtimer_cancel(&proxyfs_socket_batches[i].timer);
+    }
+    netlink_unregister_notifier(&proxyfs_socket_notifier);
     netlink_kernel_release(nl_socket);
 
     pr_info("%s: netlink_kernel_release()\n",
             MODULE_NAME);
 }
 
-// Sending of a message to the client (if it is registered)
-void proxyfs_socket_send_msg(const char* msg_body, size_t msg_len)
+//
+// Send the message to the destination (batched if it is enabled)
+static void proxyfs_socket_send_to(const char* msg_body,
+                                   size_t msg_len,
+                                   unsigned int group)
 {
     struct sk_buff* sk_buffer_out;
     struct nlmsghdr* nl_header;
-    int res;
 
+    if (proxyfs_socket_config.batch) {
+        proxyfs_socket_batch_append(&proxyfs_socket_batches[group], msg_body, msg_len);
+        return;
+    }
     //
-    // Note: NETLINK socket supports multythread access to send messages
-    //       thus no any extra synchronizations are required
-    if (proxyfs_context_get_nl_socket() == NULL ||
-        proxyfs_context_get_client_pid() <= 0) {
+    // NOTE: message should be released within `proxyfs_socket_deliver` even
+    //       an issue occurs
+    if ((sk_buffer_out = nlmsg_new(msg_len, GFP_KERNEL)) == NULL) {
+        pr_err("%s: Failed to allocate sk_buffer_out\n",
+               MODULE_NAME);
         return;
     }
+    nl_header = nlmsg_put(sk_buffer_out, 0, 0, NLMSG_DONE, msg_len, 0);
+    memcpy(nlmsg_data(nl_header), msg_body, msg_len);
+    proxyfs_socket_deliver(sk_buffer_out, group, GFP_KERNEL);
+}
 
-    struct pid* pid_struct = find_vpid(proxyfs_context_get_client_pid());
-    struct task_struct* task = pid_struct ? get_pid_task(pid_struct, PIDTYPE_PID) : NULL;
+// Sending of a message to the client (if it is registered) and subscribers
+// of the multicast group
+void proxyfs_socket_send_msg(const char* msg_body,
+                             size_t msg_len,
+                             unsigned int group)
+{
+    struct proxyfs_client *client;
+    bool listeners;
+    bool unicast;
+    int idx;
 
-    if (task) {
-        do {
-            //
-            // NOTE: message should be released within `nlmsg_unicast` even
-            //       an issue occurs
-            if ((sk_buffer_out = nlmsg_new(msg_len, GFP_KERNEL)) == NULL) {
-                pr_err("%s: Failed to allocate sk_buffer_out\n",
-                       MODULE_NAME);
-                break;
-            }
-            nl_header = nlmsg_put(sk_buffer_out, 0, 0, NLMSG_DONE, msg_len, 0);
-            memcpy(nlmsg_data(nl_header), msg_body, msg_len);
-
-            // Unicast the message to the client by using its PID (client_pid)
-            if ((res = nlmsg_unicast(proxyfs_context_get_nl_socket(),
-                                     sk_buffer_out,
-                                     proxyfs_context_get_client_pid())) < 0) {
-                pr_err("%s: Error sending to user %d due to the issue: %d, "
-                       "connection is closed ",
-                       MODULE_NAME,
-                       proxyfs_context_get_client_pid(),
-                       res);
-                proxyfs_context_set_client_pid(0);
-            }
-        } while (false);
-        put_task_struct(task);
-    } else {
-        pr_warn("%s: The process with PID %d does not exist, "
-                "the connection is closed forcibly, unable to send the message %s",
-                MODULE_NAME,
-                proxyfs_context_get_client_pid(),
-                msg_body);
-        proxyfs_context_set_client_pid(0);
+    //
+    // Note: NETLINK socket supports multythread access to send messages
+    //       thus no any extra synchronizations are required
+    if (proxyfs_context_get_nl_socket() == NULL) {
+        return;
+    }
+    if ((listeners = proxyfs_socket_has_listeners(group))) {
+        proxyfs_socket_send_to(msg_body, msg_len, group);
+    }
+    //
+    // Note: the client is withdrawn by the NETLINK release notification,
+    //       thus its presence is just checked here
+    idx = proxyfs_context_client_read_lock();
+    client = proxyfs_context_get_client();
+    unicast = client != NULL && (client->classes & BIT(group - 1));
+    //
+    // Note: the program of the client filters what the client receives
+    //       only; control records and the permission requests are not
+    //       passed to the program (see `proxyfs_bpf_filter()`)
+    if (unicast) {
+        unicast = proxyfs_bpf_filter(client, msg_body, msg_len);
+    }
+    if (unicast) {
+        proxyfs_socket_send_to(msg_body, msg_len, PROXYFS_SOCKET_UNICAST);
     }
+    proxyfs_context_client_read_unlock(idx);
+    trace_proxyfs_send_msg(msg_len, group, listeners, unicast);
 }
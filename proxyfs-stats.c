@@ -0,0 +1,227 @@
+// File		:proxyfs-stats.c
+// Author	:Victor Kovalevich
+// Created	:Sat Oct 17 00:52:18 2026
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/seq_file.h>
+#include <linux/log2.h>
+#include "proxyfs.h"
+
+#define PROXYFS_STATS_OP_NAME(NAME, name) [PROXYFS_STATS_OP_##NAME] = #name,
+static const char *const proxyfs_stats_op_names[PROXYFS_STATS_OP_COUNT] = {
+    PROXYFS_STATS_OPS(PROXYFS_STATS_OP_NAME)
+};
+#undef PROXYFS_STATS_OP_NAME
+
+//
+// Counters of an operation of a CPU: time spent in proxyfs itself
+// (`proxy`) and in the lower FS calls (`lower`)
+struct proxyfs_stats_counters {
+    u64 calls;
+    u64 proxy_ns;
+    u64 lower_ns;
+    u32 proxy_hist[PROXYFS_STATS_BUCKETS];
+    u32 lower_hist[PROXYFS_STATS_BUCKETS];
+};
+
+struct proxyfs_stats {
+    struct proxyfs_stats_counters ops[PROXYFS_STATS_OP_COUNT];
+};
+
+static unsigned int proxyfs_stats_bucket(u64 ns)
+{
+    if (ns < (1ULL << PROXYFS_STATS_SHIFT)) {
+        return 0;
+    }
+    return min_t(unsigned int, fls64(ns) - PROXYFS_STATS_SHIFT, PROXYFS_STATS_BUCKETS - 1);
+}
+
+// Lower bound (ns) of the bucket
+static u64 proxyfs_stats_bucket_ns(unsigned int bucket)
+{
+    return bucket ? 1ULL << (bucket + PROXYFS_STATS_SHIFT - 1) : 0;
+}
+
+const char *proxyfs_stats_op_name(enum proxyfs_stats_op op)
+{
+    return op < PROXYFS_STATS_OP_COUNT ? proxyfs_stats_op_names[op] : "?";
+}
+
+//
+// Operation named `name`, -ENOENT is returned if there is no such one
+int proxyfs_stats_op_find(const char *name)
+{
+    int op;
+
+    for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+        if (strcmp(proxyfs_stats_op_names[op], name) == 0) {
+            return op;
+        }
+    }
+    return -ENOENT;
+}
+
+struct proxyfs_stats __percpu *proxyfs_stats_alloc(void)
+{
+    return alloc_percpu(struct proxyfs_stats);
+}
+
+void proxyfs_stats_free(struct proxyfs_stats __percpu *stats)
+{
+    free_percpu(stats);
+}
+
+//
+// Account the call timed, nothing but the counters of the current CPU is
+// touched
+void proxyfs_stats_end(const struct proxyfs_stats_timer *timer)
+{
+    struct proxyfs_stats_counters __percpu *counters;
+    u64 total_ns = ktime_get_ns() - timer->start;
+    u64 proxy_ns;
+
+    //
+    // Note: the tracepoints are disabled usually, thus the switch over
+    //       the operations is skipped by a single patched NOP
+    if (static_branch_unlikely(&proxyfs_trace_ops_active)) {
+        proxyfs_trace_op(timer, total_ns);
+    }
+    proxyfs_flight_record(timer, total_ns);
+    proxyfs_slow_check(timer, total_ns);
+    if (timer->stats == NULL) {
+        return;
+    }
+    proxy_ns = total_ns > timer->lower_ns ? total_ns - timer->lower_ns : 0;
+    counters = &timer->stats->ops[timer->op];
+    this_cpu_inc(counters->calls);
+    this_cpu_add(counters->proxy_ns, proxy_ns);
+    this_cpu_inc(counters->proxy_hist[proxyfs_stats_bucket(proxy_ns)]);
+    if (timer->lower_ns != 0) {
+        this_cpu_add(counters->lower_ns, timer->lower_ns);
+        this_cpu_inc(counters->lower_hist[proxyfs_stats_bucket(timer->lower_ns)]);
+    }
+}
+
+//
+// Note: calls in progress on other CPUs may survive the reset
+void proxyfs_stats_reset(struct proxyfs_stats __percpu *stats)
+{
+    int cpu;
+
+    if (stats == NULL) {
+        return;
+    }
+    for_each_possible_cpu(cpu) {
+        memset(per_cpu_ptr(stats, cpu), 0, sizeof(struct proxyfs_stats));
+    }
+}
+
+//
+// Sum the counters of all the CPUs, NULL is returned on failure
+static struct proxyfs_stats *proxyfs_stats_collect(struct proxyfs_stats __percpu *stats)
+{
+    struct proxyfs_stats *sum;
+    int cpu;
+    int op;
+    int i;
+
+    if (stats == NULL || (sum = kvzalloc(sizeof(*sum), GFP_KERNEL)) == NULL) {
+        return NULL;
+    }
+    for_each_possible_cpu(cpu) {
+        const struct proxyfs_stats *cpu_stats = per_cpu_ptr(stats, cpu);
+
+        for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+            const struct proxyfs_stats_counters *from = &cpu_stats->ops[op];
+            struct proxyfs_stats_counters *to = &sum->ops[op];
+
+            to->calls += READ_ONCE(from->calls);
+            to->proxy_ns += READ_ONCE(from->proxy_ns);
+            to->lower_ns += READ_ONCE(from->lower_ns);
+            for (i = 0; i < PROXYFS_STATS_BUCKETS; i++) {
+                to->proxy_hist[i] += READ_ONCE(from->proxy_hist[i]);
+                to->lower_hist[i] += READ_ONCE(from->lower_hist[i]);
+            }
+        }
+    }
+    return sum;
+}
+
+//
+// One line per operation called (`/proc/self/mountstats`)
+void proxyfs_stats_show_summary(struct seq_file *m,
+                                struct proxyfs_stats __percpu *stats)
+{
+    struct proxyfs_stats *sum;
+    int op;
+
+    if ((sum = proxyfs_stats_collect(stats)) == NULL) {
+        return;
+    }
+    for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+        if (sum->ops[op].calls == 0) {
+            continue;
+        }
+        seq_printf(m, "\t%s: calls=%llu proxy_ns=%llu lower_ns=%llu\n",
+                   proxyfs_stats_op_names[op],
+                   sum->ops[op].calls,
+                   sum->ops[op].proxy_ns,
+                   sum->ops[op].lower_ns);
+    }
+    kvfree(sum);
+}
+
+static void proxyfs_stats_show_hist(struct seq_file *m,
+                                    const char *op_name,
+                                    const char *name,
+                                    const u32 *hist)
+{
+    int i;
+
+    seq_printf(m, "%-26s %-6s", op_name, name);
+    for (i = 0; i < PROXYFS_STATS_BUCKETS; i++) {
+        if (hist[i] != 0) {
+            seq_printf(m, " %llu:%u", proxyfs_stats_bucket_ns(i), hist[i]);
+        }
+    }
+    seq_printf(m, "\n");
+}
+
+//
+// Counters of the operations called followed by their histograms, a
+// histogram bucket is shown as "<lower bound (ns)>:<calls>"
+void proxyfs_stats_show(struct seq_file *m,
+                        struct proxyfs_stats __percpu *stats)
+{
+    struct proxyfs_stats *sum;
+    int op;
+
+    if ((sum = proxyfs_stats_collect(stats)) == NULL) {
+        return;
+    }
+    seq_printf(m, "%-26s %-12s %-16s %-16s %-10s %-10s\n",
+               "op", "calls", "proxy_ns", "lower_ns", "proxy_avg", "lower_avg");
+    for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+        const struct proxyfs_stats_counters *counters = &sum->ops[op];
+
+        if (counters->calls == 0) {
+            continue;
+        }
+        seq_printf(m, "%-26s %-12llu %-16llu %-16llu %-10llu %-10llu\n",
+                   proxyfs_stats_op_names[op],
+                   counters->calls,
+                   counters->proxy_ns,
+                   counters->lower_ns,
+                   div64_u64(counters->proxy_ns, counters->calls),
+                   div64_u64(counters->lower_ns, counters->calls));
+    }
+    seq_printf(m, "\nlatency histograms (ns):\n");
+    for (op = 0; op < PROXYFS_STATS_OP_COUNT; op++) {
+        if (sum->ops[op].calls == 0) {
+            continue;
+        }
+        proxyfs_stats_show_hist(m, proxyfs_stats_op_names[op], "proxy", sum->ops[op].proxy_hist);
+        proxyfs_stats_show_hist(m, proxyfs_stats_op_names[op], "lower", sum->ops[op].lower_hist);
+    }
+    kvfree(sum);
+}
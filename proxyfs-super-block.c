@@ -2,8 +2,103 @@
 // Author	:Victor Kovalevich
 // Created	:Wed Jul 16 00:11:45 2025
 #include <linux/namei.h>
+#include <linux/parser.h>
+#include <linux/slab.h>
 #include "proxyfs.h"
 
+enum {
+    PROXYFS_OPT_LOWERDIR,
+    PROXYFS_OPT_BACKPRESSURE,
+    PROXYFS_OPT_BACKPRESSURE_TIMEOUT_US,
+    PROXYFS_OPT_SAMPLE_RATE,
+    PROXYFS_OPT_ERR
+};
+
+static const match_table_t proxyfs_mount_tokens = {
+    {PROXYFS_OPT_LOWERDIR, "lowerdir=%s"},
+    {PROXYFS_OPT_BACKPRESSURE, "backpressure=%s"},
+    {PROXYFS_OPT_BACKPRESSURE_TIMEOUT_US, "backpressure_timeout_us=%u"},
+    {PROXYFS_OPT_SAMPLE_RATE, "sample_rate=%u"},
+    {PROXYFS_OPT_ERR, NULL}
+};
+
+//
+// Parse mount options: `<lowerdir>[,backpressure=<policy>][,...]`, the
+// lower directory can be given by `lowerdir=` option as well
+//
+// Note: `backpressure=block` waits for the buffers drained by the queue
+//       workers, if the queues are disabled (`queue_records=0`) it drops
+//       the event at once like `drop_newest` does
+static int proxyfs_parse_options(char *options,
+                                 char **lower_path,
+                                 struct proxyfs_backpressure *bp)
+{
+    substring_t args[MAX_OPT_ARGS];
+    char *option;
+    char *name;
+    int value;
+    int res = 0;
+
+    *lower_path = NULL;
+    while (res == 0 && (option = strsep(&options, ",")) != NULL) {
+        if (*option == '\0') {
+            continue;
+        }
+        switch (match_token(option, proxyfs_mount_tokens, args)) {
+        case PROXYFS_OPT_LOWERDIR:
+            *lower_path = args[0].from;
+            break;
+        case PROXYFS_OPT_BACKPRESSURE:
+            if ((name = match_strdup(&args[0])) == NULL) {
+                res = -ENOMEM;
+                break;
+            }
+            if ((value = proxyfs_backpressure_parse_policy(name)) < 0) {
+                pr_err("%s: unknown backpressure policy %s\n",
+                       MODULE_NAME,
+                       name);
+                res = -EINVAL;
+            } else {
+                bp->policy = value;
+            }
+            kfree(name);
+            break;
+        case PROXYFS_OPT_BACKPRESSURE_TIMEOUT_US:
+            if (match_int(&args[0], &value) != 0 || value < 0) {
+                res = -EINVAL;
+                break;
+            }
+            bp->timeout_us = value;
+            break;
+        case PROXYFS_OPT_SAMPLE_RATE:
+            if (match_int(&args[0], &value) != 0 || value <= 0) {
+                res = -EINVAL;
+                break;
+            }
+            bp->sample_rate = value;
+            break;
+        default:
+            //
+            // Note: bare option is the lower directory (legacy syntax)
+            if (strchr(option, '=') == NULL && *lower_path == NULL) {
+                *lower_path = option;
+                break;
+            }
+            pr_err("%s: unknown mount option %s\n",
+                   MODULE_NAME,
+                   option);
+            res = -EINVAL;
+            break;
+        }
+    }
+    if (res == 0 && *lower_path == NULL) {
+        pr_err("%s: lowerdir is not specified\n",
+               MODULE_NAME);
+        res = -EINVAL;
+    }
+    return res;
+}
+
 int proxyfs_fill_super_block(struct super_block *sb,
                              void *data,
                              int silent)
@@ -11,8 +106,19 @@ int proxyfs_fill_super_block(struct super_block *sb,
     struct super_block *lower_sb;
     struct inode *inode;
     struct inode *lower_inode;
-    char *lower_path = (char *)data;
+    struct proxyfs_sb_info *sb_info;
+    char *lower_path;
     struct path lower_root;
+    int res;
+
+    if ((sb_info = kzalloc(sizeof(struct proxyfs_sb_info), GFP_KERNEL)) == NULL) {
+        return -ENOMEM;
+    }
+    proxyfs_backpressure_init(&sb_info->backpressure);
+    if ((res = proxyfs_parse_options((char *)data, &lower_path, &sb_info->backpressure)) != 0) {
+        kfree(sb_info);
+        return res;
+    }
 
     // Looking for root node of underlying FS
     if (kern_path(lower_path, LOOKUP_FOLLOW, &lower_root)) {
@@ -20,13 +126,19 @@ int proxyfs_fill_super_block(struct super_block *sb,
                MODULE_NAME,
                __FUNCTION__,
                lower_path);
+        kfree(sb_info);
         return -ENOENT;
     }
     lower_sb = lower_root.dentry->d_sb;
+    if ((sb_info->stats = proxyfs_stats_alloc()) == NULL) {
+        path_put(&lower_root);
+        kfree(sb_info);
+        return -ENOMEM;
+    }
 
     // Safe lower super block
-    sb->s_fs_info = kmalloc(sizeof(struct proxyfs_sb_info), GFP_KERNEL);
-    ((struct proxyfs_sb_info *)sb->s_fs_info)->lower_sb = lower_sb;
+    sb_info->lower_sb = lower_sb;
+    sb->s_fs_info = sb_info;
     sb->s_magic = PROXYFS_MAGIC;
     sb->s_op = &proxyfs_super_ops;
     sb->s_flags = lower_sb->s_flags;
@@ -44,6 +156,10 @@ int proxyfs_fill_super_block(struct super_block *sb,
     ((struct proxyfs_inode *)inode)->lower_inode = lower_inode;
     sb->s_root = d_make_root(inode);
     proxyfs_init_dentry_ops(sb->s_root);
+    if (sb->s_root == NULL) {
+        return -ENOMEM;
+    }
+    proxyfs_procfs_mount_create(sb);
 
-    return sb->s_root ? 0 : -ENOMEM;
+    return 0;
 }
@@ -10,7 +10,7 @@
 // alloc_inode()
 static struct inode *proxyfs_alloc_inode(struct super_block *sb)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_ALLOC_INODE);
     if (sb == NULL) {
         return NULL;
     }
@@ -26,14 +26,16 @@ static struct inode *proxyfs_alloc_inode(struct super_block *sb)
 // destroy_inode()
 static void proxyfs_destroy_inode(struct inode *inode)
 {
-    PROXYFS_DEBUG("\n");
     if (inode == NULL) {
         return;
     }
+    PROXYFS_STATS(inode->i_sb, SUPER_DESTROY_INODE);
+    PROXYFS_STATS_ARGS(inode, 0, 0, 0);
     struct proxyfs_inode *proxyfs_inode = container_of(inode, struct proxyfs_inode, vfs_inode);
+    proxyfs_perm_cache_invalidate(inode);
     if (proxyfs_inode->lower_inode) {
         // Decrement of refcount of underlying FS's inode (or even release it at all)
-        iput(proxyfs_inode->lower_inode);
+        PROXYFS_STATS_LOWER_VOID(iput(proxyfs_inode->lower_inode));
         proxyfs_inode->lower_inode = NULL;
     }
     kfree(proxyfs_inode);
@@ -42,7 +44,6 @@ static void proxyfs_destroy_inode(struct inode *inode)
 // free_inode()
 static void proxyfs_free_inode(struct inode *inode)
 {
-    PROXYFS_DEBUG("\n");
     if (inode == NULL) {
         return;
     }
@@ -60,10 +61,11 @@ static void proxyfs_free_inode(struct inode *inode)
 static void proxyfs_dirty_inode(struct inode *inode,
                                 int flags)
 {
-    PROXYFS_DEBUG("flags=%d\n", flags);
+    PROXYFS_STATS(inode->i_sb, SUPER_DIRTY_INODE);
+    PROXYFS_STATS_ARGS(inode, 0, 0, flags);
     struct super_block *lower_sb = proxyfs_lower_sb(inode->i_sb);
     if (lower_sb->s_op && lower_sb->s_op->dirty_inode) {
-        lower_sb->s_op->dirty_inode(inode, flags);
+        PROXYFS_STATS_LOWER_VOID(lower_sb->s_op->dirty_inode(inode, flags));
     }
 }
 
@@ -71,10 +73,11 @@ static void proxyfs_dirty_inode(struct inode *inode,
 static int proxyfs_write_inode(struct inode *inode,
                                struct writeback_control *wbc)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(inode->i_sb, SUPER_WRITE_INODE);
+    PROXYFS_STATS_ARGS(inode, 0, 0, wbc->sync_mode);
     struct super_block *lower_sb = proxyfs_lower_sb(inode->i_sb);
     if (lower_sb->s_op && lower_sb->s_op->write_inode) {
-        return lower_sb->s_op->write_inode(inode, wbc);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->write_inode(inode, wbc));
     }
     return 0;
 }
@@ -82,10 +85,11 @@ static int proxyfs_write_inode(struct inode *inode,
 // drop_inode()
 static int proxyfs_drop_inode(struct inode *inode)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(inode->i_sb, SUPER_DROP_INODE);
+    PROXYFS_STATS_ARGS(inode, 0, 0, 0);
     struct super_block *lower_sb = proxyfs_lower_sb(inode->i_sb);
     if (lower_sb->s_op && lower_sb->s_op->drop_inode) {
-        return lower_sb->s_op->drop_inode(inode);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->drop_inode(inode));
     }
     return 0;
 }
@@ -93,20 +97,21 @@ static int proxyfs_drop_inode(struct inode *inode)
 // evict_inode()
 static void proxyfs_evict_inode(struct inode *inode)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(inode->i_sb, SUPER_EVICT_INODE);
+    PROXYFS_STATS_ARGS(inode, 0, 0, 0);
     struct super_block *lower_sb = proxyfs_lower_sb(inode->i_sb);
     if (lower_sb->s_op && lower_sb->s_op->evict_inode) {
-        lower_sb->s_op->evict_inode(inode);
+        PROXYFS_STATS_LOWER_VOID(lower_sb->s_op->evict_inode(inode));
     }
 }
 
 // put_super()
 static void proxyfs_put_super(struct super_block *sb)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_PUT_SUPER);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->put_super) {
-        lower_sb->s_op->put_super(lower_sb);
+        PROXYFS_STATS_LOWER_VOID(lower_sb->s_op->put_super(lower_sb));
     }
 }
 
@@ -114,10 +119,11 @@ static void proxyfs_put_super(struct super_block *sb)
 static int proxyfs_sync_fs(struct super_block *sb,
                            int wait)
 {
-    PROXYFS_DEBUG("wait=%d\n", wait);
+    PROXYFS_STATS(sb, SUPER_SYNC_FS);
+    PROXYFS_STATS_ARGS(NULL, 0, 0, wait);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->sync_fs) {
-        return lower_sb->s_op->sync_fs(lower_sb, wait);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->sync_fs(lower_sb, wait));
     }
     return 0;
 }
@@ -126,10 +132,11 @@ static int proxyfs_sync_fs(struct super_block *sb,
 static int proxyfs_freeze_super(struct super_block *sb,
                                 enum freeze_holder who)
 {
-    PROXYFS_DEBUG("who=%d\n", who);
+    PROXYFS_STATS(sb, SUPER_FREEZE_SUPER);
+    PROXYFS_STATS_ARGS(NULL, 0, 0, who);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->freeze_super) {
-        return lower_sb->s_op->freeze_super(lower_sb, who);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->freeze_super(lower_sb, who));
     }
     return 0;
 }
@@ -137,10 +144,10 @@ static int proxyfs_freeze_super(struct super_block *sb,
 // freeze_fs()
 static int proxyfs_freeze_fs(struct super_block *sb)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_FREEZE_FS);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->freeze_fs) {
-        return lower_sb->s_op->freeze_fs(lower_sb);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->freeze_fs(lower_sb));
     }
     return 0;
 }
@@ -149,10 +156,11 @@ static int proxyfs_freeze_fs(struct super_block *sb)
 static int proxyfs_thaw_super(struct super_block *sb,
                               enum freeze_holder who)
 {
-    PROXYFS_DEBUG("who=%d\n", who);
+    PROXYFS_STATS(sb, SUPER_THAW_SUPER);
+    PROXYFS_STATS_ARGS(NULL, 0, 0, who);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->thaw_super) {
-        return lower_sb->s_op->thaw_super(lower_sb, who);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->thaw_super(lower_sb, who));
     }
     return 0;
 }
@@ -160,10 +168,10 @@ static int proxyfs_thaw_super(struct super_block *sb,
 // unfreeze_fs()
 static int proxyfs_unfreeze_fs(struct super_block *sb)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_UNFREEZE_FS);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->unfreeze_fs) {
-        return lower_sb->s_op->unfreeze_fs(lower_sb);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->unfreeze_fs(lower_sb));
     }
     return 0;
 }
@@ -172,10 +180,12 @@ static int proxyfs_unfreeze_fs(struct super_block *sb)
 static int proxyfs_statfs(struct dentry *dentry,
                           struct kstatfs *buf)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(dentry->d_sb, SUPER_STATFS);
+    PROXYFS_STATS_ARGS(d_inode(dentry), 0, 0, 0);
+    PROXYFS_STATS_PATH(dentry);
     struct super_block *lower_sb = proxyfs_lower_sb(dentry->d_sb);
     if (lower_sb->s_op && lower_sb->s_op->statfs) {
-        return lower_sb->s_op->statfs(dentry, buf);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->statfs(dentry, buf));
     }
     return -EOPNOTSUPP;
 }
@@ -185,10 +195,11 @@ static int proxyfs_remount_fs(struct super_block *sb,
                               int *flags,
                               char *data)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_REMOUNT_FS);
+    PROXYFS_STATS_ARGS(NULL, 0, 0, *flags);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->remount_fs) {
-        return lower_sb->s_op->remount_fs(lower_sb, flags, data);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->remount_fs(lower_sb, flags, data));
     }
     return -EOPNOTSUPP;
 }
@@ -196,10 +207,10 @@ static int proxyfs_remount_fs(struct super_block *sb,
 // umount_begin()
 static void proxyfs_umount_begin(struct super_block *sb)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_UMOUNT_BEGIN);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->umount_begin) {
-        lower_sb->s_op->umount_begin(lower_sb);
+        PROXYFS_STATS_LOWER_VOID(lower_sb->s_op->umount_begin(lower_sb));
     }
 }
 
@@ -211,10 +222,11 @@ static ssize_t proxyfs_quota_read(struct super_block *sb,
                                   size_t len,
                                   loff_t off)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_QUOTA_READ);
+    PROXYFS_STATS_ARGS(NULL, off, len, type);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->quota_read) {
-        return lower_sb->s_op->quota_read(lower_sb, type, data, len, off);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->quota_read(lower_sb, type, data, len, off));
     }
     return -EOPNOTSUPP;
 }
@@ -226,10 +238,11 @@ static ssize_t proxyfs_quota_write(struct super_block *sb,
                                    size_t len,
                                    loff_t off)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_QUOTA_WRITE);
+    PROXYFS_STATS_ARGS(NULL, off, len, type);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->quota_write) {
-        return lower_sb->s_op->quota_write(lower_sb, type, data, len, off);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->quota_write(lower_sb, type, data, len, off));
     }
     return -EOPNOTSUPP;
 }
@@ -237,10 +250,11 @@ static ssize_t proxyfs_quota_write(struct super_block *sb,
 // get_dquots()
 static struct dquot __rcu **proxyfs_get_dquots(struct inode *inode)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(inode->i_sb, SUPER_GET_DQUOTS);
+    PROXYFS_STATS_ARGS(inode, 0, 0, 0);
     struct super_block *lower_sb = proxyfs_lower_sb(inode->i_sb);
     if (lower_sb->s_op && lower_sb->s_op->get_dquots) {
-        return lower_sb->s_op->get_dquots(inode);
+        return PROXYFS_STATS_LOWER_PTR(lower_sb->s_op->get_dquots(inode));
     }
     return NULL;
 }
@@ -250,10 +264,11 @@ static struct dquot __rcu **proxyfs_get_dquots(struct inode *inode)
 static long proxyfs_nr_cached_objects(struct super_block *sb,
                                       struct shrink_control *sc)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_NR_CACHED_OBJECTS);
+    PROXYFS_STATS_ARGS(NULL, 0, sc->nr_to_scan, 0);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->nr_cached_objects) {
-        return lower_sb->s_op->nr_cached_objects(lower_sb, sc);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->nr_cached_objects(lower_sb, sc));
     }
     return 0;
 }
@@ -262,10 +277,11 @@ static long proxyfs_nr_cached_objects(struct super_block *sb,
 static long proxyfs_free_cached_objects(struct super_block *sb,
                                         struct shrink_control *sc)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_FREE_CACHED_OBJECTS);
+    PROXYFS_STATS_ARGS(NULL, 0, sc->nr_to_scan, 0);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->free_cached_objects) {
-        return lower_sb->s_op->free_cached_objects(lower_sb, sc);
+        return PROXYFS_STATS_LOWER(lower_sb->s_op->free_cached_objects(lower_sb, sc));
     }
     return 0;
 }
@@ -273,10 +289,10 @@ static long proxyfs_free_cached_objects(struct super_block *sb,
 // shutdown()
 static void proxyfs_shutdown(struct super_block *sb)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(sb, SUPER_SHUTDOWN);
     struct super_block *lower_sb = proxyfs_lower_sb(sb);
     if (lower_sb->s_op && lower_sb->s_op->shutdown) {
-        lower_sb->s_op->shutdown(lower_sb);
+        PROXYFS_STATS_LOWER_VOID(lower_sb->s_op->shutdown(lower_sb));
     }
 }
 
@@ -284,8 +300,9 @@ static void proxyfs_shutdown(struct super_block *sb)
 static int proxyfs_show_options(struct seq_file *seq,
                                 struct dentry *root)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(root->d_sb, SUPER_SHOW_OPTIONS);
     seq_printf(seq, ",proxyfs=1");
+    proxyfs_backpressure_show_options(seq, proxyfs_sb_backpressure(root->d_sb));
     return 0;
 }
 
@@ -293,7 +310,7 @@ static int proxyfs_show_options(struct seq_file *seq,
 static int proxyfs_show_devname(struct seq_file *seq,
                                 struct dentry *root)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(root->d_sb, SUPER_SHOW_DEVNAME);
     seq_printf(seq, "proxyfs");
     return 0;
 }
@@ -302,7 +319,7 @@ static int proxyfs_show_devname(struct seq_file *seq,
 static int proxyfs_show_path(struct seq_file *seq,
                              struct dentry *root)
 {
-    PROXYFS_DEBUG("\n");
+    PROXYFS_STATS(root->d_sb, SUPER_SHOW_PATH);
     seq_printf(seq, "/ (via proxyfs)");
     return 0;
 }
@@ -310,8 +327,10 @@ static int proxyfs_show_path(struct seq_file *seq,
 // show_stats()
 static int proxyfs_show_stats(struct seq_file *seq, struct dentry *root)
 {
-    PROXYFS_DEBUG("\n");
-    seq_printf(seq, "ProxyFS statistics: (no real stats, proxy only)\n");
+    PROXYFS_STATS(root->d_sb, SUPER_SHOW_STATS);
+    seq_printf(seq, "ProxyFS statistics: ");
+    proxyfs_backpressure_show_stats(seq, proxyfs_sb_backpressure(root->d_sb));
+    proxyfs_stats_show_summary(seq, proxyfs_sb_stats(root->d_sb));
     return 0;
 }
 
@@ -0,0 +1,423 @@
+// File		:proxyfs-top.c
+// Author	:Victor Kovalevich
+// Created	:Sat Oct 17 03:51:26 2026
+#include <linux/percpu.h>
+#include <linux/slab.h>
+#include <linux/hash.h>
+#include <linux/sort.h>
+#include <linux/sched.h>
+#include <linux/seq_file.h>
+#include <linux/dcache.h>
+#include <linux/jiffies.h>
+#include "proxyfs.h"
+
+//
+// Heavy hitters tracked, every kind has a sketch of its own:
+//   X(NAME, name, pids, bytes)
+// where `pids` tells if the keys are processes (files otherwise) and
+// `bytes` if the calls are weighted by the bytes transferred
+#define PROXYFS_TOP_KINDS(X)                    \
+    X(FILE_OPS,   files_by_ops,   false, false) \
+    X(FILE_BYTES, files_by_bytes, false, true)  \
+    X(PID_OPS,    pids_by_ops,    true,  false) \
+    X(PID_BYTES,  pids_by_bytes,  true,  true)
+
+enum proxyfs_top_kind {
+#define PROXYFS_TOP_KIND_ENUM(NAME, name, pids, bytes) PROXYFS_TOP_##NAME,
+    PROXYFS_TOP_KINDS(PROXYFS_TOP_KIND_ENUM)
+#undef PROXYFS_TOP_KIND_ENUM
+    PROXYFS_TOP_KIND_COUNT
+};
+
+//
+// Counter of a key (file: device and inode numbers, process: TGID and
+// 0), `error` bounds the overestimation of `count` (Space-Saving)
+struct proxyfs_top_entry {
+    struct hlist_node node;
+    u64 id;
+    u32 dev;
+    u32 heap;
+    u64 count;
+    u64 error;
+    char name[PROXYFS_TOP_NAME_LEN];
+};
+
+//
+// Space-Saving sketch of a window: a key missing from the full sketch
+// replaces the entry of the smallest count (the root of the min-heap)
+// and inherits that count as its error
+struct proxyfs_top_sketch {
+    unsigned long window;
+    unsigned int used;
+    u16 heap[PROXYFS_TOP_SLOTS];
+    struct hlist_head buckets[1U << PROXYFS_TOP_HASH_BITS];
+    struct proxyfs_top_entry entries[PROXYFS_TOP_SLOTS];
+};
+
+//
+// Sketches of a CPU for the current and the previous windows (indexed
+// by the parity of the window), a sketch left from an older window is
+// reset when it is reused (a zeroed one is empty whatever its window is)
+//
+// Note: the sketches are updated with preemption disabled, thus no lock
+//       is taken; readers may see torn entries of the other CPUs
+struct proxyfs_top_cpu {
+    struct proxyfs_top_sketch sketches[2][PROXYFS_TOP_KIND_COUNT];
+};
+
+static struct {
+    unsigned long window_jiffies;
+    unsigned int window_s;
+} proxyfs_top;
+
+static DEFINE_PER_CPU(struct proxyfs_top_cpu *, proxyfs_top_cpus);
+
+static const char *const proxyfs_top_kind_names[PROXYFS_TOP_KIND_COUNT] = {
+#define PROXYFS_TOP_KIND_NAME(NAME, name, pids, bytes) [PROXYFS_TOP_##NAME] = #name,
+    PROXYFS_TOP_KINDS(PROXYFS_TOP_KIND_NAME)
+#undef PROXYFS_TOP_KIND_NAME
+};
+
+static const bool proxyfs_top_kind_pids[PROXYFS_TOP_KIND_COUNT] = {
+#define PROXYFS_TOP_KIND_PIDS(NAME, name, pids, bytes) [PROXYFS_TOP_##NAME] = pids,
+    PROXYFS_TOP_KINDS(PROXYFS_TOP_KIND_PIDS)
+#undef PROXYFS_TOP_KIND_PIDS
+};
+
+static const bool proxyfs_top_kind_bytes[PROXYFS_TOP_KIND_COUNT] = {
+#define PROXYFS_TOP_KIND_BYTES(NAME, name, pids, bytes) [PROXYFS_TOP_##NAME] = bytes,
+    PROXYFS_TOP_KINDS(PROXYFS_TOP_KIND_BYTES)
+#undef PROXYFS_TOP_KIND_BYTES
+};
+
+static void proxyfs_top_heap_swap(struct proxyfs_top_sketch *sketch,
+                                  unsigned int a,
+                                  unsigned int b)
+{
+    swap(sketch->heap[a], sketch->heap[b]);
+    sketch->entries[sketch->heap[a]].heap = a;
+    sketch->entries[sketch->heap[b]].heap = b;
+}
+
+static u64 proxyfs_top_heap_count(const struct proxyfs_top_sketch *sketch,
+                                  unsigned int pos)
+{
+    return sketch->entries[sketch->heap[pos]].count;
+}
+
+static void proxyfs_top_heap_up(struct proxyfs_top_sketch *sketch,
+                                unsigned int pos)
+{
+    while (pos > 0 &&
+           proxyfs_top_heap_count(sketch, (pos - 1) / 2) > proxyfs_top_heap_count(sketch, pos)) {
+        proxyfs_top_heap_swap(sketch, pos, (pos - 1) / 2);
+        pos = (pos - 1) / 2;
+    }
+}
+
+static void proxyfs_top_heap_down(struct proxyfs_top_sketch *sketch,
+                                  unsigned int pos)
+{
+    unsigned int child;
+
+    while ((child = 2 * pos + 1) < sketch->used) {
+        if (child + 1 < sketch->used &&
+            proxyfs_top_heap_count(sketch, child + 1) < proxyfs_top_heap_count(sketch, child)) {
+            child++;
+        }
+        if (proxyfs_top_heap_count(sketch, pos) <= proxyfs_top_heap_count(sketch, child)) {
+            break;
+        }
+        proxyfs_top_heap_swap(sketch, pos, child);
+        pos = child;
+    }
+}
+
+static void proxyfs_top_name(char *name,
+                             const struct dentry *dentry,
+                             bool pids)
+{
+    if (pids) {
+        strscpy(name, current->comm, PROXYFS_TOP_NAME_LEN);
+        return;
+    }
+    if (dentry == NULL) {
+        strscpy(name, "?", PROXYFS_TOP_NAME_LEN);
+        return;
+    }
+    //
+    // Note: the name of a dentry being renamed is freed after a grace
+    //       period, thus it may be copied torn but never from freed memory
+    rcu_read_lock();
+    strscpy(name, READ_ONCE(dentry->d_name.name), PROXYFS_TOP_NAME_LEN);
+    rcu_read_unlock();
+}
+
+static void proxyfs_top_update(struct proxyfs_top_sketch *sketch,
+                               unsigned long window,
+                               u64 id,
+                               u32 dev,
+                               u64 weight,
+                               const struct dentry *dentry,
+                               bool pids)
+{
+    struct hlist_head *bucket;
+    struct proxyfs_top_entry *entry;
+    unsigned int idx;
+
+    if (sketch->window != window) {
+        sketch->window = window;
+        sketch->used = 0;
+        memset(sketch->buckets, 0, sizeof(sketch->buckets));
+    }
+    bucket = &sketch->buckets[hash_64(id ^ ((u64)dev << 40), PROXYFS_TOP_HASH_BITS)];
+    hlist_for_each_entry(entry, bucket, node) {
+        if (entry->id == id && entry->dev == dev) {
+            entry->count += weight;
+            proxyfs_top_heap_down(sketch, entry->heap);
+            return;
+        }
+    }
+    if (sketch->used < PROXYFS_TOP_SLOTS) {
+        idx = sketch->used++;
+        entry = &sketch->entries[idx];
+        entry->count = weight;
+        entry->error = 0;
+        entry->heap = idx;
+        sketch->heap[idx] = idx;
+        proxyfs_top_heap_up(sketch, idx);
+    } else {
+        entry = &sketch->entries[sketch->heap[0]];
+        hlist_del(&entry->node);
+        entry->error = entry->count;
+        entry->count += weight;
+        proxyfs_top_heap_down(sketch, 0);
+    }
+    entry->id = id;
+    entry->dev = dev;
+    proxyfs_top_name(entry->name, dentry, pids);
+    hlist_add_head(&entry->node, bucket);
+}
+
+//
+// Account a call on the file (`bytes` transferred) to the heavy hitters
+// of the current window, that costs a hash lookup and a heap fix up per
+// sketch
+void proxyfs_top_account(const struct dentry *dentry,
+                         const struct inode *inode,
+                         size_t bytes)
+{
+    struct proxyfs_top_cpu *top_cpu;
+    unsigned long window_jiffies = READ_ONCE(proxyfs_top.window_jiffies);
+    unsigned long window;
+    u64 id;
+    u32 dev;
+    int kind;
+
+    if (inode == NULL || window_jiffies == 0) {
+        return;
+    }
+    window = jiffies / window_jiffies;
+    preempt_disable();
+    if ((top_cpu = this_cpu_read(proxyfs_top_cpus)) != NULL) {
+        for (kind = 0; kind < PROXYFS_TOP_KIND_COUNT; kind++) {
+            if (proxyfs_top_kind_bytes[kind] && bytes == 0) {
+                continue;
+            }
+            if (proxyfs_top_kind_pids[kind]) {
+                id = task_tgid_nr(current);
+                dev = 0;
+            } else {
+                id = inode->i_ino;
+                dev = new_encode_dev(inode->i_sb->s_dev);
+            }
+            proxyfs_top_update(&top_cpu->sketches[window & 1][kind],
+                               window,
+                               id,
+                               dev,
+                               proxyfs_top_kind_bytes[kind] ? bytes : 1,
+                               dentry,
+                               proxyfs_top_kind_pids[kind]);
+        }
+    }
+    preempt_enable();
+}
+
+int proxyfs_top_init(const struct proxyfs_top_config *config)
+{
+    struct proxyfs_top_cpu *top_cpu;
+    int cpu;
+
+    if (config->window_s == 0) {
+        pr_info("%s: heavy hitters tracker is disabled\n",
+                MODULE_NAME);
+        return 0;
+    }
+    for_each_possible_cpu(cpu) {
+        if ((top_cpu = kvzalloc_node(sizeof(struct proxyfs_top_cpu),
+                                     GFP_KERNEL,
+                                     cpu_to_node(cpu))) == NULL) {
+            pr_err("%s: unable to create heavy hitters sketches of CPU %d\n",
+                   MODULE_NAME,
+                   cpu);
+            proxyfs_top_release();
+            return -ENOMEM;
+        }
+        per_cpu(proxyfs_top_cpus, cpu) = top_cpu;
+    }
+    proxyfs_top.window_s = config->window_s;
+    proxyfs_top.window_jiffies = config->window_s * HZ;
+    pr_info("%s: heavy hitters tracker with %u slots per sketch is ready for use (window %u s)\n",
+            MODULE_NAME,
+            PROXYFS_TOP_SLOTS,
+            config->window_s);
+    return 0;
+}
+
+//
+// Note: must be called when no mount is left
+void proxyfs_top_release(void)
+{
+    int cpu;
+
+    WRITE_ONCE(proxyfs_top.window_jiffies, 0);
+    //
+    // Sketches are updated with preemption disabled, thus nobody touches
+    // them after the grace period
+    synchronize_rcu();
+    for_each_possible_cpu(cpu) {
+        kvfree(per_cpu(proxyfs_top_cpus, cpu));
+        per_cpu(proxyfs_top_cpus, cpu) = NULL;
+    }
+}
+
+static int proxyfs_top_cmp_key(const void *a, const void *b)
+{
+    const struct proxyfs_top_entry *x = a;
+    const struct proxyfs_top_entry *y = b;
+
+    if (x->dev != y->dev) {
+        return x->dev < y->dev ? -1 : 1;
+    }
+    if (x->id != y->id) {
+        return x->id < y->id ? -1 : 1;
+    }
+    return 0;
+}
+
+static int proxyfs_top_cmp_count(const void *a, const void *b)
+{
+    const struct proxyfs_top_entry *x = a;
+    const struct proxyfs_top_entry *y = b;
+
+    if (x->count != y->count) {
+        return x->count > y->count ? -1 : 1;
+    }
+    return 0;
+}
+
+//
+// Merge the sketches of the kind and window of all the CPUs to `entries`
+// (sorted by count, descending), number of the entries is returned
+static unsigned int proxyfs_top_merge(struct proxyfs_top_entry *entries,
+                                      int kind,
+                                      unsigned long window)
+{
+    const struct proxyfs_top_sketch *sketch;
+    struct proxyfs_top_cpu *top_cpu;
+    unsigned int count = 0;
+    unsigned int used;
+    unsigned int i;
+    unsigned int j;
+    int cpu;
+
+    for_each_possible_cpu(cpu) {
+        if ((top_cpu = per_cpu(proxyfs_top_cpus, cpu)) == NULL) {
+            continue;
+        }
+        sketch = &top_cpu->sketches[window & 1][kind];
+        if (READ_ONCE(sketch->window) != window) {
+            continue;
+        }
+        used = min_t(unsigned int, READ_ONCE(sketch->used), PROXYFS_TOP_SLOTS);
+        for (i = 0; i < used; i++) {
+            entries[count++] = sketch->entries[i];
+        }
+    }
+    if (count == 0) {
+        return 0;
+    }
+    //
+    // Counts (and errors) of a key tracked by several CPUs are summed
+    sort(entries, count, sizeof(*entries), proxyfs_top_cmp_key, NULL);
+    for (i = 0, j = 1; j < count; j++) {
+        if (proxyfs_top_cmp_key(&entries[i], &entries[j]) == 0) {
+            entries[i].count += entries[j].count;
+            entries[i].error += entries[j].error;
+        } else {
+            entries[++i] = entries[j];
+        }
+    }
+    count = i + 1;
+    sort(entries, count, sizeof(*entries), proxyfs_top_cmp_count, NULL);
+    return count;
+}
+
+static void proxyfs_top_show_window(struct seq_file *m,
+                                    struct proxyfs_top_entry *entries,
+                                    int kind,
+                                    unsigned long window,
+                                    const char *title)
+{
+    unsigned int count = proxyfs_top_merge(entries, kind, window);
+    unsigned int i;
+
+    seq_printf(m, "%s (%s window):\n", proxyfs_top_kind_names[kind], title);
+    for (i = 0; i < min_t(unsigned int, count, PROXYFS_TOP_N); i++) {
+        if (proxyfs_top_kind_pids[kind]) {
+            seq_printf(m, "\t%-8llu %-16s %llu (+-%llu)\n",
+                       entries[i].id,
+                       entries[i].name,
+                       entries[i].count,
+                       entries[i].error);
+        } else {
+            seq_printf(m, "\t%u:%u %-12llu %-32s %llu (+-%llu)\n",
+                       MAJOR(new_decode_dev(entries[i].dev)),
+                       MINOR(new_decode_dev(entries[i].dev)),
+                       entries[i].id,
+                       entries[i].name,
+                       entries[i].count,
+                       entries[i].error);
+        }
+    }
+}
+
+//
+// Top files and processes by calls and by bytes of the previous (full)
+// window and of the current one, a count may be overestimated by the
+// error shown
+void proxyfs_top_show(struct seq_file *m)
+{
+    struct proxyfs_top_entry *entries;
+    unsigned long window_jiffies = READ_ONCE(proxyfs_top.window_jiffies);
+    unsigned long window;
+    int kind;
+
+    if (window_jiffies == 0) {
+        seq_printf(m, "heavy hitters tracker is disabled\n");
+        return;
+    }
+    if ((entries = kvmalloc_array(array_size(num_possible_cpus(), PROXYFS_TOP_SLOTS),
+                                  sizeof(struct proxyfs_top_entry),
+                                  GFP_KERNEL)) == NULL) {
+        return;
+    }
+    window = jiffies / window_jiffies;
+    seq_printf(m, "window: %u s\n", proxyfs_top.window_s);
+    for (kind = 0; kind < PROXYFS_TOP_KIND_COUNT; kind++) {
+        seq_printf(m, "\n");
+        proxyfs_top_show_window(m, entries, kind, window - 1, "previous");
+        proxyfs_top_show_window(m, entries, kind, window, "current");
+    }
+    kvfree(entries);
+}
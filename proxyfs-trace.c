@@ -0,0 +1,42 @@
+// File		:proxyfs-trace.c
+// Author	:Victor Kovalevich
+// Created	:Sat Oct 17 01:41:57 2026
+#include "proxyfs.h"
+
+#define CREATE_TRACE_POINTS
+#include "proxyfs-trace.h"
+
+//
+// Enabled while any tracepoint of the operations is enabled
+DEFINE_STATIC_KEY_FALSE(proxyfs_trace_ops_active);
+
+int proxyfs_trace_op_reg(void)
+{
+    static_branch_inc(&proxyfs_trace_ops_active);
+    return 0;
+}
+
+void proxyfs_trace_op_unreg(void)
+{
+    static_branch_dec(&proxyfs_trace_ops_active);
+}
+
+//
+// Report the call timed to the tracepoint of its operation, every
+// tracepoint is a static key NOP while it is disabled
+//
+// Note: called only while `proxyfs_trace_ops_active` is enabled
+void proxyfs_trace_op(const struct proxyfs_stats_timer *timer,
+                      u64 latency_ns)
+{
+    switch (timer->op) {
+#define PROXYFS_TRACE_OP_CASE(NAME, name)               \
+    case PROXYFS_STATS_OP_##NAME:                       \
+        trace_proxyfs_##name(timer, latency_ns);        \
+        break;
+    PROXYFS_STATS_OPS(PROXYFS_TRACE_OP_CASE)
+#undef PROXYFS_TRACE_OP_CASE
+    default:
+        break;
+    }
+}
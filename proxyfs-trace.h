@@ -0,0 +1,136 @@
+// File		:proxyfs-trace.h
+// Author	:Victor Kovalevich
+// Created	:Sat Oct 17 01:34:06 2026
+#undef TRACE_SYSTEM
+#define TRACE_SYSTEM proxyfs
+
+#if !defined(__PROXYFS_TRACE_H__) || defined(TRACE_HEADER_MULTI_READ)
+#define __PROXYFS_TRACE_H__
+
+#include <linux/tracepoint.h>
+#include "proxyfs.h"
+
+//
+// Call of an operation of the file, inode, address space or super block
+// table, reported when the handler returns (see `PROXYFS_STATS()`)
+//
+// Note: `ret` is the result of the lower FS call (0 if there is none)
+DECLARE_EVENT_CLASS(proxyfs_op_class,
+    TP_PROTO(const struct proxyfs_stats_timer *timer, u64 latency_ns),
+    TP_ARGS(timer, latency_ns),
+    TP_STRUCT__entry(
+        __field(dev_t, dev)
+        __field(u64, ino)
+        __field(u64, offset)
+        __field(u64, count)
+        __field(u32, flags)
+        __field(long, ret)
+        __field(u64, latency_ns)
+        __field(u64, lower_ns)
+    ),
+    TP_fast_assign(
+        __entry->dev = timer->dev;
+        __entry->ino = timer->ino;
+        __entry->offset = timer->offset;
+        __entry->count = timer->count;
+        __entry->flags = timer->flags;
+        __entry->ret = timer->ret;
+        __entry->latency_ns = latency_ns;
+        __entry->lower_ns = timer->lower_ns;
+    ),
+    TP_printk("dev=%u:%u ino=%llu offset=%llu count=%llu flags=0x%x ret=%ld latency_ns=%llu lower_ns=%llu",
+              MAJOR(__entry->dev),
+              MINOR(__entry->dev),
+              __entry->ino,
+              __entry->offset,
+              __entry->count,
+              __entry->flags,
+              __entry->ret,
+              __entry->latency_ns,
+              __entry->lower_ns)
+);
+
+//
+// Note: enabling any of them enables `proxyfs_trace_ops_active` as well,
+//       thus the calls are not even passed to `proxyfs_trace_op()` while
+//       all of them are disabled
+#undef PROXYFS_TRACE_OP_EVENT
+#define PROXYFS_TRACE_OP_EVENT(NAME, name)                                    \
+    DEFINE_EVENT_FN(proxyfs_op_class, proxyfs_##name,                         \
+        TP_PROTO(const struct proxyfs_stats_timer *timer, u64 latency_ns),    \
+        TP_ARGS(timer, latency_ns),                                           \
+        proxyfs_trace_op_reg,                                                 \
+        proxyfs_trace_op_unreg);
+PROXYFS_STATS_OPS(PROXYFS_TRACE_OP_EVENT)
+
+//
+// Call of a dentry operation
+TRACE_EVENT(proxyfs_dentry_op,
+    TP_PROTO(const char *op, const struct dentry *dentry, const struct inode *inode, u32 flags),
+    TP_ARGS(op, dentry, inode, flags),
+    TP_STRUCT__entry(
+        __string(op, op)
+        __string(name, proxyfs_dentry_name(dentry))
+        __field(u64, ino)
+        __field(u32, flags)
+    ),
+    TP_fast_assign(
+        __assign_str(op);
+        __assign_str(name);
+        __entry->ino = INODE_ARG(inode);
+        __entry->flags = flags;
+    ),
+    TP_printk("op=%s name=%s ino=%llu flags=0x%x",
+              __get_str(op),
+              __get_str(name),
+              __entry->ino,
+              __entry->flags)
+);
+
+TRACE_EVENT(proxyfs_mount,
+    TP_PROTO(const char *options, int flags),
+    TP_ARGS(options, flags),
+    TP_STRUCT__entry(
+        __string(options, options ? options : "")
+        __field(int, flags)
+    ),
+    TP_fast_assign(
+        __assign_str(options);
+        __entry->flags = flags;
+    ),
+    TP_printk("options=%s flags=0x%x",
+              __get_str(options),
+              __entry->flags)
+);
+
+//
+// Message sent to the client and the subscribers of the multicast group
+TRACE_EVENT(proxyfs_send_msg,
+    TP_PROTO(size_t len, unsigned int group, bool listeners, bool client),
+    TP_ARGS(len, group, listeners, client),
+    TP_STRUCT__entry(
+        __field(size_t, len)
+        __field(unsigned int, group)
+        __field(bool, listeners)
+        __field(bool, client)
+    ),
+    TP_fast_assign(
+        __entry->len = len;
+        __entry->group = group;
+        __entry->listeners = listeners;
+        __entry->client = client;
+    ),
+    TP_printk("len=%zu group=%u listeners=%d client=%d",
+              __entry->len,
+              __entry->group,
+              __entry->listeners,
+              __entry->client)
+);
+
+#endif //  !__PROXYFS_TRACE_H__
+
+#undef TRACE_INCLUDE_PATH
+#define TRACE_INCLUDE_PATH .
+#undef TRACE_INCLUDE_FILE
+#define TRACE_INCLUDE_FILE proxyfs-trace
+#include <trace/define_trace.h>
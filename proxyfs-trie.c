@@ -0,0 +1,303 @@
+// File		:proxyfs-trie.c
+// Author	:Victor Kovalevich
+// Created	:Fri Oct 16 21:46:05 2026
+#include <linux/slab.h>
+#include <linux/mm.h>
+#include <linux/stringhash.h>
+#include <linux/overflow.h>
+#include "proxyfs.h"
+
+//
+// Node of the trie under construction, children are kept sorted by
+// (hash, name) thus they are copied to the flat trie as they are
+struct proxyfs_trie_build_node {
+    char *name;
+    u32 hash;
+    u8 verdict;
+    u32 count;
+    u32 capacity;
+    struct proxyfs_trie_build_node **children;
+};
+
+//
+// Flat trie: a node refers to the contiguous range of the edges to its
+// children (sorted by hash), names of the edges are NUL terminated and
+// stored in the pool
+struct proxyfs_trie_node {
+    u32 first_edge;
+    u32 edge_count;
+    u8 verdict;
+};
+
+struct proxyfs_trie_edge {
+    u32 hash;
+    u32 name;
+    u32 child;
+};
+
+struct proxyfs_trie {
+    u32 node_count;
+    u32 edge_count;
+    u32 max_depth;
+    struct proxyfs_trie_node *nodes;
+    struct proxyfs_trie_edge *edges;
+    char *pool;
+};
+
+static int proxyfs_trie_compare(const struct proxyfs_trie_build_node *node,
+                                u32 hash,
+                                const char *name,
+                                size_t len)
+{
+    int res;
+
+    if (node->hash != hash) {
+        return node->hash < hash ? -1 : 1;
+    }
+    if ((res = strncmp(node->name, name, len)) == 0 && node->name[len] != '\0') {
+        res = 1;
+    }
+    return res;
+}
+
+static struct proxyfs_trie_build_node *proxyfs_trie_child(struct proxyfs_trie_builder *builder,
+                                                         struct proxyfs_trie_build_node *node,
+                                                         const char *name,
+                                                         size_t len)
+{
+    struct proxyfs_trie_build_node **children;
+    struct proxyfs_trie_build_node *child;
+    u32 hash = full_name_hash(NULL, name, len);
+    u32 low = 0;
+    u32 high = node->count;
+    u32 mid;
+    int res;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if ((res = proxyfs_trie_compare(node->children[mid], hash, name, len)) == 0) {
+            return node->children[mid];
+        }
+        if (res < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    if (node->count == node->capacity) {
+        u32 capacity = node->capacity ? node->capacity * 2 : 4;
+
+        if ((children = krealloc_array(node->children, capacity, sizeof(*children), GFP_KERNEL)) == NULL) {
+            return NULL;
+        }
+        node->children = children;
+        node->capacity = capacity;
+    }
+    if ((child = kzalloc(sizeof(*child), GFP_KERNEL)) == NULL) {
+        return NULL;
+    }
+    if ((child->name = kstrndup(name, len, GFP_KERNEL)) == NULL) {
+        kfree(child);
+        return NULL;
+    }
+    child->hash = hash;
+    memmove(node->children + low + 1, node->children + low, (node->count - low) * sizeof(*children));
+    node->children[low] = child;
+    node->count++;
+    builder->node_count++;
+    builder->pool_size += len + 1;
+    return child;
+}
+
+int proxyfs_trie_builder_init(struct proxyfs_trie_builder *builder)
+{
+    memset(builder, 0, sizeof(*builder));
+    if ((builder->root = kzalloc(sizeof(struct proxyfs_trie_build_node), GFP_KERNEL)) == NULL) {
+        return -ENOMEM;
+    }
+    builder->node_count = 1;
+    return 0;
+}
+
+//
+// Add the prefix (path relative to the mount root), the deepest prefix
+// of a path decides (the later one wins for the same prefix)
+int proxyfs_trie_builder_add(struct proxyfs_trie_builder *builder,
+                             const char *path,
+                             u8 verdict)
+{
+    struct proxyfs_trie_build_node *node = builder->root;
+    unsigned int depth = 0;
+    size_t len;
+
+    while (*path != '\0') {
+        if (*path == '/') {
+            path++;
+            continue;
+        }
+        len = strchrnul(path, '/') - path;
+        if (++depth > PROXYFS_TRIE_DEPTH || len > NAME_MAX) {
+            return -ENAMETOOLONG;
+        }
+        if ((node = proxyfs_trie_child(builder, node, path, len)) == NULL) {
+            return -ENOMEM;
+        }
+        path += len;
+    }
+    node->verdict = verdict;
+    builder->max_depth = max(builder->max_depth, depth);
+    builder->count++;
+    return 0;
+}
+
+static void proxyfs_trie_build_node_free(struct proxyfs_trie_build_node *node)
+{
+    u32 i;
+
+    for (i = 0; i < node->count; i++) {
+        proxyfs_trie_build_node_free(node->children[i]);
+    }
+    kfree(node->children);
+    kfree(node->name);
+    kfree(node);
+}
+
+void proxyfs_trie_builder_destroy(struct proxyfs_trie_builder *builder)
+{
+    if (builder->root != NULL) {
+        proxyfs_trie_build_node_free(builder->root);
+        builder->root = NULL;
+    }
+}
+
+//
+// Copy the children of the node (already placed at `index`) to the flat
+// trie, the depth of the recursion is bounded by `PROXYFS_TRIE_DEPTH`
+static void proxyfs_trie_flatten(struct proxyfs_trie *trie,
+                                 const struct proxyfs_trie_build_node *node,
+                                 u32 index,
+                                 u32 *pool_pos)
+{
+    struct proxyfs_trie_node *flat = &trie->nodes[index];
+    u32 i;
+
+    flat->verdict = node->verdict;
+    flat->first_edge = trie->edge_count;
+    flat->edge_count = node->count;
+    trie->edge_count += node->count;
+    for (i = 0; i < node->count; i++) {
+        struct proxyfs_trie_edge *edge = &trie->edges[flat->first_edge + i];
+        size_t len = strlen(node->children[i]->name);
+
+        edge->hash = node->children[i]->hash;
+        edge->name = *pool_pos;
+        edge->child = trie->node_count++;
+        memcpy(trie->pool + *pool_pos, node->children[i]->name, len + 1);
+        *pool_pos += len + 1;
+    }
+    for (i = 0; i < node->count; i++) {
+        proxyfs_trie_flatten(trie, node->children[i], trie->edges[flat->first_edge + i].child, pool_pos);
+    }
+}
+
+//
+// Build the flat trie of the prefixes added, NULL is returned if there
+// are no prefixes, ERR_PTR() on failure
+struct proxyfs_trie *proxyfs_trie_build(struct proxyfs_trie_builder *builder)
+{
+    struct proxyfs_trie *trie;
+    size_t size = sizeof(struct proxyfs_trie);
+    u32 pool_pos = 0;
+
+    if (builder->count == 0) {
+        return NULL;
+    }
+    size = size_add(size, array_size(builder->node_count, sizeof(struct proxyfs_trie_node)));
+    size = size_add(size, array_size(builder->node_count, sizeof(struct proxyfs_trie_edge)));
+    size = size_add(size, builder->pool_size);
+    if ((trie = kvzalloc(size, GFP_KERNEL)) == NULL) {
+        return ERR_PTR(-ENOMEM);
+    }
+    trie->nodes = (struct proxyfs_trie_node *)(trie + 1);
+    trie->edges = (struct proxyfs_trie_edge *)(trie->nodes + builder->node_count);
+    trie->pool = (char *)(trie->edges + builder->node_count);
+    trie->max_depth = builder->max_depth;
+    trie->node_count = 1;
+    proxyfs_trie_flatten(trie, builder->root, 0, &pool_pos);
+    return trie;
+}
+
+void proxyfs_trie_free(struct proxyfs_trie *trie)
+{
+    kvfree(trie);
+}
+
+u32 proxyfs_trie_size(const struct proxyfs_trie *trie)
+{
+    return trie ? trie->node_count : 0;
+}
+
+//
+// Edge of the node to the child of the name, binary search by hash
+static const struct proxyfs_trie_edge *proxyfs_trie_find(const struct proxyfs_trie *trie,
+                                                         const struct proxyfs_trie_node *node,
+                                                         const char *name)
+{
+    const struct proxyfs_trie_edge *edges = trie->edges + node->first_edge;
+    u32 hash = full_name_hash(NULL, name, strlen(name));
+    u32 low = 0;
+    u32 high = node->edge_count;
+    u32 mid;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+        if (edges[mid].hash < hash) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    //
+    // Note: names of the same hash are adjacent
+    for (; low < node->edge_count && edges[low].hash == hash; low++) {
+        if (strcmp(trie->pool + edges[low].name, name) == 0) {
+            return &edges[low];
+        }
+    }
+    return NULL;
+}
+
+//
+// Verdict of the deepest prefix of the dentry path (relative to the
+// mount root), nothing is allocated and the dcache is not looked up
+// Note: must be called under RCU read lock
+u8 proxyfs_trie_match(const struct proxyfs_trie *trie,
+                      struct dentry *dentry)
+{
+    //
+    // Ancestors are visited from the dentry up to the root, the last
+    // `PROXYFS_TRIE_DEPTH` ones (nearest to the root) are kept
+    const char *names[PROXYFS_TRIE_DEPTH];
+    const struct proxyfs_trie_node *node = &trie->nodes[0];
+    const struct proxyfs_trie_edge *edge;
+    unsigned int depth = 0;
+    unsigned int i;
+    u8 verdict = node->verdict;
+
+    for (; !IS_ROOT(dentry); dentry = READ_ONCE(dentry->d_parent)) {
+        names[depth++ % PROXYFS_TRIE_DEPTH] = READ_ONCE(dentry->d_name.name);
+    }
+    //
+    // Component of depth `i` (1 is the nearest to the root) has been
+    // visited at step `depth - i`
+    for (i = 1; i <= min(depth, trie->max_depth); i++) {
+        if ((edge = proxyfs_trie_find(trie, node, names[(depth - i) % PROXYFS_TRIE_DEPTH])) == NULL) {
+            break;
+        }
+        node = &trie->nodes[edge->child];
+        if (node->verdict != PROXYFS_TRIE_NONE) {
+            verdict = node->verdict;
+        }
+    }
+    return verdict;
+}
@@ -13,6 +13,10 @@
 #include <linux/errno.h>
 #include <linux/printk.h>
 #include <linux/dcache.h>
+#include <linux/jump_label.h>
+#include <linux/cleanup.h>
+#include <linux/ktime.h>
+#include <linux/percpu.h>
 #include <net/sock.h>
 
 // #include <linux/pagemap.h>
@@ -25,6 +29,7 @@
 // #include <linux/uaccess.h>
 
 #include "proxyfs-buffer-pool.h"
+#include "proxyfs-event.h"
 
 #define PROXYFS_MAGIC 0x20250710
 #define MODULE_NAME   "proxyfs"
@@ -33,18 +38,125 @@
 #define PROXYFS_PROCFS_UNIT_ID "unit_id"
 #define PROXYFS_PROCFS_FILTERS "filters"
 #define PROXYFS_PROCFS_PIDS    "pids"
+#define PROXYFS_PROCFS_POOL    "pool"
+#define PROXYFS_PROCFS_BATCH   "batch"
+#define PROXYFS_PROCFS_QUEUE   "queue"
+#define PROXYFS_PROCFS_COALESCE "coalesce"
+#define PROXYFS_PROCFS_PERM    "perm"
+#define PROXYFS_PROCFS_MOUNTS  "mounts"
+#define PROXYFS_PROCFS_FLIGHT  "flight"
+#define PROXYFS_PROCFS_FLIGHT_SNAPSHOT "flight_snapshot"
+#define PROXYFS_PROCFS_SLOW    "slow"
+#define PROXYFS_PROCFS_TOP     "top"
 
 #define PROXYFS_NETLINK_USER    25
 
+//
+// NETLINK message type of a batched event, a batch is terminated by
+// `NLMSG_DONE` message
+#define PROXYFS_NLMSG_EVENT     (NLMSG_MIN_TYPE + 0)
+
+//
+// Default NETLINK batching parameters: latency bound and skb data size
+#define PROXYFS_SOCKET_BATCH_LATENCY_US 1000
+#define PROXYFS_SOCKET_BATCH_BYTES      (16 * 1024)
+#define PROXYFS_SOCKET_BATCH_BUCKETS    16
+
+//
+// Default backpressure parameters of a mount, sampling starts when the
+// queue usage (percents) reaches the watermark
+#define PROXYFS_BACKPRESSURE_TIMEOUT_US        1000
+#define PROXYFS_BACKPRESSURE_SAMPLE_RATE       10
+#define PROXYFS_BACKPRESSURE_SAMPLE_WATERMARK  50
+
+//
+// Default number of records of a per-CPU event queue and number of
+// events a worker sends before it yields the CPU
+#define PROXYFS_QUEUE_RECORDS 1024
+#define PROXYFS_QUEUE_BATCH   64
+
+//
+// Number of pending coalesced records of a CPU
+#define PROXYFS_COALESCE_SLOTS 4
+
+//
+// Default time (ms) a task waits for the verdict of its permission request
+// and number of the buckets (bits) of the pending requests table
+#define PROXYFS_PERM_TIMEOUT_MS 5000
+#define PROXYFS_PERM_HASH_BITS  6
+//
+// Default number of cached verdicts of the permission requests
+#define PROXYFS_PERM_CACHE_ENTRIES 4096
+
+//
+// Default number of calls recorded by the flight recorder of a CPU and
+// time (ms) of a call taking the snapshot of the recorders
+#define PROXYFS_FLIGHT_RECORDS 1024
+#define PROXYFS_FLIGHT_SLOW_MS 500
+
+//
+// Slow call detector: default threshold (ms), slow calls reported one
+// by one within a window (ms) before the rest are summarized, calls
+// waiting to be reported, reports kept and limits of a report
+#define PROXYFS_SLOW_THRESHOLD_MS 1000
+#define PROXYFS_SLOW_BURST        10
+#define PROXYFS_SLOW_WINDOW_MS    1000
+#define PROXYFS_SLOW_PENDING      32
+#define PROXYFS_SLOW_RECORDS      64
+#define PROXYFS_SLOW_PATH_LEN     256
+#define PROXYFS_SLOW_FSTYPE_LEN   16
+#define PROXYFS_SLOW_STACK_DEPTH  16
+
+//
+// Heavy hitters: default window (s), counters of a sketch, buckets of
+// its hash index (bits), entries shown and length of a name kept
+#define PROXYFS_TOP_WINDOW_S  10
+#define PROXYFS_TOP_SLOTS     64
+#define PROXYFS_TOP_HASH_BITS 6
+#define PROXYFS_TOP_N         10
+#define PROXYFS_TOP_NAME_LEN  32
+
+//
+// Number of token buckets of a rate limiting level of a CPU
+#define PROXYFS_RATELIMIT_SLOTS_BITS 6
+#define PROXYFS_RATELIMIT_SLOTS      (1U << PROXYFS_RATELIMIT_SLOTS_BITS)
+
+//
+// Maximal length of a command written to a procfs entry (a filter set
+// has to be written at once)
+#define PROXYFS_PROCFS_CMD_LEN (1024 * 1024)
+
+//
+// Limits of a filter set: number of rules, depth and length of a path
+// prefix, length of a name suffix and of the source of a rule
+#define PROXYFS_FILTER_RULES    64
+#define PROXYFS_FILTER_DEPTH    16
+#define PROXYFS_FILTER_PATH_LEN 128
+#define PROXYFS_FILTER_NAME_LEN 32
+#define PROXYFS_FILTER_TEXT_LEN 160
+
+//
+// Deepest path prefix of a subtree rule (components)
+#define PROXYFS_TRIE_DEPTH 32
+
+//
+// PID/TGID/cgroup set: buckets of the hash table (bits) and entries
+#define PROXYFS_PIDS_HASH_BITS 8
+#define PROXYFS_PIDS_MAX       1024
+
+//
+// Latency histograms of the operations: number of the log2 buckets and
+// the bound (bits, ns) of the first one, i.e. bucket `i > 0` counts the
+// calls taken [2^(i+6), 2^(i+7)) ns
+#define PROXYFS_STATS_BUCKETS 24
+#define PROXYFS_STATS_SHIFT   7
+
 #define QSTR_FMT "%.*s"
 #define QSTR_ARG(s) ((s) ? (s)->len : 0), ((s) ? (char *)(s)->name : "")
 
 #define INODE_FMT "%lu"
 #define INODE_ARG(i) ((i) ? (i)->i_ino : 0)
 
-#define PROXYFS_DEBUG(fmt, ...) \
-  pr_info("%s: %s: " fmt, MODULE_NAME, __func__, ##__VA_ARGS__)
-
 #define PROXYFS_WARNING(fmt, ...) \
   pr_warning("%s: %s: " fmt, MODULE_NAME, __func__, ##__VA_ARGS__)
 
@@ -55,13 +167,120 @@ static inline const char *proxyfs_dentry_name(const struct dentry *dentry) {
     return dentry ? (const char*)dentry->d_name.name : "?";
 }
 
+struct proxyfs_socket_config {
+    //
+    // Pack events to multipart messages instead of sending them one by one
+    bool batch;
+    unsigned int batch_latency_us;
+    unsigned int batch_bytes;
+};
+
+struct proxyfs_ring_config {
+    //
+    // Number of records (0 disables the ring) and size of a record slot
+    unsigned int records;
+    unsigned int record_size;
+    //
+    // Events are not sent over NETLINK while the consumer is attached
+    // (but the permission requests, they are answered over NETLINK)
+    bool exclusive;
+};
+
+struct proxyfs_queue_config {
+    //
+    // Number of records of every per-CPU queue (0 disables the queues,
+    // events are sent by the handlers synchronously)
+    unsigned int records;
+};
+
+struct proxyfs_coalesce_config {
+    //
+    // Time window (us) repeated reads and writes of a file are merged
+    // within (0 disables the coalescing)
+    unsigned int window_us;
+};
+
+struct proxyfs_perm_config {
+    //
+    // Time (ms) a task waits for the verdict of the client and the
+    // verdict applied if there is no answer
+    unsigned int timeout_ms;
+    bool default_deny;
+    //
+    // Number of the verdicts cached (0 disables the cache)
+    unsigned int cache_entries;
+};
+
+struct proxyfs_flight_config {
+    //
+    // Number of the calls recorded by every CPU (0 disables the flight
+    // recorder), time (ms) of a call taking the snapshot (0 to never
+    // take it) and if a failing call takes it
+    unsigned int records;
+    unsigned int slow_ms;
+    bool errors;
+};
+
+struct proxyfs_slow_config {
+    //
+    // Time (ms) a call of any operation is reported as slow after (0
+    // disables the detector), number of slow calls reported one by one
+    // within a window (the rest are summarized) and if the stack of the
+    // slow call is recorded
+    unsigned int threshold_ms;
+    unsigned int burst;
+    bool stack;
+};
+
+struct proxyfs_top_config {
+    //
+    // Length (s) of a window the heavy hitters are counted within (0
+    // disables the tracker)
+    unsigned int window_s;
+};
+
+struct proxyfs_context_config {
+    struct proxyfs_buffer_pool_config pool;
+    struct proxyfs_socket_config socket;
+    struct proxyfs_ring_config ring;
+    struct proxyfs_queue_config queue;
+    struct proxyfs_coalesce_config coalesce;
+    struct proxyfs_perm_config perm;
+    struct proxyfs_flight_config flight;
+    struct proxyfs_slow_config slow;
+    struct proxyfs_top_config top;
+};
+
+//
+// Client registered to receive the events by unicast, the descriptor is
+// published by RCU (SRCU) thus senders don't look the client process up
+struct proxyfs_client {
+    //
+    // NETLINK port of the client socket and the process registered it
+    u32 portid;
+    struct pid *pid;
+    //
+    // Negotiated options: bit mask of the event classes to be received
+    u32 classes;
+    atomic_long_t sent;
+    atomic_long_t dropped;
+    //
+    // Classic BPF program the events are filtered by (NULL if there is
+    // none) and the number of events it has accepted and rejected
+    struct bpf_prog *prog;
+    atomic_long_t accepted;
+    atomic_long_t rejected;
+    struct rcu_head rcu;
+};
+
 struct proxyfs_context_data {
     //
     // NETLINK socket (communication with a userspace process (client)
     struct sock* nl_socket;
     //
-    // Userspace client PID
-    atomic_t client_pid;
+    // Userspace client registered to receive the events by unicast
+    struct proxyfs_client __rcu *client;
+    spinlock_t client_lock;
     //
     // Procfs directory with module specific entries
     struct proc_dir_entry* proc_dir;
@@ -79,6 +298,12 @@ struct proxyfs_context_data {
 struct proxyfs_inode {
     struct inode vfs_inode;
     struct inode *lower_inode;
+    //
+    // Verdicts of the permission requests cached (see `proxyfs_perm_request()`)
+    struct hlist_head perm_cache;
+    //
+    // Filter verdicts cached (see `proxyfs_filter_check()`)
+    atomic64_t filter_cache;
 };
 
 // Get inode of underlying FS from proxyfs inode
@@ -104,8 +329,161 @@ inline static struct file *proxyfs_lower_file(const struct file *file)
     return NULL;
 }
 
+//
+// Behaviour of a mount when the event pipeline is saturated
+enum proxyfs_backpressure_policy {
+    PROXYFS_BACKPRESSURE_DROP_NEWEST,
+    PROXYFS_BACKPRESSURE_DROP_OLDEST,
+    PROXYFS_BACKPRESSURE_BLOCK,
+    PROXYFS_BACKPRESSURE_SAMPLE,
+    PROXYFS_BACKPRESSURE_POLICY_COUNT
+};
+
+//
+// Reason of an event to be dropped
+enum proxyfs_drop_reason {
+    PROXYFS_DROP_POOL,
+    PROXYFS_DROP_QUEUE,
+    PROXYFS_DROP_TIMEOUT,
+    PROXYFS_DROP_SAMPLED,
+    PROXYFS_DROP_REASON_COUNT
+};
+
+struct proxyfs_backpressure {
+    enum proxyfs_backpressure_policy policy;
+    //
+    // Longest time an event handler waits for room (`block` policy)
+    //
+    // Note: buffers come back as the workers drain the queues, thus if
+    //       the queues are disabled the exhausted pool drops the event
+    //       at once (as `drop_newest` policy does)
+    unsigned int timeout_us;
+    //
+    // Every `sample_rate`-th event passes when saturated (`sample` policy)
+    unsigned int sample_rate;
+    atomic_t sample_counter;
+    atomic_long_t drops[PROXYFS_DROP_REASON_COUNT];
+    //
+    // Events dropped since the last "lost" marker has been sent
+    atomic_long_t lost;
+};
+
+//
+// Operations of the file, inode, address space and super block tables
+// timed per mount: X(NAME, name)
+//
+// Note: `check_flags()` is not bound to a mount and `free_inode()` may run
+//       (RCU callback) after the mount is gone, thus both are not timed
+#define PROXYFS_STATS_OPS(X)                          \
+    X(FILE_LLSEEK, file_llseek)                       \
+    X(FILE_READ, file_read)                           \
+    X(FILE_WRITE, file_write)                         \
+    X(FILE_READ_ITER, file_read_iter)                 \
+    X(FILE_WRITE_ITER, file_write_iter)               \
+    X(FILE_IOPOLL, file_iopoll)                       \
+    X(FILE_ITERATE_SHARED, file_iterate_shared)       \
+    X(FILE_POLL, file_poll)                           \
+    X(FILE_UNLOCKED_IOCTL, file_unlocked_ioctl)       \
+    X(FILE_COMPAT_IOCTL, file_compat_ioctl)           \
+    X(FILE_MMAP, file_mmap)                           \
+    X(FILE_OPEN, file_open)                           \
+    X(FILE_FLUSH, file_flush)                         \
+    X(FILE_RELEASE, file_release)                     \
+    X(FILE_FSYNC, file_fsync)                         \
+    X(FILE_FASYNC, file_fasync)                       \
+    X(FILE_LOCK, file_lock)                           \
+    X(FILE_GET_UNMAPPED_AREA, file_get_unmapped_area) \
+    X(FILE_FLOCK, file_flock)                         \
+    X(FILE_SPLICE_WRITE, file_splice_write)           \
+    X(FILE_SPLICE_READ, file_splice_read)             \
+    X(FILE_SPLICE_EOF, file_splice_eof)               \
+    X(FILE_SETLEASE, file_setlease)                   \
+    X(FILE_FALLOCATE, file_fallocate)                 \
+    X(FILE_SHOW_FDINFO, file_show_fdinfo)             \
+    X(FILE_MMAP_CAPABILITIES, file_mmap_capabilities) \
+    X(FILE_COPY_FILE_RANGE, file_copy_file_range)     \
+    X(FILE_REMAP_FILE_RANGE, file_remap_file_range)   \
+    X(FILE_FADVISE, file_fadvise)                     \
+    X(FILE_URING_CMD, file_uring_cmd)                 \
+    X(FILE_URING_CMD_IOPOLL, file_uring_cmd_iopoll)   \
+    X(INODE_LOOKUP, inode_lookup)                     \
+    X(INODE_GET_LINK, inode_get_link)                 \
+    X(INODE_PERMISSION, inode_permission)             \
+    X(INODE_GET_INODE_ACL, inode_get_inode_acl)       \
+    X(INODE_READLINK, inode_readlink)                 \
+    X(INODE_CREATE, inode_create)                     \
+    X(INODE_LINK, inode_link)                         \
+    X(INODE_UNLINK, inode_unlink)                     \
+    X(INODE_SYMLINK, inode_symlink)                   \
+    X(INODE_MKDIR, inode_mkdir)                       \
+    X(INODE_RMDIR, inode_rmdir)                       \
+    X(INODE_MKNOD, inode_mknod)                       \
+    X(INODE_RENAME, inode_rename)                     \
+    X(INODE_SETATTR, inode_setattr)                   \
+    X(INODE_GETATTR, inode_getattr)                   \
+    X(INODE_LISTXATTR, inode_listxattr)               \
+    X(INODE_FIEMAP, inode_fiemap)                     \
+    X(INODE_UPDATE_TIME, inode_update_time)           \
+    X(INODE_ATOMIC_OPEN, inode_atomic_open)           \
+    X(INODE_TMPFILE, inode_tmpfile)                   \
+    X(INODE_GET_ACL, inode_get_acl)                   \
+    X(INODE_SET_ACL, inode_set_acl)                   \
+    X(INODE_FILEATTR_SET, inode_fileattr_set)         \
+    X(INODE_FILEATTR_GET, inode_fileattr_get)         \
+    X(INODE_GET_OFFSET_CTX, inode_get_offset_ctx)     \
+    X(MAPPING_WRITEPAGE, mapping_writepage)           \
+    X(MAPPING_READ_FOLIO, mapping_read_folio)         \
+    X(MAPPING_WRITEPAGES, mapping_writepages)         \
+    X(MAPPING_DIRTY_FOLIO, mapping_dirty_folio)       \
+    X(MAPPING_READAHEAD, mapping_readahead)           \
+    X(MAPPING_WRITE_BEGIN, mapping_write_begin)       \
+    X(MAPPING_WRITE_END, mapping_write_end)           \
+    X(MAPPING_BMAP, mapping_bmap)                     \
+    X(MAPPING_DIRECT_IO, mapping_direct_io)           \
+    X(SUPER_ALLOC_INODE, super_alloc_inode)           \
+    X(SUPER_DESTROY_INODE, super_destroy_inode)       \
+    X(SUPER_DIRTY_INODE, super_dirty_inode)           \
+    X(SUPER_WRITE_INODE, super_write_inode)           \
+    X(SUPER_DROP_INODE, super_drop_inode)             \
+    X(SUPER_EVICT_INODE, super_evict_inode)           \
+    X(SUPER_PUT_SUPER, super_put_super)               \
+    X(SUPER_SYNC_FS, super_sync_fs)                   \
+    X(SUPER_FREEZE_SUPER, super_freeze_super)         \
+    X(SUPER_FREEZE_FS, super_freeze_fs)               \
+    X(SUPER_THAW_SUPER, super_thaw_super)             \
+    X(SUPER_UNFREEZE_FS, super_unfreeze_fs)           \
+    X(SUPER_STATFS, super_statfs)                     \
+    X(SUPER_REMOUNT_FS, super_remount_fs)             \
+    X(SUPER_UMOUNT_BEGIN, super_umount_begin)         \
+    X(SUPER_SHOW_OPTIONS, super_show_options)         \
+    X(SUPER_SHOW_DEVNAME, super_show_devname)         \
+    X(SUPER_SHOW_PATH, super_show_path)               \
+    X(SUPER_SHOW_STATS, super_show_stats)             \
+    X(SUPER_QUOTA_READ, super_quota_read)             \
+    X(SUPER_QUOTA_WRITE, super_quota_write)           \
+    X(SUPER_GET_DQUOTS, super_get_dquots)             \
+    X(SUPER_NR_CACHED_OBJECTS, super_nr_cached_objects) \
+    X(SUPER_FREE_CACHED_OBJECTS, super_free_cached_objects) \
+    X(SUPER_SHUTDOWN, super_shutdown)
+
+#define PROXYFS_STATS_OP_ENUM(NAME, name) PROXYFS_STATS_OP_##NAME,
+enum proxyfs_stats_op {
+    PROXYFS_STATS_OPS(PROXYFS_STATS_OP_ENUM)
+    PROXYFS_STATS_OP_COUNT
+};
+#undef PROXYFS_STATS_OP_ENUM
+
+//
+// Per-CPU counters and histograms of the operations of a mount
+struct proxyfs_stats;
+
 struct proxyfs_sb_info {
     struct super_block *lower_sb;
+    struct proxyfs_backpressure backpressure;
+    struct proxyfs_stats __percpu *stats;
+    //
+    // Procfs entry of the mount (see `proxyfs_procfs_mount_create()`)
+    struct proc_dir_entry *proc_entry;
 };
 
 // Get super block of underlying FS from proxyfs super block
@@ -118,6 +496,26 @@ inline static struct super_block *proxyfs_lower_sb(const struct super_block *sb)
     return NULL;
 }
 
+// Get backpressure policy of proxyfs super block (mount)
+inline static struct proxyfs_backpressure *proxyfs_sb_backpressure(const struct super_block *sb)
+{
+    if (sb != NULL &&
+        sb->s_fs_info != NULL) {
+        return &((struct proxyfs_sb_info *)sb->s_fs_info)->backpressure;
+    }
+    return NULL;
+}
+
+// Get operation statistics of proxyfs super block (mount)
+inline static struct proxyfs_stats __percpu *proxyfs_sb_stats(const struct super_block *sb)
+{
+    if (sb != NULL &&
+        sb->s_fs_info != NULL) {
+        return ((struct proxyfs_sb_info *)sb->s_fs_info)->stats;
+    }
+    return NULL;
+}
+
 struct proxyfs_dentry_info {
     struct dentry *lower_dentry;
     struct vfsmount *lower_mnt;
@@ -169,32 +567,398 @@ inline static struct address_space *proxyfs_lower_mapping(struct address_space *
 
 //
 // Module context specific routines
-int proxyfs_context_set_client_pid(const int new_client_pid);
-int proxyfs_context_get_client_pid(void);
+int proxyfs_context_init(const struct proxyfs_context_config *config);
+void proxyfs_context_release(void);
+int proxyfs_context_register_client(u32 portid,
+                                    u32 classes,
+                                    struct bpf_prog *prog);
+bool proxyfs_context_unregister_client(u32 portid);
+int proxyfs_context_client_read_lock(void);
+void proxyfs_context_client_read_unlock(int idx);
+struct proxyfs_client *proxyfs_context_get_client(void);
 bool proxyfs_context_check_uid(const int uid);
 bool proxyfs_context_check_is_running(void);
 void proxyfs_context_handler_counter_increment(void);
 void proxyfs_context_handler_counter_decrement(void);
 struct sock* proxyfs_context_get_nl_socket(void);
+struct proxyfs_buffer_pool* proxyfs_context_get_buffer_pool(void);
+void proxyfs_context_send_msg(const char* msg_body,
+                              size_t msg_len,
+                              unsigned int group);
+bool proxyfs_context_has_consumer(unsigned int group);
 
 //
 // Buffer pool specific routines
-void* proxyfs_context_buffer_pool_alloc(struct proxyfs_context_data *context_data);
+void* proxyfs_context_buffer_pool_alloc(struct proxyfs_context_data *context_data,
+                                        size_t size);
 bool proxyfs_context_buffer_pool_free(struct proxyfs_context_data *context_data,
                                       void* buffer);
 unsigned int proxyfs_context_buffer_pool_get_buffer_size(struct proxyfs_context_data *context_data);
 
 //
 // NETLINK communication specific routines
-struct sock* proxyfs_socket_init(const int nl_unit_id);
+struct sock* proxyfs_socket_init(const int nl_unit_id,
+                                 const struct proxyfs_socket_config *config);
 void proxyfs_socket_release(struct sock* nl_socket);
 void proxyfs_socket_send_msg(const char* msg_body,
-                             size_t msg_len);
+                             size_t msg_len,
+                             unsigned int group);
+bool proxyfs_socket_has_listeners(unsigned int group);
+void proxyfs_socket_flush(void);
+void proxyfs_socket_show_stats(struct seq_file *m);
+
+//
+// Shared memory ring specific routines
+int proxyfs_ring_init(const struct proxyfs_ring_config *config);
+void proxyfs_ring_release(void);
+bool proxyfs_ring_write(const char* msg_body,
+                        size_t msg_len);
+bool proxyfs_ring_is_attached(void);
+bool proxyfs_ring_is_exclusive(void);
+
+//
+// Per-CPU event queue specific routines
+int proxyfs_queue_init(const struct proxyfs_queue_config *config);
+void proxyfs_queue_release(void);
+int proxyfs_queue_push(void *buffer,
+                       size_t len,
+                       unsigned int group,
+                       struct proxyfs_backpressure *bp);
+bool proxyfs_queue_drop_oldest(void);
+bool proxyfs_queue_is_enabled(void);
+unsigned long proxyfs_queue_generation(void);
+long proxyfs_queue_wait(unsigned long generation,
+                        long timeout);
+unsigned int proxyfs_queue_pressure(void);
+void proxyfs_queue_show_stats(struct seq_file *m);
+
+//
+// Backpressure specific routines
+void proxyfs_backpressure_init(struct proxyfs_backpressure *bp);
+int proxyfs_backpressure_parse_policy(const char *name);
+bool proxyfs_backpressure_admit(struct proxyfs_backpressure *bp);
+void proxyfs_backpressure_drop(struct proxyfs_backpressure *bp,
+                               enum proxyfs_drop_reason reason);
+void proxyfs_backpressure_show_options(struct seq_file *m,
+                                       const struct proxyfs_backpressure *bp);
+void proxyfs_backpressure_show_stats(struct seq_file *m,
+                                     const struct proxyfs_backpressure *bp);
+
+//
+// Event specific routines: values of the event attributes, fields are
+// named after the attributes (see `PROXYFS_EVENT_ATTRS()`)
+struct proxyfs_event_args {
+    struct inode *inode;
+    struct dentry *path;
+    struct dentry *new_path;
+    u64 offset;
+    u64 length;
+    u32 flags;
+    u64 lost;
+    u64 bytes;
+    u32 calls;
+    //
+    // Issuer and time of the operation reported on behalf of another
+    // task (e.g. a coalesced record), the current task if `pid` is 0
+    pid_t pid;
+    pid_t tgid;
+    uid_t uid;
+    u64 timestamp;
+    //
+    // Identifier of the permission request the client answers by
+    u64 request;
+    //
+    // Slow call: operation, type of the lower FS and duration (ns)
+    const char *operation;
+    const char *fstype;
+    u64 latency;
+};
+
+int proxyfs_event_init(void);
+void proxyfs_event_release(void);
+enum proxyfs_event_class proxyfs_event_op_class(unsigned int op);
+void proxyfs_event_emit(enum proxyfs_event_op op,
+                        const struct proxyfs_event_args *args);
+void proxyfs_event_deliver(enum proxyfs_event_op op,
+                           const struct proxyfs_event_args *args);
+bool proxyfs_event_request(enum proxyfs_event_op op,
+                           const struct proxyfs_event_args *args);
+bool proxyfs_event_notify(enum proxyfs_event_op op,
+                          const struct proxyfs_event_args *args);
+
+//
+// Levels of the rate limiting, an event has to fit the budgets of all
+// the enabled levels
+enum proxyfs_ratelimit_level {
+    PROXYFS_RATELIMIT_MOUNT,
+    PROXYFS_RATELIMIT_UID,
+    PROXYFS_RATELIMIT_PID,
+    PROXYFS_RATELIMIT_INODE,
+    PROXYFS_RATELIMIT_LEVEL_COUNT
+};
+
+//
+// Verdicts of the path prefix trie
+#define PROXYFS_TRIE_NONE    0
+#define PROXYFS_TRIE_EXCLUDE 1
+#define PROXYFS_TRIE_INCLUDE 2
+
+struct proxyfs_trie;
+struct proxyfs_trie_build_node;
+
+struct proxyfs_trie_builder {
+    struct proxyfs_trie_build_node *root;
+    u32 count;
+    u32 node_count;
+    u32 pool_size;
+    u32 max_depth;
+};
+
+//
+// Path prefix trie specific routines
+int proxyfs_trie_builder_init(struct proxyfs_trie_builder *builder);
+int proxyfs_trie_builder_add(struct proxyfs_trie_builder *builder,
+                             const char *path,
+                             u8 verdict);
+void proxyfs_trie_builder_destroy(struct proxyfs_trie_builder *builder);
+struct proxyfs_trie *proxyfs_trie_build(struct proxyfs_trie_builder *builder);
+void proxyfs_trie_free(struct proxyfs_trie *trie);
+u32 proxyfs_trie_size(const struct proxyfs_trie *trie);
+u8 proxyfs_trie_match(const struct proxyfs_trie *trie,
+                      struct dentry *dentry);
+
+//
+// Event filter specific routines
+bool proxyfs_filter_check(enum proxyfs_event_op op,
+                          const struct proxyfs_event_args *args);
+int proxyfs_filter_compile(char *text);
+bool proxyfs_filter_path_seq(struct dentry *dentry,
+                             u32 seed,
+                             u32 *seq);
+void proxyfs_filter_show(struct seq_file *m);
+void proxyfs_filter_release(void);
+
+//
+// Classic BPF event filter specific routines
+int proxyfs_bpf_create(struct bpf_prog **prog,
+                       const struct sock_filter *insns,
+                       unsigned int len);
+void proxyfs_bpf_destroy(struct bpf_prog *prog);
+bool proxyfs_bpf_filter(struct proxyfs_client *client,
+                        const char *msg_body,
+                        size_t msg_len);
+void proxyfs_bpf_release(void);
+
+//
+// PID/TGID/cgroup set specific routines
+DECLARE_STATIC_KEY_FALSE(proxyfs_pids_active);
+bool proxyfs_pids_check(void);
+int proxyfs_pids_configure(const char *line);
+void proxyfs_pids_show(struct seq_file *m);
+void proxyfs_pids_release(void);
+
+//
+// Check if the current task is monitored, the set is looked up only if
+// it is not empty
+inline static bool proxyfs_pids_is_monitored(void)
+{
+    return !static_branch_unlikely(&proxyfs_pids_active) || proxyfs_pids_check();
+}
+
+//
+// Rate limiting specific routines
+bool proxyfs_ratelimit_admit(const struct proxyfs_event_args *args);
+int proxyfs_ratelimit_configure(const char *line);
+void proxyfs_ratelimit_show_limits(struct seq_file *m);
+void proxyfs_ratelimit_show_buckets(struct seq_file *m);
+
+//
+// Permission request specific routines
+void proxyfs_perm_init(const struct proxyfs_perm_config *config);
+void proxyfs_perm_release(void);
+int proxyfs_perm_request(enum proxyfs_event_op op,
+                         const struct proxyfs_event_args *args);
+void proxyfs_perm_verdicts(u32 portid,
+                           const struct proxyfs_client_verdict *verdicts,
+                           u32 count);
+void proxyfs_perm_cancel(void);
+void proxyfs_perm_cache_invalidate(struct inode *inode);
+void proxyfs_perm_cache_flush(void);
+void proxyfs_perm_show_stats(struct seq_file *m);
+
+//
+// Event coalescing specific routines
+void proxyfs_coalesce_init(const struct proxyfs_coalesce_config *config);
+void proxyfs_coalesce_release(void);
+bool proxyfs_coalesce_event(enum proxyfs_event_op op,
+                            const struct proxyfs_event_args *args);
+void proxyfs_coalesce_flush_sb(struct super_block *sb);
+void proxyfs_coalesce_show_stats(struct seq_file *m);
+
+//
+// Operation statistics specific routines
+struct proxyfs_stats __percpu *proxyfs_stats_alloc(void);
+void proxyfs_stats_free(struct proxyfs_stats __percpu *stats);
+void proxyfs_stats_reset(struct proxyfs_stats __percpu *stats);
+void proxyfs_stats_show_summary(struct seq_file *m,
+                                struct proxyfs_stats __percpu *stats);
+void proxyfs_stats_show(struct seq_file *m,
+                        struct proxyfs_stats __percpu *stats);
+const char *proxyfs_stats_op_name(enum proxyfs_stats_op op);
+int proxyfs_stats_op_find(const char *name);
+
+//
+// Timer of a call of an operation: the time spent in the lower FS calls
+// is accumulated separately from the whole call, arguments and result of
+// the call are kept for its tracepoint (see `proxyfs-trace.h`)
+//
+// Note: `dentry` is the one the call has been made on (if any), it is
+//       referenced by the caller till the handler returns
+struct proxyfs_stats_timer {
+    struct proxyfs_stats __percpu *stats;
+    enum proxyfs_stats_op op;
+    u64 start;
+    u64 lower_ns;
+    const struct super_block *sb;
+    struct dentry *dentry;
+    dev_t dev;
+    u64 ino;
+    u64 offset;
+    u64 count;
+    u32 flags;
+    long ret;
+};
+
+void proxyfs_stats_end(const struct proxyfs_stats_timer *timer);
+
+//
+// Tracepoints of the operations specific routines
+DECLARE_STATIC_KEY_FALSE(proxyfs_trace_ops_active);
+int proxyfs_trace_op_reg(void);
+void proxyfs_trace_op_unreg(void);
+void proxyfs_trace_op(const struct proxyfs_stats_timer *timer,
+                      u64 latency_ns);
+
+//
+// Flight recorder specific routines
+int proxyfs_flight_init(const struct proxyfs_flight_config *config);
+void proxyfs_flight_release(void);
+void proxyfs_flight_record(const struct proxyfs_stats_timer *timer,
+                           u64 latency_ns);
+int proxyfs_flight_snapshot_take(void);
+void proxyfs_flight_snapshot_clear(void);
+void proxyfs_flight_show(struct seq_file *m);
+void proxyfs_flight_show_snapshot(struct seq_file *m);
+
+//
+// Slow call detector specific routines
+void proxyfs_slow_init(const struct proxyfs_slow_config *config);
+void proxyfs_slow_release(void);
+void proxyfs_slow_check(const struct proxyfs_stats_timer *timer,
+                        u64 latency_ns);
+void proxyfs_slow_flush(void);
+int proxyfs_slow_configure(const char *line);
+void proxyfs_slow_show(struct seq_file *m);
+
+//
+// Heavy hitters specific routines
+int proxyfs_top_init(const struct proxyfs_top_config *config);
+void proxyfs_top_release(void);
+void proxyfs_top_account(const struct dentry *dentry,
+                         const struct inode *inode,
+                         size_t bytes);
+void proxyfs_top_show(struct seq_file *m);
+
+inline static struct proxyfs_stats_timer proxyfs_stats_begin(const struct super_block *sb,
+                                                             enum proxyfs_stats_op op)
+{
+    return (struct proxyfs_stats_timer) {
+        .stats = proxyfs_sb_stats(sb),
+        .op = op,
+        .start = ktime_get_ns(),
+        .sb = sb,
+        .dev = sb ? sb->s_dev : 0,
+    };
+}
+
+DEFINE_CLASS(proxyfs_stats,
+             struct proxyfs_stats_timer,
+             proxyfs_stats_end(&_T),
+             proxyfs_stats_begin(sb, op),
+             const struct super_block *sb, enum proxyfs_stats_op op)
+
+//
+// Time the handler of operation `NAME` of the mount till it returns, the
+// lower FS calls are wrapped by `PROXYFS_STATS_LOWER[_PTR|_VOID]()` there
+//
+// Note: calls of a mount being set up (or of no mount) are not counted
+#define PROXYFS_STATS(sb, NAME) \
+    CLASS(proxyfs_stats, proxyfs_stats_timer)((sb), PROXYFS_STATS_OP_##NAME)
+
+//
+// Arguments of the call reported by its tracepoint
+#define PROXYFS_STATS_ARGS(inode, off, cnt, flg)                               \
+    do {                                                                       \
+        proxyfs_stats_timer.ino = INODE_ARG(inode);                            \
+        proxyfs_stats_timer.offset = (off);                                    \
+        proxyfs_stats_timer.count = (cnt);                                     \
+        proxyfs_stats_timer.flags = (flg);                                     \
+    } while (false)
+
+//
+// Dentry the call is made on, its path is reported if the call is slow
+#define PROXYFS_STATS_PATH(d) (proxyfs_stats_timer.dentry = (d))
+
+#define PROXYFS_STATS_LOWER(call)                                              \
+    ({                                                                         \
+        u64 __lower_start = ktime_get_ns();                                    \
+        typeof(call) __lower_res = (call);                                     \
+        proxyfs_stats_timer.lower_ns += ktime_get_ns() - __lower_start;        \
+        proxyfs_stats_timer.ret = (__force long)__lower_res;                   \
+        __lower_res;                                                           \
+    })
+
+//
+// Lower FS call returning a pointer, only an error is reported as result
+#define PROXYFS_STATS_LOWER_PTR(call)                                          \
+    ({                                                                         \
+        u64 __lower_start = ktime_get_ns();                                    \
+        typeof(call) __lower_res = (call);                                     \
+        proxyfs_stats_timer.lower_ns += ktime_get_ns() - __lower_start;        \
+        proxyfs_stats_timer.ret = PTR_ERR_OR_ZERO(__lower_res);                \
+        __lower_res;                                                           \
+    })
+
+#define PROXYFS_STATS_LOWER_VOID(call)                                         \
+    do {                                                                       \
+        u64 __lower_start = ktime_get_ns();                                    \
+        (call);                                                                \
+        proxyfs_stats_timer.lower_ns += ktime_get_ns() - __lower_start;        \
+    } while (false)
+
+//
+// `proxyfs_event_<op>()` routine for every operation
+//
+// Note: events of the excluded tasks are dropped in the handler itself,
+//       just like the ones nobody is listening to. That is the only
+//       thing skipped for them (see proxyfs-pids.c)
+#define PROXYFS_EVENT_EMITTER(NAME, name, CLASS, attrs)                          \
+inline static void proxyfs_event_##name(const struct proxyfs_event_args *args) \
+{                                                                                \
+    if (!proxyfs_pids_is_monitored()) {                                          \
+        return;                                                                  \
+    }                                                                            \
+    proxyfs_event_emit(PROXYFS_EVENT_OP_##NAME, args);                           \
+}
+PROXYFS_EVENT_OPS(PROXYFS_EVENT_EMITTER)
+#undef PROXYFS_EVENT_EMITTER
 
 //
 // Procfs specific routines
 struct proc_dir_entry* proxyfs_procfs_setup(void);
 void proxyfs_procfs_release(void);
+void proxyfs_procfs_mount_create(struct super_block *sb);
+void proxyfs_procfs_mount_remove(struct super_block *sb);
 
 extern const struct file_operations proxyfs_file_ops;
 extern const struct inode_operations proxyfs_inode_ops;
@@ -0,0 +1,70 @@
+#!/bin/sh
+# File		:tests/filter-cache.sh
+#
+# Repeated events of a file are decided by the verdict cached by its inode
+# (see `proxyfs_filter_check()`), the verdict is dropped once the file is
+# renamed
+#
+# Usage: tests/filter-cache.sh [<path to proxyfs.ko>] (as root)
+set -eu
+
+KO=${1:-./proxyfs.ko}
+FILTERS=/proc/proxyfs/filters
+LOWER=$(mktemp -d)
+MNT=$(mktemp -d)
+LISTENER=
+
+cleanup() {
+    [ -n "$LISTENER" ] && kill "$LISTENER" 2>/dev/null
+    umount "$MNT" 2>/dev/null
+    rmmod proxyfs 2>/dev/null
+    rm -rf "$LOWER" "$MNT"
+}
+trap cleanup EXIT
+
+fail() {
+    echo "FAIL: $*"
+    cat "$FILTERS"
+    exit 1
+}
+
+# Evaluations (the default action decides them) and cached verdicts
+evaluated() { awk '$3 == "default" { print $2 }' "$FILTERS"; }
+cached() { awk '$3 == "cached" { print $2 }' "$FILTERS"; }
+
+insmod "$KO"
+mount -t proxyfs -o "lowerdir=$LOWER" none "$MNT"
+echo data > "$LOWER/file"
+
+# Events are checked only if somebody receives them: join the multicast
+# group of FILE class (group 1)
+python3 -c '
+import socket, time
+s = socket.socket(socket.AF_NETLINK, socket.SOCK_RAW, 25)
+s.bind((0, 1))
+time.sleep(3600)
+' &
+LISTENER=$!
+sleep 1
+
+printf 'exclude suffix=.tmp\n' > "$FILTERS"
+
+# Open and release events of the first read are evaluated and cached
+cat "$MNT/file" > /dev/null
+evaluated_before=$(evaluated)
+cached_before=$(cached)
+for i in 1 2 3; do
+    cat "$MNT/file" > /dev/null
+done
+[ "$(evaluated)" -eq "$evaluated_before" ] ||
+    fail "repeated events of the file are evaluated again"
+[ "$(cached)" -ge $((cached_before + 6)) ] ||
+    fail "repeated events of the file miss the cache"
+
+# The verdicts cached for the old path are not used for the new one
+mv "$MNT/file" "$MNT/renamed"
+cat "$MNT/renamed" > /dev/null
+[ "$(evaluated)" -gt "$evaluated_before" ] ||
+    fail "verdict cached for the old path is used after the rename"
+
+echo "PASS"